@@ -15,7 +15,10 @@
 #ifndef __BIPARTITEGRAPHEDITDISTANCE_H__
 #define __BIPARTITEGRAPHEDITDISTANCE_H__
 
-#include "hungarian-lsape.hh"
+#include <vector>
+#include "LSAPESolver.h"
+#include "SparseLSAPE.h"
+#include "PointDistanceCost.h"
 #include "GraphEditDistance.h"
 #include "utils.h"
 //TODO : donner la possibilité de récupérer le mapping ?
@@ -25,10 +28,38 @@ class BipartiteGraphEditDistance:
 {
 protected:
   double * C;
+  LSAPESolver _lsapeSolver;
+  LSAPECandidates _candidates;  //!< substitutions kept in the LSAPE
+  double _candidatesParam;      //!< number of candidates per node, or largest node cost of a candidate
 
 protected:
   virtual void computeCostMatrix(Graph<NodeAttribute,EdgeAttribute> * g1,
 				 Graph<NodeAttribute,EdgeAttribute> * g2);
+
+  /**
+   * @brief Release the cost matrix of the previous pair and allocate a \f$(n+1)\times(m+1)\f$ one.
+   *        Every computeCostMatrix starts with it.
+   */
+  double * allocateCostMatrix(int n, int m){
+    delete [] C;
+    C = new double[(n+1) * (m+1)];
+    return C;
+  }
+
+  /**
+   * @brief Compute the costs of the candidate substitutions only, see \ref candidates
+   */
+  virtual void computeSparseCostMatrix(Graph<NodeAttribute,EdgeAttribute> * g1,
+				       Graph<NodeAttribute,EdgeAttribute> * g2,
+				       SparseCostMatrix<double> & S);
+
+  /**
+   * @brief Restrict the dense cost matrix of computeCostMatrix to the candidates, for the
+   *        methods whose costs are only computed for all the pairs at once
+   */
+  void sparseFromDense(Graph<NodeAttribute,EdgeAttribute> * g1,
+		       Graph<NodeAttribute,EdgeAttribute> * g2,
+		       SparseCostMatrix<double> & S);
          
   double SubstitutionCost(GNode<NodeAttribute,EdgeAttribute> * v1,
 			  GNode<NodeAttribute,EdgeAttribute> * v2,
@@ -44,9 +75,39 @@ protected:
 public:
   BipartiteGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction):
     GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
-    C(NULL)
+    C(NULL), _lsapeSolver(LSAPE_HUNGARIAN), _candidates(CANDIDATES_ALL), _candidatesParam(0)
+  {};
+
+  /**
+   * @brief The cost matrix of the last pair is not shared between copies
+   */
+  BipartiteGraphEditDistance(const BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute> & other):
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(other.cf),
+    C(NULL), _lsapeSolver(other._lsapeSolver),
+    _candidates(other._candidates), _candidatesParam(other._candidatesParam)
   {};
 
+  /**
+   * @brief  Select the solver of the LSAPE, \ref LSAPE_HUNGARIAN by default
+   */
+  void lsapeSolver(LSAPESolver solver){
+    this->_lsapeSolver = solver;
+  }
+
+  /**
+   * @brief  Restrict the substitutions to candidates, \ref CANDIDATES_ALL by default
+   *
+   *   With \ref CANDIDATES_TOP, each node of g1 keeps the param substitutions of lowest cost.
+   *   With \ref CANDIDATES_COMPATIBLE, the substitutions whose node cost is at most param, and
+   *   with \ref CANDIDATES_USEFUL the ones cheaper than a deletion and an insertion (searched in a
+   *   KD-tree for a \ref PointDistanceCost); only their costs are computed. The LSAPE is then solved by \ref sparseLSAPE, whatever the
+   *   solver, and the \f$(n+1)\times(m+1)\f$ matrix is never built.
+   */
+  void candidates(LSAPECandidates mode, double param = 0){
+    this->_candidates = mode;
+    this->_candidatesParam = param;
+  }
+
   // virtual double operator()(Graph<NodeAttribute,EdgeAttribute> * g1,
   // 			    Graph<NodeAttribute,EdgeAttribute> * g2);
 
@@ -79,8 +140,13 @@ getOptimalMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
 		  int * G1_to_G2,int * G2_to_G1){
   int n=g1->Size();
   int m=g2->Size();
-  // Compute C
-  delete [] this->C;
+  if (this->_candidates != CANDIDATES_ALL){
+    SparseCostMatrix<double> S;
+    computeSparseCostMatrix(g1,g2,S);
+    sparseLSAPE(S, G1_to_G2, G2_to_G1);
+    return;
+  }
+  // Compute C (the previous one is released by computeCostMatrix)
   computeCostMatrix(g1,g2);
   // for (int i=0;i<n+1;i++){
   //   for (int j=0;j<m+1;j++)
@@ -90,7 +156,7 @@ getOptimalMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
   //Compute optimal assignement
   double *u = new double[n+1];
   double *v = new double[m+1];
-  hungarianLSAPE(C,n+1,m+1, G1_to_G2,G2_to_G1, u,v,false);
+  solveLSAPE(this->_lsapeSolver, C, n+1, m+1, G1_to_G2, G2_to_G1, u, v);
   delete [] u;
   delete [] v;
 
@@ -164,7 +230,10 @@ SubstitutionCost(GNode<NodeAttribute,EdgeAttribute> * v1,
 
   GEdge<EdgeAttribute> * e2 = _e2; //We keep a copy of e2 to start again an iteration
 
-  double * local_C = new double[(n+1) * (m+1)];
+  // Small stars are solved on the stack by tinyLSAPEBatch
+  bool tiny = (n <= TINY_LSAPE_MAX && m <= TINY_LSAPE_MAX);
+  double tiny_C[(TINY_LSAPE_MAX+1)*(TINY_LSAPE_MAX+1)];
+  double * local_C = tiny ? tiny_C : new double[(n+1) * (m+1)];
   memset(local_C,0,sizeof(double)*(n+1) * (m+1));
   for (int i=0;e1;i++){
     e2 = _e2; 
@@ -189,11 +258,17 @@ SubstitutionCost(GNode<NodeAttribute,EdgeAttribute> * v1,
     e2 = e2->Next();
   }
   local_C[sub2ind(n,m,n+1)] = 0;
+  if (tiny){
+    double cost;
+    double work[2 << TINY_LSAPE_MAX];
+    tinyLSAPEBatch(local_C, n, m, 1, &cost, work);
+    return cost + this->cf->NodeSubstitutionCost(v1,v2,g1,g2);
+  }
   int *rho = new int[n];
   int *varrho = new int[m];
   double *u = new double[n+1];
   double *v = new double[m+1];
-  hungarianLSAPE(local_C,n+1,m+1, rho,varrho, u,v,false);
+  solveLSAPE(this->_lsapeSolver, local_C, n+1, m+1, rho, varrho, u, v);
   double cost=0.0;
   for (int i =0;i<n+1;i++)
     cost += u[i];
@@ -236,14 +311,67 @@ void BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute>::
 computeCostMatrix(Graph<NodeAttribute,EdgeAttribute> * g1,
 		  Graph<NodeAttribute,EdgeAttribute> * g2){
 
-  delete [] C;
-
   int n=g1->Size();
   int m=g2->Size();
-  C = new double[(n+1) * (m+1)];
-  for (int i =0;i<n;i++)
+  this->allocateCostMatrix(n, m);
+
+  // Nodes of g2 with small stars, by degree : the substitutions of a node of g1 with the nodes
+  // of g2 of a given degree are solved in one batch
+  std::vector<std::vector<int> > byDegree(TINY_LSAPE_MAX+1);
+  int maxBatch = 0;
+  for(int j = 0;j<m;j++){
+    int d = (*g2)[j]->Degree();
+    if (d <= TINY_LSAPE_MAX){
+      byDegree[d].push_back(j);
+      maxBatch = std::max(maxBatch, (int)byDegree[d].size());
+    }
+  }
+  const int tinySize = (TINY_LSAPE_MAX+1)*(TINY_LSAPE_MAX+1);
+  double * batch_C = new double[tinySize*maxBatch];
+  double * batch_cost = new double[maxBatch];
+  double * work = new double[(2 << TINY_LSAPE_MAX)*maxBatch];
+  GEdge<EdgeAttribute> * edges1[TINY_LSAPE_MAX];
+
+  for (int i =0;i<n;i++){
+    GNode<NodeAttribute,EdgeAttribute> * v1 = (*g1)[i];
+    int n1 = v1->Degree();
+    if (n1 > TINY_LSAPE_MAX){
+      for(int j = 0;j<m;j++)
+	C[sub2ind(i,j,n+1)] = this->SubstitutionCost(v1,(*g2)[j],g1,g2);
+      continue;
+    }
+    GEdge<EdgeAttribute> * e1 = v1->getIncidentEdges();
+    for (int k=0;k<n1;k++, e1 = e1->Next())
+      edges1[k] = e1;
+
+    for (int m2=0;m2<=TINY_LSAPE_MAX;m2++){
+      const std::vector<int> & nodes = byDegree[m2];
+      int P = nodes.size();
+      if (P == 0) continue;
+      // Entry (k,l) of the star of (i, nodes[p]) is at sub2ind(k,l,n1+1)*P + p
+      for (int p=0;p<P;p++){
+	GEdge<EdgeAttribute> * e2 = (*g2)[nodes[p]]->getIncidentEdges();
+	for (int l=0;l<m2;l++, e2 = e2->Next()){
+	  for (int k=0;k<n1;k++)
+	    batch_C[sub2ind(k,l,n1+1)*P + p] = this->cf->EdgeSubstitutionCost(edges1[k],e2,g1,g2);
+	  batch_C[sub2ind(n1,l,n1+1)*P + p] = this->cf->EdgeInsertionCost(e2,g2);
+	}
+	for (int k=0;k<n1;k++)
+	  batch_C[sub2ind(k,m2,n1+1)*P + p] = this->cf->EdgeDeletionCost(edges1[k],g1);
+	batch_C[sub2ind(n1,m2,n1+1)*P + p] = 0;
+      }
+      tinyLSAPEBatch(batch_C, n1, m2, P, batch_cost, work);
+      for (int p=0;p<P;p++)
+	C[sub2ind(i,nodes[p],n+1)] = batch_cost[p] + this->cf->NodeSubstitutionCost(v1,(*g2)[nodes[p]],g1,g2);
+    }
+
     for(int j = 0;j<m;j++)
-      C[sub2ind(i,j,n+1)] = this->SubstitutionCost((*g1)[i],(*g2)[j],g1,g2);
+      if ((*g2)[j]->Degree() > TINY_LSAPE_MAX)
+	C[sub2ind(i,j,n+1)] = this->SubstitutionCost(v1,(*g2)[j],g1,g2);
+  }
+  delete [] batch_C;
+  delete [] batch_cost;
+  delete [] work;
   
   for (int i =0;i<n;i++)
     C[sub2ind(i,m,n+1)] = this->DeletionCost((*g1)[i],g1);
@@ -253,4 +381,64 @@ computeCostMatrix(Graph<NodeAttribute,EdgeAttribute> * g1,
 
   C[sub2ind(n,m,n+1)] = 0;
 }
+template<class NodeAttribute, class EdgeAttribute>
+void BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute>::
+computeSparseCostMatrix(Graph<NodeAttribute,EdgeAttribute> * g1,
+			Graph<NodeAttribute,EdgeAttribute> * g2,
+			SparseCostMatrix<double> & S){
+  int n=g1->Size();
+  int m=g2->Size();
+
+  S.del.resize(n);
+  S.ins.resize(m);
+  for (int i =0;i<n;i++)
+    S.del[i] = this->DeletionCost((*g1)[i],g1);
+  for (int j =0;j<m;j++)
+    S.ins[j] = this->InsertionCost((*g2)[j],g2);
+
+  if (this->_candidates == CANDIDATES_TOP){
+    // Ranked on the whole substitution costs, which are kept
+    selectCandidates<double>(n, m, [&](int i, int j){
+	return this->SubstitutionCost((*g1)[i],(*g2)[j],g1,g2); },
+      this->_candidates, this->_candidatesParam, S);
+    return;
+  }
+  if (this->_candidates == CANDIDATES_USEFUL)
+    usefulCandidates(g1, g2, this->cf, S);
+  else
+    selectCandidates<double>(n, m, [&](int i, int j){
+	return this->cf->NodeSubstitutionCost((*g1)[i],(*g2)[j],g1,g2); },
+      this->_candidates, this->_candidatesParam, S);
+  for (int i =0;i<n;i++)
+    for (int p=S.ptr[i];p<S.ptr[i+1];p++)
+      S.cost[p] = this->SubstitutionCost((*g1)[i],(*g2)[S.col[p]],g1,g2);
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+void BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute>::
+sparseFromDense(Graph<NodeAttribute,EdgeAttribute> * g1,
+		Graph<NodeAttribute,EdgeAttribute> * g2,
+		SparseCostMatrix<double> & S){
+  int n=g1->Size();
+  int m=g2->Size();
+  computeCostMatrix(g1,g2);
+  if (this->_candidates == CANDIDATES_USEFUL){
+    S.del.resize(n);
+    S.ins.resize(m);
+    for (int i =0;i<n;i++) S.del[i] = C[sub2ind(i,m,n+1)];
+    for (int j =0;j<m;j++) S.ins[j] = C[sub2ind(n,j,n+1)];
+    usefulCandidates(g1, g2, this->cf, S);
+  }
+  else if (this->_candidates == CANDIDATES_TOP)
+    selectCandidates<double>(n, m, [&](int i, int j){ return C[sub2ind(i,j,n+1)]; },
+			     this->_candidates, this->_candidatesParam, S);
+  else
+    selectCandidates<double>(n, m, [&](int i, int j){
+	return this->cf->NodeSubstitutionCost((*g1)[i],(*g2)[j],g1,g2); },
+      this->_candidates, this->_candidatesParam, S);
+  S.gather(C);
+  delete [] C; C = NULL;
+}
+
 #endif // __BIPARTITEGRAPHEDITDISTANCE_H__
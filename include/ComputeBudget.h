@@ -0,0 +1,55 @@
+/**
+ * @file ComputeBudget.h
+ * @version     0.0.1
+ *
+ * Time budget and cancellation of a computation, checked by the iterations of the solvers.
+ */
+
+#ifndef __COMPUTEBUDGET_H__
+#define __COMPUTEBUDGET_H__
+
+#include <atomic>
+#include <cstddef>
+#include <sys/time.h>
+
+
+/**
+ * @brief Deadline and cancellation flag shared by the solvers working on a job
+ *
+ *   An iterative solver given a budget (see <code>GraphEditDistance::setBudget</code>) stops its
+ *   iterations as soon as the budget is exhausted and returns the mapping of its current iterate,
+ *   so the result is still the cost of a valid mapping. The flag can be set from any thread.
+ */
+class ComputeBudget
+{
+protected:
+
+  std::atomic<bool> _cancelled;
+  double _deadline;   //!< wall clock time of the end of the budget, 0 if none
+
+public:
+
+  /**
+   * @param seconds  time allowed from now, unlimited if not positive
+   */
+  ComputeBudget(double seconds = 0): _cancelled(false), _deadline(seconds > 0 ? clock() + seconds : 0) {}
+
+  void cancel(){ _cancelled = true; }
+
+  bool cancelled() const { return _cancelled; }
+
+  bool expired() const { return _deadline > 0 && clock() >= _deadline; }
+
+  bool exhausted() const { return cancelled() || expired(); }
+
+  /**
+   * @brief Wall clock time in seconds
+   */
+  static double clock(){
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + (double)tv.tv_usec / 1000000;
+  }
+};
+
+#endif // __COMPUTEBUDGET_H__
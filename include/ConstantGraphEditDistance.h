@@ -56,4 +56,37 @@ public:
 
 };
 
+
+/**
+ * @brief Number of edit operations of each kind of a mapping, substitutions being only counted
+ *        between different labels
+ *
+ *   The GED of the mapping under a <code>ConstantEditDistanceCost</code> is the dot product of the
+ *   counts with (cns,cni,cnd,ces,cei,ced), so the distances of a whole grid of costs are obtained
+ *   from a single mapping computation.
+ */
+struct EditOperationCounts
+{
+  int ns, ni, nd, es, ei, ed;
+
+  EditOperationCounts(): ns(0), ni(0), nd(0), es(0), ei(0), ed(0) {}
+
+  /**
+   * @param c  the costs cns,cni,cnd,ces,cei,ced
+   */
+  double cost(const double * c) const {
+    return ns*c[0] + ni*c[1] + nd*c[2] + es*c[3] + ei*c[4] + ed*c[5];
+  }
+
+  double cost(ConstantEditDistanceCost * cf) const {
+    return ns*cf->cns() + ni*cf->cni() + nd*cf->cnd() + es*cf->ces() + ei*cf->cei() + ed*cf->ced();
+  }
+};
+
+/**
+ * @brief Edit operations of the mapping G1toG2 / G2toG1, as counted by <code>GraphEditDistance::GedFromMapping</code>
+ */
+EditOperationCounts countEditOperations(Graph<int,int> * g1, Graph<int,int> * g2,
+                                        int * G1toG2, int n, int * G2toG1, int m);
+
 #endif // __CONSTANTGRAPHEDITDISTANCE_H__
@@ -19,6 +19,8 @@
 #include "graph.h"
 #include "SymbolicGraph.h"
 #include "GraphEditDistance.h"
+#include "GraphIsomorphism.h"
+#include "DatasetCache.h"
 
 template <class NodeAttribute, class EdgeAttribute, class PropertyType>
 class Dataset
@@ -90,14 +92,18 @@ public:
    * Compute the graph edit distance according to a given algorithm between each pair of graphs included within dataset.
    * @param ed the <code>GraphEditDistance</code> used to compute the ged
    * @param quiet if TRUE, prints the pair of graphs currently processed while execution.
+   * @param isomorphisms if TRUE, only the rows and columns of one graph per isomorphism class are computed,
+   *        the other ones are copied, and isomorphic graphs are at distance 0
    * @return the distance matrix of size N*N computed according to ed
    */
-  double * computeGraphEditDistance(GraphEditDistance<NodeAttribute,EdgeAttribute> * ed, bool quiet = true) const;
+  double * computeGraphEditDistance(GraphEditDistance<NodeAttribute,EdgeAttribute> * ed, bool quiet = true,
+                                    bool isomorphisms = false) const;
 
   /**
    * Apply shuffleization procedure on all graphs composing the dataset.
+   * Graph i is shuffled by the stream i of the seed, so the result does not depend on the order.
    */
-  void shuffleize();
+  void shuffleize(uint64_t seed = 123);
 
 
   /**
@@ -113,20 +119,34 @@ public:
 
 
 template<class NodeAttribute,class EdgeAttribute, class PropertyType>
-void Dataset<NodeAttribute,EdgeAttribute,PropertyType>::shuffleize(){
+void Dataset<NodeAttribute,EdgeAttribute,PropertyType>::shuffleize(uint64_t seed){
   int N = size();
+  #ifdef _OPENMP
+  #pragma omp parallel for
+  #endif
   for (int i=0;i<N;i++)
-    (*this)[i]->shuffleize();
+    (*this)[i]->shuffleize(seed, i);
 }
 
 template<class NodeAttribute,class EdgeAttribute, class PropertyType>
-double * Dataset<NodeAttribute,EdgeAttribute,PropertyType>::computeGraphEditDistance(GraphEditDistance<NodeAttribute,EdgeAttribute> * ed, bool quiet) const{
+double * Dataset<NodeAttribute,EdgeAttribute,PropertyType>::computeGraphEditDistance(GraphEditDistance<NodeAttribute,EdgeAttribute> * ed, bool quiet,
+                                                                                     bool isomorphisms) const{
   int N = size();
   double * distances = new double[size()*size()];
+  std::vector<int> rep(N);
+  for (int i=0;i<N;i++) rep[i] = i;
+  if (isomorphisms)
+    rep = GraphIsomorphism<NodeAttribute,EdgeAttribute>(ed->getCostFunction()).representatives(graphs);
+  // rep[i] <= i, so the entry copied is always already computed
   for (int i=0;i<N;i++)
     for (int j=0;j<N;j++)
       {
-      distances[sub2ind(i,j,N)] = (*ed)(graphs[i],graphs[j]);
+      if (isomorphisms && rep[i] == rep[j])
+        distances[sub2ind(i,j,N)] = 0;
+      else if (rep[i] != i || rep[j] != j)
+        distances[sub2ind(i,j,N)] = distances[sub2ind(rep[i],rep[j],N)];
+      else
+        distances[sub2ind(i,j,N)] = (*ed)(graphs[i],graphs[j]);
       if(!quiet)
 	std::cout << i << "," << j << '\r';
       }
@@ -142,19 +162,48 @@ template<class PropertyType>
 class ChemicalDataset: public Dataset<int,int,PropertyType>
 {
 private:
-  void loadDS(const char * filename);
+  void loadDS(const char * filename, bool cache);
 public:
-  ChemicalDataset(const char * filename);
+  /**
+   * @param cache if TRUE, the parsed graphs are kept in the sidecar file filename.cache, which is
+   *        loaded instead of the sources while the dataset file and the graph files are unchanged
+   */
+  ChemicalDataset(const char * filename, bool cache = false);
   ChemicalDataset(): Dataset<int,int,PropertyType>(){}
 };
   
 template<class PropertyType>
-void ChemicalDataset<PropertyType>::loadDS(const char* filename){
+void ChemicalDataset<PropertyType>::loadDS(const char* filename, bool cache){
   
   std::ifstream f_tmp (filename);
   char * unconst_filename = new char[strlen(filename)+1];
   unconst_filename = strcpy(unconst_filename, filename);
   char * path = dirname(unconst_filename);
+  uint64_t stamp = 0;
+  std::string cacheFile = std::string(filename) + ".cache";
+  if (cache && f_tmp.is_open()){
+    std::vector<std::string> files;
+    std::string s;
+    while (getline(f_tmp, s))
+      if (s[0] != '#'){
+	std::istringstream liness(s);
+	std::string ctfile;
+	liness >> ctfile;
+	files.push_back(std::string(path) + "/" + ctfile);
+      }
+    f_tmp.clear();
+    f_tmp.seekg(0);
+    stamp = datasetSourcesStamp(filename, files);
+    std::vector<Graph<int,int>*> graphs;
+    std::vector<PropertyType> properties;
+    if (loadDatasetCache<SymbolicGraph>(cacheFile, stamp, graphs, properties)){
+      for (unsigned int i=0; i<graphs.size(); i++)
+	this->add(graphs[i], properties[i]);
+      f_tmp.close();
+      delete[] unconst_filename;
+      return;
+    }
+  }
   if (f_tmp.is_open()){
     std::string s;
     while (getline(f_tmp, s))
@@ -173,15 +222,25 @@ void ChemicalDataset<PropertyType>::loadDS(const char* filename){
       }
   }
   f_tmp.close();
+  if (cache){
+    std::vector<Graph<int,int>*> graphs;
+    std::vector<PropertyType> properties;
+    for (int i=0; i<this->size(); i++){
+      graphs.push_back((*this)[i]);
+      properties.push_back((*this)(i));
+    }
+    if (!saveDatasetCache(cacheFile, stamp, graphs, properties))
+      std::cerr << "Unable to write " << cacheFile << std::endl;
+  }
 
   delete[] unconst_filename;
   
 }
 template<class PropertyType>
-ChemicalDataset<PropertyType>::ChemicalDataset(const char * filename){
+ChemicalDataset<PropertyType>::ChemicalDataset(const char * filename, bool cache){
   const char * ext = strrchr(filename,'.'); 
   if (strcmp(ext,".ds") == 0){
-    loadDS(filename);
+    loadDS(filename, cache);
   }
 }
 
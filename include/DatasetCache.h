@@ -0,0 +1,222 @@
+/**
+ * @file DatasetCache.h
+ * @version     0.0.1
+ *
+ * Sidecar cache of parsed datasets : the graphs and properties are written in a binary file next
+ * to the dataset, and the later runs load it by a memory mapping instead of parsing the sources.
+ */
+
+#ifndef __DATASETCACHE_H__
+#define __DATASETCACHE_H__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "graph.h"
+
+/** Version of the format of the sidecar files : change it when the format or the parsers change */
+#define DATASET_CACHE_VERSION 1
+
+
+inline uint64_t datasetCacheMix(uint64_t h, uint64_t x){
+  h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+/**
+ * @brief Stamp of the sources of a dataset : the content of the dataset file, and the path, size
+ *        and modification time of each file it refers to
+ *
+ *   The files of the graphs are not read, so that a valid cache is checked without touching them.
+ */
+inline uint64_t datasetSourcesStamp(const std::string & datasetFile, const std::vector<std::string> & files){
+  uint64_t h = datasetCacheMix(0, DATASET_CACHE_VERSION);
+  std::ifstream in(datasetFile.c_str(), std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  std::string s = content.str();
+  for (unsigned int k=0; k<s.size(); k++) h = datasetCacheMix(h, (unsigned char)s[k]);
+  for (unsigned int f=0; f<files.size(); f++){
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    stat(files[f].c_str(), &st);
+    for (unsigned int k=0; k<files[f].size(); k++) h = datasetCacheMix(h, (unsigned char)files[f][k]);
+    h = datasetCacheMix(h, st.st_size);
+    h = datasetCacheMix(h, st.st_mtim.tv_sec);
+    h = datasetCacheMix(h, st.st_mtim.tv_nsec);
+  }
+  return h;
+}
+
+
+/**
+ * @brief Write the graphs and properties in the sidecar file path, stamped by stamp
+ *
+ *   The attributes and properties are written as bytes, so they must not hold pointers. The edges
+ *   are written as the calls to <code>Graph::Link</code> which rebuild them in the same order, with
+ *   the same identifiers. The file is written under a temporary name and renamed, so concurrent
+ *   readers only see complete files.
+ * @return false if the file could not be written
+ */
+template<class NodeAttribute, class EdgeAttribute, class PropertyType>
+bool saveDatasetCache(const std::string & path, uint64_t stamp,
+                      const std::vector<Graph<NodeAttribute,EdgeAttribute>*> & graphs,
+                      const std::vector<PropertyType> & properties)
+{
+  std::vector<char> buffer;
+  struct Writer {
+    std::vector<char> & b;
+    Writer(std::vector<char> & b): b(b) {}
+    void put(const void * data, size_t size){ b.insert(b.end(), (const char*)data, (const char*)data + size); }
+    void pad(){ while (b.size() % 8) b.push_back(0); }
+  } w(buffer);
+
+  const uint64_t magic = 0x3143534444444547ULL; // "GEDDSC1"
+  const uint32_t version = DATASET_CACHE_VERSION;
+  const uint32_t sizes[3] = { sizeof(NodeAttribute), sizeof(EdgeAttribute), sizeof(PropertyType) };
+  const uint64_t N = graphs.size();
+  w.put(&magic, 8); w.put(&version, 4); w.put(sizes, 12); w.put(&stamp, 8); w.put(&N, 8);
+
+  for (unsigned int g=0; g<graphs.size(); g++){
+    Graph<NodeAttribute,EdgeAttribute> * G = graphs[g];
+    // (id, from, to) of every edge, replayed by increasing id
+    std::vector<std::pair<int, std::pair<int,int> > > edges;
+    std::vector<GEdge<EdgeAttribute>*> edgePtr;
+    for (int u=0; u<G->Size(); u++)
+      for (GEdge<EdgeAttribute> * p = (*G)[u]->getIncidentEdges(); p; p = p->Next()){
+        edges.push_back(std::make_pair(p->EdgeId(), std::make_pair(u, (int)edgePtr.size())));
+        edgePtr.push_back(p);
+      }
+    std::sort(edges.begin(), edges.end());
+    std::vector<int32_t> links; // from, to, index of the edge
+    std::map<std::pair<int,int>, int> pending; // undirected edges linked, whose symmetric is to skip
+    for (unsigned int t=0; t<edges.size(); t++){
+      int u = edges[t].second.first;
+      GEdge<EdgeAttribute> * p = edgePtr[edges[t].second.second];
+      int v = p->IncidentNode();
+      if (!G->isDirected()){
+        std::map<std::pair<int,int>, int>::iterator it = pending.find(std::make_pair(v, u));
+        if (it != pending.end() && it->second > 0){ it->second--; continue; }
+        pending[std::make_pair(u, v)]++;
+      }
+      links.push_back(u); links.push_back(v); links.push_back(edges[t].second.second);
+    }
+
+    const int32_t header[4] = { G->Size(), G->isDirected(), (int32_t)(links.size()/3), 0 };
+    w.put(header, 16);
+    w.put(&properties[g], sizeof(PropertyType)); w.pad();
+    for (int u=0; u<G->Size(); u++) w.put(&(*G)[u]->attr, sizeof(NodeAttribute));
+    w.pad();
+    for (unsigned int t=0; t<links.size(); t+=3){
+      w.put(&links[t], 8);
+      w.put(&edgePtr[links[t+2]]->attr, sizeof(EdgeAttribute));
+    }
+    w.pad();
+  }
+
+  std::stringstream tmp;
+  tmp << path << ".tmp" << getpid();
+  std::ofstream out(tmp.str().c_str(), std::ios::binary);
+  if (!out.is_open()) return false;
+  out.write(&buffer[0], buffer.size());
+  out.close();
+  if (!out || rename(tmp.str().c_str(), path.c_str()) != 0){
+    remove(tmp.str().c_str());
+    return false;
+  }
+  return true;
+}
+
+
+/**
+ * @brief Read the sidecar file path, if it has the stamp, into graphs of type GraphType built by
+ *        <code>GraphType(bool directed)</code>
+ * @return false, with graphs and properties unchanged, if the file is missing, stale or invalid
+ */
+template<class GraphType, class NodeAttribute, class EdgeAttribute, class PropertyType>
+bool loadDatasetCache(const std::string & path, uint64_t stamp,
+                      std::vector<Graph<NodeAttribute,EdgeAttribute>*> & graphs,
+                      std::vector<PropertyType> & properties)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 40){ close(fd); return false; }
+  const size_t size = st.st_size;
+  void * map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+  const char * data = (const char *)map;
+
+  size_t pos = 0;
+  bool valid = true;
+  // bounds checked read
+  struct Reader {
+    const char * data; size_t size; size_t & pos; bool & valid;
+    Reader(const char * d, size_t s, size_t & p, bool & v): data(d), size(s), pos(p), valid(v) {}
+    void get(void * x, size_t n){
+      if (!valid || pos + n > size){ valid = false; return; }
+      memcpy(x, data + pos, n); pos += n;
+    }
+    void pad(){ pos = (pos + 7) & ~(size_t)7; }
+  } r(data, size, pos, valid);
+
+  uint64_t magic, fileStamp, N;
+  uint32_t version, sizes[3];
+  r.get(&magic, 8); r.get(&version, 4); r.get(sizes, 12); r.get(&fileStamp, 8); r.get(&N, 8);
+  if (magic != 0x3143534444444547ULL || version != DATASET_CACHE_VERSION || fileStamp != stamp ||
+      sizes[0] != sizeof(NodeAttribute) || sizes[1] != sizeof(EdgeAttribute) || sizes[2] != sizeof(PropertyType)){
+    munmap(map, size);
+    return false;
+  }
+
+  std::vector<Graph<NodeAttribute,EdgeAttribute>*> loaded;
+  std::vector<PropertyType> loadedProperties;
+  for (uint64_t g=0; g<N && valid; g++){
+    int32_t header[4];
+    r.get(header, 16);
+    if (!valid || header[0] < 0 || header[2] < 0) { valid = false; break; }
+    PropertyType y;
+    r.get(&y, sizeof(PropertyType)); r.pad();
+    GraphType * G = new GraphType((bool)header[1]);
+    for (int u=0; u<header[0] && valid; u++){
+      NodeAttribute attr;
+      r.get(&attr, sizeof(NodeAttribute));
+      G->Add(new GNode<NodeAttribute,EdgeAttribute>(u, attr));
+    }
+    r.pad();
+    for (int t=0; t<header[2] && valid; t++){
+      int32_t uv[2];
+      EdgeAttribute attr;
+      r.get(uv, 8); r.get(&attr, sizeof(EdgeAttribute));
+      if (valid && (uv[0] < 0 || uv[0] >= header[0] || uv[1] < 0 || uv[1] >= header[0])) valid = false;
+      if (valid) G->Link(uv[0], uv[1], attr);
+    }
+    r.pad();
+    loaded.push_back(G);
+    loadedProperties.push_back(y);
+  }
+  munmap(map, size);
+
+  if (!valid){
+    for (unsigned int g=0; g<loaded.size(); g++) delete loaded[g];
+    return false;
+  }
+  graphs.insert(graphs.end(), loaded.begin(), loaded.end());
+  properties.insert(properties.end(), loadedProperties.begin(), loadedProperties.end());
+  return true;
+}
+
+#endif // __DATASETCACHE_H__
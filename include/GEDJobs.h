@@ -0,0 +1,304 @@
+/**
+ * @file GEDJobs.h
+ * @version     0.0.1
+ *
+ * Asynchronous edit distance jobs : pairs or batches of pairs are queued with a priority and a time
+ * budget, and their results are returned as futures which may be cancelled.
+ */
+
+#ifndef __GEDJOBS_H__
+#define __GEDJOBS_H__
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <stdint.h>
+#include "GraphEditDistance.h"
+#include "ComputeBudget.h"
+
+
+/**
+ * @brief Exception of the futures of the cancelled jobs
+ */
+class GEDJobCancelled : public std::exception
+{
+public:
+  virtual const char * what() const throw() { return "edit distance job cancelled"; }
+};
+
+
+/**
+ * @brief Handle of a job submitted to a \ref GEDJobQueue
+ *
+ *   <code>get()</code> waits for the result, and throws \ref GEDJobCancelled if the job has been
+ *   cancelled. The handles may be copied, all the copies refer to the same job.
+ */
+template<class Result>
+class GEDJob
+{
+protected:
+
+  std::shared_future<Result> _result;
+  std::shared_ptr<ComputeBudget> _budget;
+
+public:
+
+  GEDJob() {}
+
+  GEDJob(const std::shared_future<Result> & result, const std::shared_ptr<ComputeBudget> & budget):
+    _result(result), _budget(budget) {}
+
+  /**
+   * @brief Cancel the job : a queued job is never run, a running one stops at the next iteration
+   *        of its solver
+   */
+  void cancel(){ _budget->cancel(); }
+
+  bool ready() const { return _result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+  void wait() const { _result.wait(); }
+
+  Result get() const { return _result.get(); }
+
+  const std::shared_future<Result> & future() const { return _result; }
+
+  ComputeBudget * budget() const { return _budget.get(); }
+};
+
+
+/**
+ * @brief Queue of edit distance jobs served by a pool of threads
+ *
+ *   Each thread owns a clone of the method, made once by the constructor and reused by all the jobs
+ *   it runs, so the workspaces of the solvers are not reallocated from one job to another. The jobs
+ *   of highest priority are run first, in the order of submission for a same priority.
+ *
+ *   The budget of a job is given to the method of the thread running it (see
+ *   <code>GraphEditDistance::setBudget</code>) : when it expires, the iterations of the solver stop
+ *   and the job returns the cost of the mapping reached, an upper bound of the distance. A cancelled
+ *   job throws \ref GEDJobCancelled instead of returning a value.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class GEDJobQueue
+{
+public:
+
+  typedef Graph<NodeAttribute,EdgeAttribute> G;
+  typedef GraphEditDistance<NodeAttribute,EdgeAttribute> Method;
+
+protected:
+
+  struct Task {
+    int priority;
+    uint64_t order;
+    std::shared_ptr<ComputeBudget> budget;
+    std::function<void(Method*)> run;   //!< fulfils the promise of the job, with the method of the thread
+  };
+
+  struct TaskOrder {
+    bool operator()(const Task * a, const Task * b) const {
+      if (a->priority != b->priority) return a->priority < b->priority;
+      return a->order > b->order;
+    }
+  };
+
+  std::vector<Method*> _methods;      //!< clone of the method of each thread
+  std::vector<std::thread> _threads;
+  std::priority_queue<Task*, std::vector<Task*>, TaskOrder> _tasks;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  uint64_t _nbSubmitted;
+  bool _stop;
+
+  void worker(Method * ed);
+
+  void push(Task * task);
+
+  static void fail(std::promise<double> & p){
+    p.set_exception(std::make_exception_ptr(GEDJobCancelled()));
+  }
+
+  static void fail(std::promise<std::vector<double> > & p){
+    p.set_exception(std::make_exception_ptr(GEDJobCancelled()));
+  }
+
+public:
+
+  /**
+   * @param ed         the method, cloned by each thread
+   * @param nbThreads  number of threads, the number of cores if not positive
+   */
+  GEDJobQueue(Method * ed, int nbThreads = 0);
+
+  /**
+   * @brief Cancel the queued jobs, and wait for the running ones
+   */
+  ~GEDJobQueue();
+
+  /**
+   * @brief Queue the computation of the distance from g1 to g2
+   * @param priority  jobs of higher priority are run first
+   * @param seconds   time budget, counted from the submission, unlimited if not positive
+   */
+  GEDJob<double> submit(G * g1, G * g2, int priority = 0, double seconds = 0);
+
+  /**
+   * @brief Queue the computation of the distances of the pairs, run in order by one thread
+   *
+   *   The budget is shared by the whole batch : once expired, the remaining pairs only get the
+   *   distance of the initialization of the method.
+   */
+  GEDJob<std::vector<double> > submit(const std::vector<std::pair<G*,G*> > & pairs,
+                                      int priority = 0, double seconds = 0);
+
+  /**
+   * @brief Number of jobs waiting for a thread
+   */
+  int getNbQueued();
+
+  int getNbThreads() const { return _threads.size(); }
+};
+
+
+template<class NodeAttribute, class EdgeAttribute>
+GEDJobQueue<NodeAttribute, EdgeAttribute>::
+GEDJobQueue(Method * ed, int nbThreads):
+  _nbSubmitted(0),
+  _stop(false)
+{
+  if (nbThreads <= 0) nbThreads = std::max(1u, std::thread::hardware_concurrency());
+  // the clones are made before any thread uses them
+  for (int t=0; t<nbThreads; t++) _methods.push_back(ed->clone());
+  for (int t=0; t<nbThreads; t++)
+    _threads.push_back(std::thread(&GEDJobQueue::worker, this, _methods[t]));
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+GEDJobQueue<NodeAttribute, EdgeAttribute>::
+~GEDJobQueue()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _condition.notify_all();
+  for (unsigned int t=0; t<_threads.size(); t++) _threads[t].join();
+  // the jobs left are cancelled
+  while (!_tasks.empty()){
+    Task * task = _tasks.top();
+    _tasks.pop();
+    task->budget->cancel();
+    task->run(NULL);
+    delete task;
+  }
+  for (unsigned int t=0; t<_methods.size(); t++) delete _methods[t];
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+void GEDJobQueue<NodeAttribute, EdgeAttribute>::
+worker(Method * ed)
+{
+  while (true){
+    Task * task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]{ return _stop || !_tasks.empty(); });
+      if (_stop) return;
+      task = _tasks.top();
+      _tasks.pop();
+    }
+    ed->setBudget(task->budget.get());
+    task->run(ed);
+    ed->setBudget(NULL);
+    delete task;
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+void GEDJobQueue<NodeAttribute, EdgeAttribute>::
+push(Task * task)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    task->order = _nbSubmitted++;
+    _tasks.push(task);
+  }
+  _condition.notify_one();
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+GEDJob<double> GEDJobQueue<NodeAttribute, EdgeAttribute>::
+submit(G * g1, G * g2, int priority, double seconds)
+{
+  std::shared_ptr<ComputeBudget> budget(new ComputeBudget(seconds));
+  std::shared_ptr<std::promise<double> > promise(new std::promise<double>());
+  Task * task = new Task;
+  task->priority = priority;
+  task->budget = budget;
+  task->run = [g1, g2, budget, promise](Method * ed){
+    if (budget->cancelled()){ fail(*promise); return; }
+    try{
+      double d = (*ed)(g1, g2);
+      if (budget->cancelled()) fail(*promise);
+      else promise->set_value(d);
+    }
+    catch(...){
+      promise->set_exception(std::current_exception());
+    }
+  };
+  GEDJob<double> job(promise->get_future().share(), budget);
+  push(task);
+  return job;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+GEDJob<std::vector<double> > GEDJobQueue<NodeAttribute, EdgeAttribute>::
+submit(const std::vector<std::pair<G*,G*> > & pairs, int priority, double seconds)
+{
+  std::shared_ptr<ComputeBudget> budget(new ComputeBudget(seconds));
+  std::shared_ptr<std::promise<std::vector<double> > > promise(new std::promise<std::vector<double> >());
+  Task * task = new Task;
+  task->priority = priority;
+  task->budget = budget;
+  task->run = [pairs, budget, promise](Method * ed){
+    std::vector<double> d(pairs.size());
+    try{
+      for (unsigned int k=0; k<pairs.size(); k++){
+        if (budget->cancelled()){ fail(*promise); return; }
+        d[k] = (*ed)(pairs[k].first, pairs[k].second);
+      }
+      if (budget->cancelled()) fail(*promise);
+      else promise->set_value(d);
+    }
+    catch(...){
+      promise->set_exception(std::current_exception());
+    }
+  };
+  GEDJob<std::vector<double> > job(promise->get_future().share(), budget);
+  push(task);
+  return job;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+int GEDJobQueue<NodeAttribute, EdgeAttribute>::
+getNbQueued()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _tasks.size();
+}
+
+#endif // __GEDJOBS_H__
@@ -0,0 +1,404 @@
+/**
+ * @file GEDServer.h
+ * @version     0.0.1
+ *
+ * Long running server of edit distances : the datasets and the method are loaded once, and the
+ * distance, k-NN and range queries are answered over a Unix domain socket.
+ */
+
+#ifndef __GEDSERVER_H__
+#define __GEDSERVER_H__
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include "Dataset.h"
+#include "GraphEditDistance.h"
+#include "GEDJobs.h"
+
+
+/**
+ * @brief Requests of the protocol of \ref GEDServer
+ *
+ *   A request is a uint32 opcode followed by its arguments, an answer is an int32 status (0 if the
+ *   request is valid, 1 otherwise) followed by its results if the status is 0. All the values are
+ *   in the byte order of the host.
+ */
+enum GEDRequest {
+  GED_PING = 0,       //!< no argument, no result
+  GED_INFO = 1,       //!< no argument : uint32 number of datasets, then the uint32 size of each one
+  GED_DISTANCE = 2,   //!< uint32 dataset, uint32 i, uint32 j : double distance from graph i to graph j
+  GED_KNN = 3,        //!< uint32 dataset, uint32 i, uint32 k : uint32 count, then count (uint32 j, double distance), the nearest first
+  GED_RANGE = 4,      //!< uint32 dataset, uint32 i, double radius : same as GED_KNN, for the graphs within radius
+  GED_SHUTDOWN = 5    //!< no argument, no result : the server stops after the answer
+};
+
+
+/**
+ * @brief Read or write exactly size bytes on a socket, false if the connection is closed
+ */
+inline bool socketRead(int fd, void * data, size_t size){
+  char * p = (char *)data;
+  while (size > 0){
+    ssize_t r = recv(fd, p, size, 0);
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) return false;
+    p += r; size -= r;
+  }
+  return true;
+}
+
+inline bool socketWrite(int fd, const void * data, size_t size){
+  const char * p = (const char *)data;
+  while (size > 0){
+    ssize_t r = send(fd, p, size, MSG_NOSIGNAL);
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) return false;
+    p += r; size -= r;
+  }
+  return true;
+}
+
+
+/**
+ * @brief Server of the distances between the graphs of some datasets
+ *
+ *   The calling thread accepts the connections and polls them : the requests are read as they
+ *   arrive, and the ones computing distances are queued in a \ref GEDJobQueue, whose threads each
+ *   own a clone of the method. The answer is written once all the jobs of the request are done, so
+ *   a connection waits for its answer while the other clients are served. The k-NN and range
+ *   queries are split in one batch of pairs per thread of the queue, and the single distances are
+ *   queued before them. A query graph i is always the first graph of the distance : the k-NN and
+ *   range queries compute the distances from i to every other graph of its dataset, the graph itself
+ *   excluded.
+ */
+template<class NodeAttribute, class EdgeAttribute, class PropertyType>
+class GEDServer
+{
+protected:
+
+  typedef std::pair<double, uint32_t> Neighbour;
+  typedef Graph<NodeAttribute,EdgeAttribute> G;
+
+  /**
+   * @brief A connection, and the jobs of its request being computed
+   */
+  struct Connection {
+    int fd;
+    uint32_t opcode;
+    uint32_t k;
+    double radius;
+    std::vector<uint32_t> graphs;                   //!< second graph of each pair computed, batch by batch
+    std::vector<GEDJob<std::vector<double> > > jobs;
+    Connection(int fd): fd(fd), opcode(GED_PING), k(0), radius(0) {}
+    bool waiting() const { return !jobs.empty(); }
+  };
+
+  GraphEditDistance<NodeAttribute,EdgeAttribute> * _ed;
+  std::vector<Dataset<NodeAttribute,EdgeAttribute,PropertyType> *> _datasets;
+  std::string _path;
+  int _listen;
+
+  /**
+   * @brief Read the next request of c, answer it or queue its jobs
+   * @return false if the connection is to be closed
+   */
+  bool receive(Connection & c, GEDJobQueue<NodeAttribute,EdgeAttribute> & queue, bool & stop);
+
+  /**
+   * @brief Answer the request of c once its jobs are done
+   * @return false if the connection is to be closed
+   */
+  bool answer(Connection & c);
+
+  bool validGraph(uint32_t d, uint32_t i) const {
+    return d < _datasets.size() && (int)i < _datasets[d]->size();
+  }
+
+public:
+
+  /**
+   * @param ed    the method, cloned by each thread computing the distances
+   * @param path  the path of the socket, replaced if it exists
+   */
+  GEDServer( GraphEditDistance<NodeAttribute,EdgeAttribute> * ed, const std::string & path ):
+    _ed(ed), _path(path), _listen(-1)
+  {}
+
+  ~GEDServer(){
+    if (_listen >= 0){
+      close(_listen);
+      unlink(_path.c_str());
+    }
+  }
+
+  /**
+   * @brief Serve the graphs of dataset, whose index in the requests is returned
+   */
+  uint32_t addDataset(Dataset<NodeAttribute,EdgeAttribute,PropertyType> * dataset){
+    _datasets.push_back(dataset);
+    return _datasets.size() - 1;
+  }
+
+  /**
+   * @brief Answer the requests until a shutdown is requested
+   * @param nbThreads  number of threads computing the distances, the number of cores if 0
+   * @return false if the socket could not be created
+   */
+  bool run(int nbThreads = 0);
+};
+
+
+
+template<class NodeAttribute, class EdgeAttribute, class PropertyType>
+bool GEDServer<NodeAttribute, EdgeAttribute, PropertyType>::
+run(int nbThreads)
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (_path.size() >= sizeof(addr.sun_path)) return false;
+  strcpy(addr.sun_path, _path.c_str());
+  _listen = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (_listen < 0) return false;
+  unlink(_path.c_str());
+  if (bind(_listen, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(_listen, 64) != 0){
+    close(_listen); _listen = -1;
+    return false;
+  }
+
+  GEDJobQueue<NodeAttribute,EdgeAttribute> queue(_ed, nbThreads);
+  std::vector<Connection> connections;
+  std::vector<struct pollfd> fds;
+  bool stop = false;
+  while (!stop){
+    // the connections waiting for jobs are not polled, their next request is read after the answer
+    bool waiting = false;
+    fds.resize(connections.size() + 1);
+    fds[0].fd = _listen;
+    fds[0].events = POLLIN;
+    for (unsigned int c=0; c<connections.size(); c++){
+      fds[c+1].fd = connections[c].fd;
+      fds[c+1].events = connections[c].waiting() ? 0 : POLLIN;
+      waiting = waiting || connections[c].waiting();
+    }
+    // the jobs do not signal their end, so the pending ones are checked every millisecond
+    if (poll(&fds[0], fds.size(), waiting ? 1 : -1) < 0 && errno != EINTR) break;
+
+    std::vector<bool> closed(connections.size(), false);
+    for (unsigned int c=0; c<connections.size() && !stop; c++){
+      Connection & connection = connections[c];
+      if (connection.waiting())
+        closed[c] = !answer(connection);
+      else if (fds[c+1].events && fds[c+1].revents)
+        closed[c] = !receive(connection, queue, stop);
+    }
+    unsigned int kept = 0;
+    for (unsigned int c=0; c<connections.size(); c++)
+      if (closed[c]){
+        for (unsigned int b=0; b<connections[c].jobs.size(); b++) connections[c].jobs[b].cancel();
+        close(connections[c].fd);
+      }
+      else connections[kept++] = connections[c];
+    connections.resize(kept, Connection(-1));
+
+    if (!stop && (fds[0].revents & POLLIN)){
+      int fd = accept(_listen, NULL, NULL);
+      if (fd >= 0) connections.push_back(Connection(fd));
+    }
+  }
+  for (unsigned int c=0; c<connections.size(); c++){
+    for (unsigned int b=0; b<connections[c].jobs.size(); b++) connections[c].jobs[b].cancel();
+    close(connections[c].fd);
+  }
+  close(_listen); _listen = -1;
+  unlink(_path.c_str());
+  return true;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class PropertyType>
+bool GEDServer<NodeAttribute, EdgeAttribute, PropertyType>::
+receive(Connection & c, GEDJobQueue<NodeAttribute,EdgeAttribute> & queue, bool & stop)
+{
+  const int32_t ok = 0, invalid = 1;
+  // a request is read at once : its arguments follow the opcode in the same message
+  if (!socketRead(c.fd, &c.opcode, sizeof(c.opcode))) return false;
+  switch (c.opcode){
+  case GED_PING:
+    return socketWrite(c.fd, &ok, sizeof(ok));
+  case GED_INFO:{
+    uint32_t n = _datasets.size();
+    bool connected = socketWrite(c.fd, &ok, sizeof(ok)) && socketWrite(c.fd, &n, sizeof(n));
+    for (uint32_t d=0; d<n && connected; d++){
+      uint32_t size = _datasets[d]->size();
+      connected = socketWrite(c.fd, &size, sizeof(size));
+    }
+    return connected;
+  }
+  case GED_DISTANCE:{
+    uint32_t args[3];
+    if (!socketRead(c.fd, args, sizeof(args))) return false;
+    if (!validGraph(args[0], args[1]) || !validGraph(args[0], args[2]))
+      return socketWrite(c.fd, &invalid, sizeof(invalid));
+    Dataset<NodeAttribute,EdgeAttribute,PropertyType> & dataset = *_datasets[args[0]];
+    std::vector<std::pair<G*,G*> > pair(1, std::make_pair(dataset[args[1]], dataset[args[2]]));
+    c.graphs.assign(1, args[2]);
+    c.jobs.assign(1, queue.submit(pair, 1));
+    return true;
+  }
+  case GED_KNN:
+  case GED_RANGE:{
+    uint32_t args[2];
+    if (!socketRead(c.fd, args, sizeof(args))) return false;
+    if (!((c.opcode == GED_KNN) ? socketRead(c.fd, &c.k, sizeof(c.k)) : socketRead(c.fd, &c.radius, sizeof(c.radius))))
+      return false;
+    if (!validGraph(args[0], args[1]))
+      return socketWrite(c.fd, &invalid, sizeof(invalid));
+    Dataset<NodeAttribute,EdgeAttribute,PropertyType> & dataset = *_datasets[args[0]];
+    c.graphs.clear();
+    for (int j=0; j<dataset.size(); j++)
+      if (j != (int)args[1]) c.graphs.push_back(j);
+    if (c.graphs.empty()) return answer(c);
+    // one batch per thread, the batch b holding the graphs [b*N/B, (b+1)*N/B)
+    unsigned int N = c.graphs.size();
+    unsigned int B = std::min(N, (unsigned int)queue.getNbThreads());
+    c.jobs.clear();
+    for (unsigned int b=0; b<B; b++){
+      std::vector<std::pair<G*,G*> > pairs;
+      for (unsigned int t=b*N/B; t<(b+1)*N/B; t++)
+        pairs.push_back(std::make_pair(dataset[args[1]], dataset[c.graphs[t]]));
+      c.jobs.push_back(queue.submit(pairs));
+    }
+    return true;
+  }
+  case GED_SHUTDOWN:
+    stop = true;
+    socketWrite(c.fd, &ok, sizeof(ok));
+    return false;
+  default:
+    socketWrite(c.fd, &invalid, sizeof(invalid));
+    return false; // the arguments of an unknown request cannot be skipped
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class PropertyType>
+bool GEDServer<NodeAttribute, EdgeAttribute, PropertyType>::
+answer(Connection & c)
+{
+  const int32_t ok = 0, invalid = 1;
+  for (unsigned int b=0; b<c.jobs.size(); b++)
+    if (!c.jobs[b].ready()) return true;
+  std::vector<Neighbour> nb;
+  try{
+    for (unsigned int b=0; b<c.jobs.size(); b++){
+      std::vector<double> d = c.jobs[b].get();
+      for (unsigned int t=0; t<d.size(); t++)
+        nb.push_back(Neighbour(d[t], c.graphs[nb.size()]));
+    }
+  }
+  catch(...){
+    c.jobs.clear();
+    return socketWrite(c.fd, &invalid, sizeof(invalid));
+  }
+  c.jobs.clear();
+  if (c.opcode == GED_DISTANCE)
+    return socketWrite(c.fd, &ok, sizeof(ok)) && socketWrite(c.fd, &nb[0].first, sizeof(double));
+  std::sort(nb.begin(), nb.end());
+  uint32_t count = 0;
+  if (c.opcode == GED_KNN) count = std::min((uint32_t)nb.size(), c.k);
+  else while (count < nb.size() && nb[count].first <= c.radius) count++;
+  bool connected = socketWrite(c.fd, &ok, sizeof(ok)) && socketWrite(c.fd, &count, sizeof(count));
+  for (uint32_t t=0; t<count && connected; t++)
+    connected = socketWrite(c.fd, &nb[t].second, sizeof(uint32_t)) &&
+                socketWrite(c.fd, &nb[t].first, sizeof(double));
+  return connected;
+}
+
+
+
+
+/**
+ * @brief Client of a \ref GEDServer, the methods return false if the request failed
+ */
+class GEDClient
+{
+protected:
+
+  int _fd;
+
+  bool request(uint32_t opcode){
+    return _fd >= 0 && socketWrite(_fd, &opcode, sizeof(opcode));
+  }
+
+  bool status(){
+    int32_t s;
+    return socketRead(_fd, &s, sizeof(s)) && s == 0;
+  }
+
+  bool neighbours(std::vector<std::pair<uint32_t,double> > & result){
+    uint32_t count;
+    if (!status() || !socketRead(_fd, &count, sizeof(count))) return false;
+    result.resize(count);
+    for (uint32_t t=0; t<count; t++)
+      if (!socketRead(_fd, &result[t].first, sizeof(uint32_t)) || !socketRead(_fd, &result[t].second, sizeof(double)))
+        return false;
+    return true;
+  }
+
+public:
+
+  GEDClient(const std::string & path): _fd(-1) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return;
+    strcpy(addr.sun_path, path.c_str());
+    _fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_fd >= 0 && connect(_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0){
+      close(_fd); _fd = -1;
+    }
+  }
+
+  ~GEDClient(){ if (_fd >= 0) close(_fd); }
+
+  bool isConnected() const { return _fd >= 0; }
+
+  bool ping(){ return request(GED_PING) && status(); }
+
+  bool info(std::vector<uint32_t> & sizes){
+    uint32_t n;
+    if (!request(GED_INFO) || !status() || !socketRead(_fd, &n, sizeof(n))) return false;
+    sizes.resize(n);
+    return n == 0 || socketRead(_fd, &sizes[0], n*sizeof(uint32_t));
+  }
+
+  bool distance(uint32_t dataset, uint32_t i, uint32_t j, double & d){
+    uint32_t args[3] = { dataset, i, j };
+    return request(GED_DISTANCE) && socketWrite(_fd, args, sizeof(args)) && status() &&
+      socketRead(_fd, &d, sizeof(d));
+  }
+
+  bool knn(uint32_t dataset, uint32_t i, uint32_t k, std::vector<std::pair<uint32_t,double> > & result){
+    uint32_t args[3] = { dataset, i, k };
+    return request(GED_KNN) && socketWrite(_fd, args, sizeof(args)) && neighbours(result);
+  }
+
+  bool range(uint32_t dataset, uint32_t i, double radius, std::vector<std::pair<uint32_t,double> > & result){
+    uint32_t args[2] = { dataset, i };
+    return request(GED_RANGE) && socketWrite(_fd, args, sizeof(args)) &&
+      socketWrite(_fd, &radius, sizeof(radius)) && neighbours(result);
+  }
+
+  bool shutdownServer(){ return request(GED_SHUTDOWN) && status(); }
+};
+
+#endif // __GEDSERVER_H__
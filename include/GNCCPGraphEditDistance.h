@@ -19,30 +19,147 @@ using namespace Eigen;
 #include "IPFPZetaGraphEditDistance.h"
 #include "utils.h"
 
-template<class NodeAttribute, class EdgeAttribute>
+/**
+ * @tparam Real  type of the matrices of the IPFP sub solver, @see IPFPGraphEditDistance
+ */
+template<class NodeAttribute, class EdgeAttribute, class Real = double>
 class GNCCPGraphEditDistance:
   public GraphEditDistance<NodeAttribute, EdgeAttribute>{
 protected:
+  typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic> MatrixR; //!< matrices of the solver, in the working precision
   
   double _d = 0.1;
   double _zeta;
-  IPFPZetaGraphEditDistance<NodeAttribute,EdgeAttribute> * sub_algo;
+
+  // Adaptive continuation
+  bool _adaptive = false;
+  double _dMin = 0.01;     //!< smallest zeta step, no backtrack below it
+  double _dMax = 0.5;      //!< largest zeta step
+  double _smoothTol = 0.1;  //!< max change of an entry of Xk under which the step is doubled
+  double _jumpTol = 3.;    //!< growth of the objective decrease rate over which the step is backtracked
+  int _nbSteps;
+  int _nbInnerIterations;
+  std::vector<double> _zetas; //!< zeta of each step of the last call
+  IPFPTelemetry _telemetry;
+  IPFPZetaGraphEditDistance<NodeAttribute,EdgeAttribute, Real> * sub_algo;
   GraphEditDistance<NodeAttribute,EdgeAttribute> * _ed_init;
+  bool _cleanEdInit;   //!< Delete _ed_init in the destructor if true
+  std::vector<Real> _u, _v; //!< duals of the final projection, kept from one pair to another
+  std::vector<Real> _Xprev; //!< Xk before the last zeta step, for the backtracks of the adaptive schedule
 public:
   GNCCPGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction):
-    GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),_ed_init(0){};
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
+    _zeta(1),
+    _nbSteps(0), _nbInnerIterations(0),
+    sub_algo(new IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>(costFunction, 1)),
+    _ed_init(0), _cleanEdInit(false){
+    this->sub_algo->keepDualsAcrossCalls();
+  };
   GNCCPGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
 			 GraphEditDistance<NodeAttribute,EdgeAttribute> * ed_init):
-    GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),_ed_init(ed_init){};
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
+    _zeta(1),
+    _nbSteps(0), _nbInnerIterations(0),
+    sub_algo(new IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>(costFunction, 1)),
+    _ed_init(ed_init), _cleanEdInit(false){
+    this->sub_algo->keepDualsAcrossCalls();
+  };
+
+  /**
+   * @brief The sub solver, its workspace and the initialization method are not shared between copies
+   */
+  GNCCPGraphEditDistance(const GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute, Real> & other):
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(other.cf),
+    _d(other._d),
+    _zeta(1),
+    _adaptive(other._adaptive),
+    _dMin(other._dMin), _dMax(other._dMax),
+    _smoothTol(other._smoothTol), _jumpTol(other._jumpTol),
+    _nbSteps(0), _nbInnerIterations(0),
+    sub_algo(new IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>(other.cf, 1)),
+    _ed_init(other._ed_init ? other._ed_init->clone() : NULL),
+    _cleanEdInit(other._ed_init != NULL){
+    this->sub_algo->lsapeSolver(other.sub_algo->getLSAPESolver());
+    this->sub_algo->frankWolfeVariant(other.sub_algo->getFrankWolfeVariant());
+    this->sub_algo->candidates(other.sub_algo->getCandidates(), other.sub_algo->getCandidatesParam());
+    this->sub_algo->setSparseDensity(other.sub_algo->getSparseDensity());
+    this->sub_algo->keepDualsAcrossCalls();
+    this->setBudget(other._budget);
+  };
 
   virtual void getOptimalMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
 				 Graph<NodeAttribute,EdgeAttribute> * g2,
 				 int * G1_to_G2, int * G2_to_G1);
   
-  ~GNCCPGraphEditDistance(){}
+  /**
+   * @brief  Use an adaptive zeta schedule instead of the fixed decrement <code>_d</code>
+   *
+   *   The step is doubled (up to <code>_dMax</code>) when Xk barely moves between two zetas, and
+   *   the step is undone and halved (down to <code>_dMin</code>) when the objective jumps, i.e. when
+   *   its decrease per unit of zeta grows by more than <code>_jumpTol</code> w.r.t. the last step.
+   *   The last step is shortened to end on zeta = -1.
+   */
+  void adaptiveSchedule(bool yes=true){
+    this->_adaptive = yes;
+  }
+
+  /**
+   * @brief Number of zeta steps performed by the last call, backtracked ones included
+   */
+  int getNbSteps() const { return this->_nbSteps; }
+
+  /**
+   * @brief Zeta of each step of the last call, backtracked ones included
+   */
+  const std::vector<double> & getZetas() const { return this->_zetas; }
+
+  /**
+   * @brief Total number of IPFP iterations performed by the last call
+   */
+  int getNbInnerIterations() const { return this->_nbInnerIterations; }
+
+  /**
+   * @brief Record of the last call, summed over the zeta steps, see \ref IPFPTelemetry
+   */
+  const IPFPTelemetry & getTelemetry() const { return this->_telemetry; }
+
+  /**
+   * @brief  Select the solver of the LSAPE of the IPFP iterations and of the final projection
+   */
+  void lsapeSolver(LSAPESolver solver){
+    this->sub_algo->lsapeSolver(solver);
+  }
 
-  virtual GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute>* clone() const {
-    return new GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute>(*this);
+  /**
+   * @brief  Select the step rule of the IPFP iterations, see \ref IPFPGraphEditDistance::frankWolfeVariant
+   */
+  void frankWolfeVariant(typename IPFPGraphEditDistance<NodeAttribute,EdgeAttribute,Real>::FWVariant variant){
+    this->sub_algo->frankWolfeVariant(variant);
+  }
+
+  /**
+   * @brief  Restrict the substitutions of the IPFP iterations and of the final projection, see
+   *         \ref IPFPGraphEditDistance::candidates
+   */
+  void candidates(LSAPECandidates mode, double param = 0){
+    this->sub_algo->candidates(mode, param);
+  }
+
+  /**
+   * @brief The budget also stops the IPFP iterations of the current zeta
+   */
+  virtual void setBudget(ComputeBudget * budget){
+    this->_budget = budget;
+    this->sub_algo->setBudget(budget);
+  }
+
+  ~GNCCPGraphEditDistance(){
+    delete sub_algo;
+    if (_cleanEdInit) delete _ed_init;
+  }
+
+  virtual GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>* clone() const {
+    return new GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>(*this);
   }
 
 };
@@ -50,8 +167,8 @@ public:
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getOptimalMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
 			       Graph<NodeAttribute,EdgeAttribute> * g2,
 			       int * G1_to_G2, int * G2_to_G1){
@@ -69,39 +186,87 @@ getOptimalMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
   
   
   this->_zeta = 1;
-  this->sub_algo = new IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute>(this->cf, this->_zeta);
-
+  // The sub solver and its workspace are kept from one pair to another
+  this->sub_algo->setZeta(this->_zeta);
   this->sub_algo->setCurrentMatrix(G1_to_G2,G2_to_G1,n,m);
-  double * Xk = this->sub_algo->getCurrentMatrix();
-  Map<MatrixXd> m_Xk(Xk,n+1,m+1);
+  Real * Xk = this->sub_algo->getCurrentMatrix();
+  Map<MatrixR> m_Xk(Xk,n+1,m+1);
 #if DEBUG
   IOFormat OctaveFmt(StreamPrecision, 0, ", ", ";\n", "", "", "[", "]");
   std::cout << m_Xk.format(OctaveFmt) << std::endl;
 #endif
   this->sub_algo->setMaxIter(50);
   this->sub_algo->setEpsilon(0.005);
+  // Node costs and the quadratic term of Xk only depend on the pair, and Xk
+  // is carried from one zeta to the next : they are computed once
+  this->sub_algo->IPFPsetup(g1,g2);
+  this->_nbSteps = 0;
+  this->_nbInnerIterations = 0;
+  this->_zetas.clear();
+  double d = this->_d;
+  if (this->_adaptive) this->_Xprev.resize((n+1)*(m+1));
+  Real * Xprev = this->_Xprev.data();
+  Map<MatrixR> m_Xprev(Xprev,n+1,m+1);
+  double rate = 0; // decrease of the objective per unit of zeta along the last accepted step
+  bool backtracked = false;
   bool flag = true;
-  while((this->_zeta > -1) && flag){
+  while((this->_zeta >= -1) && flag && !this->budgetExhausted()){
     //this->sub_algo->setMaxIter(30+ 70*(1-fabs(this->_zeta)));
     this->sub_algo->setZeta(this->_zeta);
-    this->sub_algo->IPFPalgorithm(g1,g2);
+    if (this->_adaptive) memcpy(Xprev, Xk, sizeof(Real)*(n+1)*(m+1));
+    this->sub_algo->IPFPiterations(g1,g2);
+    this->_nbSteps++;
+    this->_zetas.push_back(this->_zeta);
+    this->_nbInnerIterations += this->sub_algo->getNbIterations();
 #if DEBUG
     std::cout << "zeta : " << this->_zeta << std::endl;
     std::cout << m_Xk.format(OctaveFmt) << std::endl;
 #endif
-    this->_zeta -= this->_d;
+    // The first step (zeta = 1) starts from the init, and is never adapted
+    if (this->_adaptive && this->_nbSteps > 1){
+      const std::vector<double> & S = this->sub_algo->getObjectives();
+      double decrease = S.front() - S.back();
+      // Negligible decreases (w.r.t. the objective) are never considered as jumps
+      if (rate > 0 && decrease / d > this->_jumpTol * rate &&
+          decrease > 0.01 * fabs(S.front()) && d > this->_dMin){
+        // The path bends : restart from the previous Xk with a smaller step
+        memcpy(Xk, Xprev, sizeof(Real)*(n+1)*(m+1));
+        this->sub_algo->IPFPupdateTerms(g1,g2);
+        this->_zeta += d;
+        d = std::max(d/2, this->_dMin);
+        this->_zeta -= d;
+        backtracked = true;
+        continue;
+      }
+      rate = decrease / d;
+      if (!backtracked && (m_Xk - m_Xprev).cwiseAbs().maxCoeff() < this->_smoothTol)
+        d = std::min(2*d, this->_dMax);
+      backtracked = false;
+    }
+    if (this->_adaptive && this->_zeta > -1 && this->_zeta - d <= -1){
+      // The last step of the adaptive schedule lands on zeta = -1
+      d = this->_zeta + 1;
+      this->_zeta = -1;
+    }else
+      this->_zeta -= d;
     flag = ((m_Xk.array().round() - m_Xk.array()).abs().sum() !=0);
   }
-  
+
 
 #if DEBUG
   std::cout << "zeta final : " << this->_zeta << std::endl;
   std::cout << m_Xk.format(OctaveFmt) << std::endl;
 #endif
-  m_Xk= MatrixXd::Ones(n+1, m+1)-m_Xk;
-  double *u = new double[n+1];
-  double *v = new double[m+1];
-  hungarianLSAPE(Xk,  n+1,  m+1, G1_to_G2,G2_to_G1, u,v,false);
+  m_Xk= MatrixR::Ones(n+1, m+1)-m_Xk;
+  this->_u.resize(n+1);
+  this->_v.resize(m+1);
+  this->_telemetry = this->sub_algo->getTelemetry();
+  double t = IPFPTelemetry::clock();
+  solveLSAPE(this->sub_algo->getLSAPESolver(), Xk, n+1, m+1, G1_to_G2, G2_to_G1, this->_u.data(), this->_v.data());
+  this->_telemetry.nbLSAPE++;
+  this->_telemetry.timeLSAPE += IPFPTelemetry::clock() - t;
+  this->_telemetry.timeTotal += IPFPTelemetry::clock() - t;
+  this->_telemetry.converged = !flag;
 
 #if DEBUG
   std::cout << " G1_to_G2 :" << std::endl;
@@ -111,8 +276,6 @@ getOptimalMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
   for (int j = 0; j < m ;j ++)
     std::cout << j << " -> " << G2_to_G1[j] << std::endl;
 #endif	 
-  delete [] u;
-  delete [] v;   
 }
 
 
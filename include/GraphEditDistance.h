@@ -11,6 +11,7 @@
 #define __GRAPHEDITDISTANCE_H__
 
 #include "graph.h"
+#include "ComputeBudget.h"
 
 // A TRANSFORMER EN CLASSE ABSTRAITE 
 template<class NodeAttribute, class EdgeAttribute>
@@ -52,11 +53,12 @@ class GraphEditDistance
 {
 protected:  
   EditDistanceCost<NodeAttribute,EdgeAttribute> * cf;
+  ComputeBudget * _budget; //!< budget of the current computation, NULL if unlimited
 
 public:
 
   //Mapping is an array encoding the mapping of each node
-  GraphEditDistance(  EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction):cf(costFunction){};
+  GraphEditDistance(  EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction):cf(costFunction),_budget(NULL){};
 
   double GedFromMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
 			Graph<NodeAttribute,EdgeAttribute> * g2,
@@ -72,6 +74,13 @@ public:
 
   EditDistanceCost<NodeAttribute,EdgeAttribute> * getCostFunction(){ return cf; }
   void setCostFunction(EditDistanceCost<NodeAttribute, EdgeAttribute> * ncf){ cf = ncf; }
+
+  /**
+   * @brief Budget checked by the iterative methods, and forwarded to the methods they use (NULL : unlimited)
+   */
+  virtual void setBudget(ComputeBudget * budget){ _budget = budget; }
+  ComputeBudget * getBudget() const { return _budget; }
+  bool budgetExhausted() const { return _budget != NULL && _budget->exhausted(); }
   
   virtual ~GraphEditDistance(){};
 
@@ -0,0 +1,399 @@
+/**
+ * @file GraphIsomorphism.h
+ * @version     0.0.1
+ *
+ * Exact isomorphisms of labeled graphs, as seen by an edit cost function, to answer the pairs of
+ * graphs at distance 0 without running an approximation, and to group duplicates in a dataset.
+ */
+
+#ifndef __GRAPHISOMORPHISM_H__
+#define __GRAPHISOMORPHISM_H__
+
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <stdint.h>
+#include "GraphEditDistance.h"
+
+
+/**
+ * @brief Canonical hashes and isomorphism tests of graphs
+ *
+ *   Two nodes (or edges) have the same label when substituting one by the other costs nothing.
+ *   The labels are numbered by representatives shared by all the graphs seen, so the numbers are
+ *   comparable from one graph to another. The hash of a graph comes from a label-aware color
+ *   refinement (Weisfeiler-Lehman) : the color of a node is repeatedly hashed with the sorted
+ *   (edge label, neighbour color) of its edges, until the number of colors stops growing, and the
+ *   graph hash combines the sorted colors. Isomorphic graphs always have the same hash.
+ *
+ *   Graphs with the same hash are compared by a VF2-like backtracking search : the nodes of g1
+ *   are ordered by connectivity from the rarest color, each node is only mapped to a node of g2
+ *   of the same color, and the edges between the mapped nodes must match with their labels. A
+ *   mapping found is checked against the cost function, so an isomorphism reported always has a
+ *   null edit cost. The search gives up after <code>_maxStates</code> states, which may only hide
+ *   an isomorphism.
+ *
+ *   Signatures are cached by graph address : call \ref clearCache when a graph is modified or deleted.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class GraphIsomorphism
+{
+protected:
+
+  typedef Graph<NodeAttribute,EdgeAttribute> G;
+
+  struct Signature {
+    int nbEdges;
+    std::vector<int> label;                                 //!< label class of each node
+    std::vector<std::vector<std::pair<int,int> > > out, in; //!< sorted (neighbour, edge class) of each node
+    std::vector<uint64_t> color;                            //!< stable color of each node
+    uint64_t hash;
+  };
+
+  EditDistanceCost<NodeAttribute,EdgeAttribute> * cf;
+  std::vector<GNode<NodeAttribute,EdgeAttribute>*> _nodeReps; //!< copies of the labels seen
+  std::vector<GEdge<EdgeAttribute>*> _edgeReps;
+  std::map<G*, Signature> _cache;
+  long _maxStates;
+
+  static uint64_t mix(uint64_t h, uint64_t x){
+    h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+  }
+
+  static bool hasEdge(const std::vector<std::pair<int,int> > & adj, int v, int c){
+    return std::binary_search(adj.begin(), adj.end(), std::make_pair(v, c));
+  }
+
+  const Signature & signature(G * g);
+
+  int nodeClass(G * g, int u);
+
+  int edgeClass(G * g, GEdge<EdgeAttribute> * p);
+
+  /**
+   * @brief Extend the partial mapping f (and its inverse r) to the nodes order[t..n-1]
+   */
+  bool extend(const Signature & s1, const Signature & s2, const std::vector<int> & order,
+              unsigned int t, std::vector<int> & f, std::vector<int> & r, long & states) const;
+
+  /**
+   * @brief Check that edge lists of u in g1 and v in g2 match on the mapped nodes
+   */
+  bool consistent(const std::vector<std::pair<int,int> > & a, const std::vector<std::pair<int,int> > & b,
+                  const std::vector<int> & f, const std::vector<int> & r) const;
+
+public:
+
+  /**
+   * @param maxStates  largest number of states of the search of an isomorphism
+   */
+  GraphIsomorphism( EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction, long maxStates = 1000000 ):
+    cf(costFunction), _maxStates(maxStates)
+  {}
+
+  GraphIsomorphism( const GraphIsomorphism<NodeAttribute,EdgeAttribute> & other ):
+    cf(other.cf), _maxStates(other._maxStates)
+  {}
+
+  virtual ~GraphIsomorphism(){
+    clearCache();
+    for (unsigned int c=0; c<_nodeReps.size(); c++) delete _nodeReps[c];
+    for (unsigned int c=0; c<_edgeReps.size(); c++) delete _edgeReps[c];
+  }
+
+  /**
+   * @brief Forget the signatures of the graphs seen, the label classes are kept
+   */
+  void clearCache(){ _cache.clear(); }
+
+  /**
+   * @brief Hash invariant under isomorphism
+   */
+  uint64_t hash(G * g){ return signature(g).hash; }
+
+  /**
+   * @brief True if g1 and g2 are isomorphic, then the isomorphism is written in G1_to_G2 and
+   *        G2_to_G1 if given
+   */
+  bool isomorphic(G * g1, G * g2, int * G1_to_G2 = NULL, int * G2_to_G1 = NULL);
+
+  /**
+   * @brief Representative of each graph : the first graph of the list isomorphic to it
+   */
+  std::vector<int> representatives(const std::vector<G*> & graphs);
+};
+
+
+
+/**
+ * @brief A graph edit distance answering 0 with an exact mapping for isomorphic graphs, and
+ *        delegating the other pairs to another method
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class IsomorphismShortcut :
+  public GraphEditDistance<NodeAttribute, EdgeAttribute>
+{
+protected:
+
+  GraphIsomorphism<NodeAttribute,EdgeAttribute> _iso;
+  GraphEditDistance<NodeAttribute,EdgeAttribute> * _ed; //!< method of the non isomorphic pairs
+  bool _cleanEd;      //!< Delete _ed in the destructor if true
+  int _nbShortcuts;   //!< Number of pairs found isomorphic
+
+public:
+
+  IsomorphismShortcut( EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
+                       GraphEditDistance<NodeAttribute,EdgeAttribute> * ed ):
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
+    _iso(costFunction),
+    _ed(ed),
+    _cleanEd(false),
+    _nbShortcuts(0)
+  {}
+
+  IsomorphismShortcut( const IsomorphismShortcut<NodeAttribute,EdgeAttribute> & other ):
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(other.cf),
+    _iso(other._iso),
+    _ed(other._ed->clone()),
+    _cleanEd(true),
+    _nbShortcuts(0)
+  {
+    this->setBudget(other._budget);
+  }
+
+  virtual ~IsomorphismShortcut(){
+    if (_cleanEd) delete _ed;
+  }
+
+  int getNbShortcuts() const { return _nbShortcuts; }
+
+  /**
+   * @brief See \ref GraphIsomorphism::clearCache
+   */
+  void clearCache(){ _iso.clearCache(); }
+
+  virtual void setBudget(ComputeBudget * budget){
+    this->_budget = budget;
+    _ed->setBudget(budget);
+  }
+
+  virtual double operator()(Graph<NodeAttribute,EdgeAttribute> * g1,
+                            Graph<NodeAttribute,EdgeAttribute> * g2)
+  {
+    if (_iso.isomorphic(g1, g2)){
+      _nbShortcuts++;
+      return 0;
+    }
+    return (*_ed)(g1, g2);
+  }
+
+  virtual void getOptimalMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
+                                 Graph<NodeAttribute,EdgeAttribute> * g2,
+                                 int * G1_to_G2, int * G2_to_G1)
+  {
+    if (_iso.isomorphic(g1, g2, G1_to_G2, G2_to_G1)){
+      _nbShortcuts++;
+      return;
+    }
+    _ed->getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+  }
+
+  virtual IsomorphismShortcut<NodeAttribute, EdgeAttribute> * clone() const {
+    return new IsomorphismShortcut<NodeAttribute, EdgeAttribute>(*this);
+  }
+};
+
+
+
+template<class NodeAttribute, class EdgeAttribute>
+int GraphIsomorphism<NodeAttribute, EdgeAttribute>::
+nodeClass(G * g, int u)
+{
+  unsigned int c = 0;
+  while (c < _nodeReps.size() && cf->NodeSubstitutionCost((*g)[u], _nodeReps[c], g, g) != 0) c++;
+  if (c == _nodeReps.size())
+    _nodeReps.push_back(new GNode<NodeAttribute,EdgeAttribute>(-1, (*g)[u]->attr));
+  return c;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+int GraphIsomorphism<NodeAttribute, EdgeAttribute>::
+edgeClass(G * g, GEdge<EdgeAttribute> * p)
+{
+  unsigned int c = 0;
+  while (c < _edgeReps.size() && cf->EdgeSubstitutionCost(p, _edgeReps[c], g, g) != 0) c++;
+  if (c == _edgeReps.size())
+    _edgeReps.push_back(new GEdge<EdgeAttribute>(-1, NULL, p->attr));
+  return c;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+const typename GraphIsomorphism<NodeAttribute, EdgeAttribute>::Signature &
+GraphIsomorphism<NodeAttribute, EdgeAttribute>::
+signature(G * g)
+{
+  typename std::map<G*, Signature>::iterator it = _cache.find(g);
+  if (it != _cache.end()) return it->second;
+
+  const int n = g->Size();
+  Signature & s = _cache[g];
+  s.nbEdges = 0;
+  s.label.resize(n);
+  s.out.resize(n);
+  s.in.resize(n);
+  for (int u=0; u<n; u++){
+    s.label[u] = nodeClass(g, u);
+    for (GEdge<EdgeAttribute> * p = (*g)[u]->getIncidentEdges(); p; p = p->Next()){
+      int c = edgeClass(g, p);
+      s.out[u].push_back(std::make_pair(p->IncidentNode(), c));
+      s.in[p->IncidentNode()].push_back(std::make_pair(u, c));
+      s.nbEdges++;
+    }
+  }
+  for (int u=0; u<n; u++){
+    std::sort(s.out[u].begin(), s.out[u].end());
+    std::sort(s.in[u].begin(), s.in[u].end());
+  }
+
+  // Color refinement, on 64 bits hashes so that colors are comparable between graphs
+  s.color.resize(n);
+  for (int u=0; u<n; u++) s.color[u] = mix(0, s.label[u]);
+  std::vector<uint64_t> next(n), sorted;
+  int nbColors = -1;
+  while (true){
+    sorted = s.color;
+    std::sort(sorted.begin(), sorted.end());
+    int c = std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+    if (c <= nbColors) break;
+    nbColors = c;
+    for (int u=0; u<n; u++){
+      std::vector<uint64_t> nb;
+      for (unsigned int t=0; t<s.out[u].size(); t++)
+        nb.push_back(mix(mix(1, s.out[u][t].second), s.color[s.out[u][t].first]));
+      if (g->isDirected())
+        for (unsigned int t=0; t<s.in[u].size(); t++)
+          nb.push_back(mix(mix(2, s.in[u][t].second), s.color[s.in[u][t].first]));
+      std::sort(nb.begin(), nb.end());
+      uint64_t h = s.color[u];
+      for (unsigned int t=0; t<nb.size(); t++) h = mix(h, nb[t]);
+      next[u] = h;
+    }
+    s.color.swap(next);
+  }
+
+  sorted = s.color;
+  std::sort(sorted.begin(), sorted.end());
+  s.hash = mix(mix(mix(0, n), s.nbEdges), g->isDirected());
+  for (int u=0; u<n; u++) s.hash = mix(s.hash, sorted[u]);
+  return s;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+bool GraphIsomorphism<NodeAttribute, EdgeAttribute>::
+consistent(const std::vector<std::pair<int,int> > & a, const std::vector<std::pair<int,int> > & b,
+           const std::vector<int> & f, const std::vector<int> & r) const
+{
+  int na = 0, nb = 0;
+  for (unsigned int t=0; t<a.size(); t++)
+    if (f[a[t].first] >= 0){
+      if (!hasEdge(b, f[a[t].first], a[t].second)) return false;
+      na++;
+    }
+  for (unsigned int t=0; t<b.size(); t++)
+    if (r[b[t].first] >= 0) nb++;
+  return na == nb;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+bool GraphIsomorphism<NodeAttribute, EdgeAttribute>::
+extend(const Signature & s1, const Signature & s2, const std::vector<int> & order,
+       unsigned int t, std::vector<int> & f, std::vector<int> & r, long & states) const
+{
+  if (t == order.size()) return true;
+  const int u = order[t];
+  for (unsigned int v=0; v<r.size(); v++){
+    if (r[v] >= 0 || s2.color[v] != s1.color[u]) continue;
+    if (++states > _maxStates) return false;
+    f[u] = v; r[v] = u;
+    if (consistent(s1.out[u], s2.out[v], f, r) && consistent(s1.in[u], s2.in[v], f, r) &&
+        extend(s1, s2, order, t+1, f, r, states))
+      return true;
+    f[u] = -1; r[v] = -1;
+    if (states > _maxStates) return false;
+  }
+  return false;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+bool GraphIsomorphism<NodeAttribute, EdgeAttribute>::
+isomorphic(G * g1, G * g2, int * G1_to_G2, int * G2_to_G1)
+{
+  if (g1->Size() != g2->Size() || g1->isDirected() != g2->isDirected()) return false;
+  const Signature & s1 = signature(g1);
+  const Signature & s2 = signature(g2);
+  if (s1.hash != s2.hash) return false;
+  const int n = g1->Size();
+
+  // Nodes of g1 ordered by number of ordered neighbours, then by rarity of their color
+  std::unordered_map<uint64_t, int> frequency;
+  for (int u=0; u<n; u++) frequency[s1.color[u]]++;
+  std::vector<int> order, links(n, 0);
+  std::vector<bool> placed(n, false);
+  for (int t=0; t<n; t++){
+    int best = -1;
+    for (int u=0; u<n; u++){
+      if (placed[u]) continue;
+      if (best < 0 || links[u] > links[best] ||
+          (links[u] == links[best] && frequency[s1.color[u]] < frequency[s1.color[best]]))
+        best = u;
+    }
+    placed[best] = true;
+    order.push_back(best);
+    for (unsigned int e=0; e<s1.out[best].size(); e++) links[s1.out[best][e].first]++;
+    for (unsigned int e=0; e<s1.in[best].size(); e++) links[s1.in[best][e].first]++;
+  }
+
+  std::vector<int> f(n, -1), r(n, -1);
+  long states = 0;
+  if (!extend(s1, s2, order, 0, f, r, states)) return false;
+
+  // The mapping must have a null cost, even if the label classes are not transitive
+  for (int u=0; u<n; u++){
+    if (cf->NodeSubstitutionCost((*g1)[u], (*g2)[f[u]], g1, g2) != 0) return false;
+    for (GEdge<EdgeAttribute> * p = (*g1)[u]->getIncidentEdges(); p; p = p->Next()){
+      GEdge<EdgeAttribute> * q = g2->getEdge(f[u], f[p->IncidentNode()]);
+      if (q == NULL || cf->EdgeSubstitutionCost(p, q, g1, g2) != 0) return false;
+    }
+  }
+  if (G1_to_G2) std::copy(f.begin(), f.end(), G1_to_G2);
+  if (G2_to_G1) std::copy(r.begin(), r.end(), G2_to_G1);
+  return true;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+std::vector<int> GraphIsomorphism<NodeAttribute, EdgeAttribute>::
+representatives(const std::vector<G*> & graphs)
+{
+  std::vector<int> rep(graphs.size());
+  std::unordered_map<uint64_t, std::vector<int> > buckets; // representatives of each hash
+  for (unsigned int i=0; i<graphs.size(); i++){
+    std::vector<int> & bucket = buckets[hash(graphs[i])];
+    unsigned int t = 0;
+    while (t < bucket.size() && !isomorphic(graphs[bucket[t]], graphs[i])) t++;
+    if (t == bucket.size()) bucket.push_back(i);
+    rep[i] = bucket[t];
+  }
+  return rep;
+}
+
+#endif // __GRAPHISOMORPHISM_H__
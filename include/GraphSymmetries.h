@@ -0,0 +1,263 @@
+/**
+ * @file GraphSymmetries.h
+ * @version     0.0.1
+ *
+ * Automorphisms of labeled graphs, as seen by an edit cost function : two nodes (or edges) have
+ * the same label when substituting one by the other costs nothing.
+ */
+
+#ifndef __GRAPHSYMMETRIES_H__
+#define __GRAPHSYMMETRIES_H__
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "GraphEditDistance.h"
+
+
+/**
+ * @brief Twin nodes, automorphism generators and orbits of a graph
+ *
+ *   Nodes are first colored by their labels, and the colors are refined by the multisets of
+ *   (edge label, neighbour color) until they are stable (color refinement). Nodes of different
+ *   colors are never exchanged by an automorphism.
+ *
+ *   Twins are nodes of the same label with the same labeled neighbours, e.g. the hydrogens of a
+ *   CH3 group : any permutation of a twin class is an automorphism. Other symmetries, such as the
+ *   rotations and reflections of a ring, are searched along a chain of fixed points : with the
+ *   points b_0..b_{l-1} fixed, the first node b_l of a non singleton color is mapped to each node
+ *   of its color. Each candidate is individualized and the colors refined until they are discrete,
+ *   always taking the first node of a color, and the resulting bijection is kept only if it
+ *   preserves every label and edge. This check has no backtracking, so some automorphisms may be
+ *   missed, but none is reported falsely.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class GraphSymmetries
+{
+protected:
+
+  typedef Graph<NodeAttribute,EdgeAttribute> G;
+
+  int _n;
+  std::vector<int> _label;        //!< class of the label of each node
+  std::vector<std::vector<std::pair<int,int> > > _adj; //!< (neighbour, class of the edge label) of each node
+  std::vector<int> _colors;       //!< stable colors
+  std::vector<int> _twin;         //!< twin class of each node, 0..nbTwinClasses()-1
+  int _nbTwinClasses;
+  std::vector<std::vector<int> > _generators; //!< automorphisms which are not twin permutations
+  std::vector<int> _orbit;        //!< orbit of each node, the smallest node of the orbit
+
+  /**
+   * @brief Refine colors until stable, the new colors only depend on the multiset of signatures
+   * @return the number of colors
+   */
+  int refine(std::vector<int> & colors) const;
+
+  /**
+   * @brief Search an automorphism mapping each xs[t] to ys[t], see the class description
+   */
+  bool findAutomorphism(std::vector<int> xs, std::vector<int> ys, std::vector<int> & sigma) const;
+
+  static int find(std::vector<int> & uf, int x){ return (uf[x] == x) ? x : (uf[x] = find(uf, uf[x])); }
+
+public:
+
+  /**
+   * @param maxGenerators  largest number of automorphisms searched beyond the twins
+   * @param maxFailures    largest number of unsuccessful searches, which bounds the time spent
+   *                       on graphs whose colors stay coarse without symmetries (e.g. regular graphs)
+   */
+  GraphSymmetries( G * g, EditDistanceCost<NodeAttribute,EdgeAttribute> * cf,
+                   int maxGenerators = 32, int maxFailures = 64 );
+
+  int size() const { return _n; }
+
+  int nbTwinClasses() const { return _nbTwinClasses; }
+
+  const std::vector<int> & twinClasses() const { return _twin; }
+
+  const std::vector<int> & colors() const { return _colors; }
+
+  /**
+   * @brief Automorphisms found beyond the permutations of twins, as node permutations
+   */
+  const std::vector<std::vector<int> > & generators() const { return _generators; }
+
+  /**
+   * @brief Orbit of each node under the twin permutations and the generators
+   */
+  const std::vector<int> & orbits() const { return _orbit; }
+
+  /**
+   * @brief True if the graph has a symmetry other than the identity among the ones found
+   */
+  bool symmetric() const { return _nbTwinClasses < _n || !_generators.empty(); }
+};
+
+
+
+template<class NodeAttribute, class EdgeAttribute>
+GraphSymmetries<NodeAttribute, EdgeAttribute>::
+GraphSymmetries( G * g, EditDistanceCost<NodeAttribute,EdgeAttribute> * cf,
+                 int maxGenerators, int maxFailures ):
+  _n(g->Size()), _nbTwinClasses(0)
+{
+  // Label classes, from representatives of null substitution cost
+  std::vector<int> reps;
+  _label.resize(_n);
+  for (int u=0; u<_n; u++){
+    unsigned int c = 0;
+    while (c < reps.size() && cf->NodeSubstitutionCost((*g)[u], (*g)[reps[c]], g, g) != 0) c++;
+    if (c == reps.size()) reps.push_back(u);
+    _label[u] = c;
+  }
+  std::vector<GEdge<EdgeAttribute>*> edgeReps;
+  _adj.resize(_n);
+  for (int u=0; u<_n; u++){
+    for (GEdge<EdgeAttribute> * p = (*g)[u]->getIncidentEdges(); p; p = p->Next()){
+      unsigned int c = 0;
+      while (c < edgeReps.size() && cf->EdgeSubstitutionCost(p, edgeReps[c], g, g) != 0) c++;
+      if (c == edgeReps.size()) edgeReps.push_back(p);
+      _adj[u].push_back(std::make_pair(p->IncidentNode(), (int)c));
+    }
+    std::sort(_adj[u].begin(), _adj[u].end());
+  }
+
+  _colors = _label;
+  refine(_colors);
+
+  // Twins : same label and same labeled neighbours
+  std::map<std::pair<int, std::vector<std::pair<int,int> > >, int> twinKeys;
+  _twin.resize(_n);
+  for (int u=0; u<_n; u++){
+    std::pair<int, std::vector<std::pair<int,int> > > key(_label[u], _adj[u]);
+    typename std::map<std::pair<int, std::vector<std::pair<int,int> > >, int>::iterator it = twinKeys.find(key);
+    if (it == twinKeys.end()){
+      _twin[u] = _nbTwinClasses;
+      twinKeys[key] = _nbTwinClasses++;
+    }
+    else
+      _twin[u] = it->second;
+  }
+
+  _orbit.resize(_n);
+  for (int u=0; u<_n; u++) _orbit[u] = u;
+  std::vector<int> firstOfTwin(_nbTwinClasses, -1);
+  for (int u=0; u<_n; u++){
+    if (firstOfTwin[_twin[u]] < 0) firstOfTwin[_twin[u]] = u;
+    else _orbit[find(_orbit, u)] = find(_orbit, firstOfTwin[_twin[u]]);
+  }
+
+  // Other automorphisms, along a chain of fixed points
+  std::vector<int> base, sigma, colors = _colors, level(_n);
+  int failures = 0;
+  while ((int)_generators.size() < maxGenerators && failures < maxFailures){
+    std::vector<int> size(_n+1, 0);
+    for (int u=0; u<_n; u++) size[colors[u]]++;
+    int u = 0;
+    while (u < _n && size[colors[u]] == 1) u++;
+    if (u == _n) break;
+
+    // orbits of the stabilizer of the base, among the nodes of the color of u
+    for (int x=0; x<_n; x++) level[x] = x;
+    for (int v=u+1; v<_n && (int)_generators.size() < maxGenerators && failures < maxFailures; v++){
+      if (colors[v] != colors[u] || _twin[v] == _twin[u] || find(level, v) == find(level, u)) continue;
+      std::vector<int> xs = base, ys = base;
+      xs.push_back(u); ys.push_back(v);
+      if (findAutomorphism(xs, ys, sigma)){
+        _generators.push_back(sigma);
+        for (int x=0; x<_n; x++){
+          level[find(level, x)] = find(level, sigma[x]);
+          _orbit[find(_orbit, x)] = find(_orbit, sigma[x]);
+        }
+      }
+      else
+        failures++;
+    }
+    base.push_back(u);
+    colors[u] = _n;
+    refine(colors);
+  }
+  for (int u=0; u<_n; u++) _orbit[u] = find(_orbit, u);
+  std::vector<int> smallest(_n, _n);
+  for (int u=0; u<_n; u++) smallest[_orbit[u]] = std::min(smallest[_orbit[u]], u);
+  for (int u=0; u<_n; u++) _orbit[u] = smallest[_orbit[u]];
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+int GraphSymmetries<NodeAttribute, EdgeAttribute>::
+refine(std::vector<int> & colors) const
+{
+  int nbColors = -1;
+  std::vector<std::vector<int> > sig(_n);
+  while (true){
+    for (int u=0; u<_n; u++){
+      sig[u].assign(1, colors[u]);
+      std::vector<int> nb;
+      for (unsigned int t=0; t<_adj[u].size(); t++)
+        nb.push_back(_adj[u][t].second * (_n+1) + colors[_adj[u][t].first]);
+      std::sort(nb.begin(), nb.end());
+      sig[u].insert(sig[u].end(), nb.begin(), nb.end());
+    }
+    // colors numbered by sorted signatures, so that isomorphic colorings get the same numbers
+    std::map<std::vector<int>, int> ids;
+    for (int u=0; u<_n; u++) ids[sig[u]] = 0;
+    int c = 0;
+    for (typename std::map<std::vector<int>, int>::iterator it=ids.begin(); it!=ids.end(); it++) it->second = c++;
+    for (int u=0; u<_n; u++) colors[u] = ids[sig[u]];
+    if (c == nbColors) return c;
+    nbColors = c;
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+bool GraphSymmetries<NodeAttribute, EdgeAttribute>::
+findAutomorphism(std::vector<int> xs, std::vector<int> ys, std::vector<int> & sigma) const
+{
+  std::vector<int> a = _colors, b = _colors;
+  while (true){
+    // individualize the pairs in sequence, with the same colors in a and b
+    int ca = 0, cb = 0;
+    for (unsigned int t=0; t<xs.size(); t++){
+      a[xs[t]] = _n; b[ys[t]] = _n;
+      ca = refine(a); cb = refine(b);
+      if (ca != cb) return false;
+      std::vector<int> count(ca, 0);
+      for (int w=0; w<_n; w++){ count[a[w]]++; count[b[w]]--; }
+      for (int c=0; c<ca; c++) if (count[c] != 0) return false;
+    }
+    if (ca == _n) break;
+
+    // first node of the first non singleton color, in both colorings
+    std::vector<int> size(ca, 0);
+    for (int w=0; w<_n; w++) size[a[w]]++;
+    int cell = 0;
+    while (size[cell] == 1) cell++;
+    int x = -1, y = -1;
+    for (int w=0; w<_n && (x < 0 || y < 0); w++){
+      if (x < 0 && a[w] == cell) x = w;
+      if (y < 0 && b[w] == cell) y = w;
+    }
+    xs.assign(1, x); ys.assign(1, y);
+  }
+
+  std::vector<int> byColor(_n);
+  for (int w=0; w<_n; w++) byColor[b[w]] = w;
+  sigma.resize(_n);
+  for (int w=0; w<_n; w++) sigma[w] = byColor[a[w]];
+
+  // check labels and edges
+  for (int w=0; w<_n; w++){
+    if (_label[w] != _label[sigma[w]] || _adj[w].size() != _adj[sigma[w]].size()) return false;
+    std::vector<std::pair<int,int> > image;
+    for (unsigned int t=0; t<_adj[w].size(); t++)
+      image.push_back(std::make_pair(sigma[_adj[w][t].first], _adj[w][t].second));
+    std::sort(image.begin(), image.end());
+    if (image != _adj[sigma[w]]) return false;
+  }
+  return true;
+}
+
+#endif // __GRAPHSYMMETRIES_H__
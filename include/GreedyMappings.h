@@ -0,0 +1,106 @@
+/**
+ * @file GreedyMappings.h
+ * @version     0.0.1
+ *
+ * Initial mappings from greedy approximations of the bipartite LSAPE, refined by 2-opt.
+ */
+
+#ifndef __GREEDYMAPPINGS_H__
+#define __GREEDYMAPPINGS_H__
+
+#include <set>
+#include <vector>
+#include "BipartiteGraphEditDistance.h"
+#include "MappingGenerator.h"
+#include "LSAPESolver.h"
+#include "RandomStream.h"
+
+
+/**
+ * @brief Mappings generated by greedy approximations of the bipartite LSAPE
+ *
+ *   The first mapping is \ref greedySortLSAPE refined by \ref twoOptLSAPE. The other ones are
+ *   \ref greedyRowLSAPE on random orders of the rows, each refined by \ref twoOptLSAPE.
+ *   Duplicates are discarded, so fewer than k mappings may be returned.
+ *   No LSAPE is solved exactly, which makes the generator cheap on large graphs.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class GreedyMappings :
+  public BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute>,
+  public MappingGenerator<NodeAttribute, EdgeAttribute>
+{
+protected:
+
+  RandomStream randGen;
+
+public:
+
+  GreedyMappings( EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
+                  unsigned int seed = 123 ):
+    BipartiteGraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
+    randGen(seed)
+  {
+    this->lsapeSolver(LSAPE_GREEDY_REFINED);
+  }
+
+  GreedyMappings( const GreedyMappings<NodeAttribute,EdgeAttribute> & other ):
+    BipartiteGraphEditDistance<NodeAttribute,EdgeAttribute>(other),
+    randGen(other.randGen)
+  {}
+
+  virtual ~GreedyMappings(){}
+
+public:
+
+  virtual std::list<int*> getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
+                                       Graph<NodeAttribute,EdgeAttribute> * g2,
+                                       int k = -1 );
+
+  virtual GreedyMappings<NodeAttribute, EdgeAttribute> * clone() const {
+    return new GreedyMappings<NodeAttribute, EdgeAttribute>(*this);
+  }
+};
+
+
+
+template<class NodeAttribute, class EdgeAttribute>
+std::list<int*> GreedyMappings<NodeAttribute, EdgeAttribute>::
+getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
+             Graph<NodeAttribute,EdgeAttribute> * g2,
+             int k )
+{
+  if (k < 0) k = 100;
+
+  int n = g1->Size();
+  int m = g2->Size();
+  this->computeCostMatrix(g1, g2);
+
+  std::list<int*> mappings;
+  std::set< std::vector<int> > seen;
+  int* rho = new int[n];
+  int* varrho = new int[m];
+  int* order = new int[n];
+  for (int i=0; i<n; i++) order[i] = i;
+
+  // a few more trials than mappings, since random orders often lead to the same local optimum
+  for (int t=0; t<4*k && (int)mappings.size() < k; t++){
+    if (t == 0)
+      greedySortLSAPE(this->C, n+1, m+1, rho, varrho);
+    else{
+      randGen.shuffle(order, n);
+      greedyRowLSAPE(this->C, n+1, m+1, rho, varrho, order);
+    }
+    twoOptLSAPE(this->C, n+1, m+1, rho, varrho);
+
+    if (seen.insert(std::vector<int>(rho, rho+n)).second)
+      mappings.push_back(lsapeToPermutation(rho, varrho, n, m));
+  }
+
+  delete [] order;
+  delete [] varrho;
+  delete [] rho;
+  delete [] this->C; this->C = NULL;
+  return mappings;
+}
+
+#endif
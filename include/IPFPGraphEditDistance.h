@@ -14,82 +14,279 @@
 #define __IPFPGRAPHEDITDISTANCE_H__
 #include <Eigen/Dense>
 #include <limits>
+#include <algorithm>
 using namespace Eigen;
-#include "hungarian-lsape.hh"
+#include "LSAPESolver.h"
+#include "SparseLSAPE.h"
+#include "PointDistanceCost.h"
 #include "lsape.hh" // Bistochastic generation and sinkhorn balancing
 #include "GraphEditDistance.h"
 #include "IPFPQAP.h"
+#include "IPFPTelemetry.h"
 #include "utils.h"
 
-template<class NodeAttribute, class EdgeAttribute>
+/**
+ * @tparam Real  type of the (n+1)x(m+1) matrices of the solver (node costs, Xk, quadratic terms, LSAPE
+ *               duals). The objective values and the line search are always computed in double.
+ */
+template<class NodeAttribute, class EdgeAttribute, class Real = double>
 class IPFPGraphEditDistance:
-  public IPFPQAP<NodeAttribute, EdgeAttribute>,
+  public IPFPQAP<NodeAttribute, EdgeAttribute, Real>,
   public GraphEditDistance<NodeAttribute, EdgeAttribute>
 {
 
+public:
+  typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic> MatrixR; //!< matrices of the solver, in the working precision
+
+  /**
+   * @brief Step rules of the Frank-Wolfe iterations
+   */
+  enum FWVariant {
+    FW_CLASSIC,  //!< step towards the solution of the linear subproblem, with exact line search
+    FW_AWAY,     //!< away-step Frank-Wolfe : may step away from the worst atom of the active set
+    FW_PAIRWISE  //!< pairwise Frank-Wolfe : moves weight from the worst atom to the linear subproblem solution
+  };
+
 protected:
 
   GraphEditDistance<NodeAttribute,EdgeAttribute> * _ed_init;
+  bool cleanEdInit;   //!< Delete _ed_init in the destructor if true
   bool cleanCostFunction;
   bool useContinuousRandomInit;
   bool useContinuousFlatInit;
   bool useSinkhorn;
 
+  // Workspace kept from one call to another, sized for the largest pair seen so far
+  int _wsRows;   //!< number of rows the workspace matrices can hold
+  int _wsCols;   //!< number of columns the workspace matrices can hold
+  Real * _u;   //!< dual variables of the last LSAPE on rows
+  Real * _v;   //!< dual variables of the last LSAPE on columns
+  int * _G1_to_G2; //!< discrete solution of the last linear subproblem
+  int * _G2_to_G1;
+  bool _keepDuals = false;  //!< warm start the first LSAPE of a call from the last one of the previous call
+  bool _dualsValid = false; //!< true if _u, _v and the solution above come from the current pair
+
+  // Away-step and pairwise variants : Xk is kept as a convex combination of atoms
+  FWVariant fwVariant;
+  std::vector<Real*> _atomsX;  //!< atoms of the active set (the init, then LSAPE solutions)
+  std::vector<Real*> _atomsD;  //!< quadratic terms of the atoms
+  std::vector<double> _atomsW;   //!< weights of the atoms in Xk
+  Real * _dirX;  //!< direction of the current step
+  Real * _dirD;  //!< quadratic term of the direction
+  int _nbLSAPE;      //!< LSAPE solved during the last call
+  int _nbAwaySteps;  //!< away (or pairwise) steps done during the last call
+  int _nbDropSteps;  //!< steps which removed an atom from the active set during the last call
+
+  // Coordinate form of Xk : the dense Xk is always valid, the list of its non-zero entries
+  // is kept along while Xk is sparse (binary init, full steps) and used by the kernels
+  std::vector<std::pair<std::pair<int,int>,double> > _XkSparse; //!< non-zero entries of Xk, by rows as
+                                                               //!< the sums of linearCost on a dense Xk
+  bool _XkIsSparse;             //!< true if _XkSparse holds all the non-zero entries of Xk
+  double _sparseDensity = 0.25; //!< largest proportion of non-zero entries of a sparse Xk
+
+  // Step from a sparse Xk towards bkp1, see \ref quadraticStep
+  std::vector<std::pair<std::pair<int,int>,double> > _stepX; //!< non-zero entries of bkp1 - Xk
+  std::vector<int> _stepEntries; //!< entries of XkD and of the gradient changed by the step
+  std::vector<Real> _stepD;      //!< quadratic term of bkp1 - Xk on these entries
+  std::vector<Real> _stepXkD;    //!< XkD on these entries before the step
+  std::vector<int> _stepIndex;   //!< position of each entry in _stepEntries, -1 if absent
+
+  LSAPESolver _lsapeSolver = LSAPE_HUNGARIAN; //!< solver of the linear subproblems and of the final projection
+  LSAPECandidates _candidates = CANDIDATES_ALL; //!< substitutions allowed in the linear subproblems
+  double _candidatesParam = 0;                  //!< number of candidates per node, or largest node cost of a candidate
+  SparseCostMatrix<Real> _sparseLSAPE;          //!< candidates of the current pair, selected by \ref IPFPsetup
+
+  /**
+   * @brief Adjacency lists of a graph in CSR form, with the cost of removing (g1) or adding (g2)
+   *        each node and each edge. Self loops are left out.
+   */
+  struct Adjacency {
+    Graph<NodeAttribute,EdgeAttribute> * g;  //!< graph described, NULL if none
+    std::vector<int> ptr;                    //!< edges of node i are in [ptr[i], ptr[i+1])
+    std::vector<int> node;                   //!< other end of each edge
+    std::vector<GEdge<EdgeAttribute>*> edge;
+    std::vector<double> edgeCost;
+    std::vector<double> nodeCost;
+    Adjacency(): g(NULL) {}
+  };
+  Adjacency _adj1;       //!< structures of g1
+  Adjacency _adj2;       //!< structures of g2
+  bool _sharedSource;    //!< true while a batch keeps _adj1 from one pair to another
+
+  IPFPTelemetry _telemetry;  //!< record of the current pair, reset by \ref IPFPsetup
+  double _telemetryStart;    //!< time of the setup of the current pair
+
+  /**
+   * @brief Ensure the workspace can hold \f$(n+1)\times(m+1)\f$ matrices, reallocating it only if it is too small
+   * @note  Reallocation loses the content of the buffers, including <code>Xk</code>
+   */
+  virtual void reserveWorkspace(int n, int m);
+  virtual void releaseWorkspace();
+  void clearAtoms();
+
+  /**
+   * @brief Rebuild the coordinate form of Xk from the dense one, if Xk is sparse enough
+   */
+  void sparsifyIterate();
+
+  /**
+   * @brief Set Xk to the binary matrix of a mapping, in O(n+m) when Xk is in coordinate form
+   */
+  void setIterate(int * G1_to_G2, int * G2_to_G1);
+
+  /**
+   * @brief Xk <- Xk + t(bkp1 - Xk), with bkp1 the binary matrix of the mapping. In coordinate
+   *        form, only the non-zero entries of Xk and bkp1 are updated.
+   */
+  void stepIterate(int * G1_to_G2, int * G2_to_G1, double t);
+
+  /**
+   * @brief List of the entries of the binary matrix of a mapping
+   */
+  void mappingsToSparse(int * G1_to_G2, int * G2_to_G1, int n, int m,
+                        std::vector<std::pair<std::pair<int,int>,double> > & X);
+
+  /**
+   * @brief Move XkD, the quadratic term of a sparse Xk of undirected graphs, to the one of bkp1
+   *
+   *   The quadratic term is linear, and the one of \f$b_{k+1} - X_k\f$ only has non-zero entries
+   *   around the assignments changed : the neighbours of their nodes, and the rows and columns of
+   *   the edges whose deletion or insertion changes. It is computed in coordinate form, in
+   *   \f$O(|E_1| + |E_2| + \sum d_i d_k)\f$ over these assignments when the rows and columns of
+   *   the nodes keep a sum of 1, as between binary matrices.
+   * @return false, leaving XkD unchanged, if the quadratic term of bkp1 is cheaper to compute
+   */
+  bool quadraticStep(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2,
+                     int * G1_to_G2, int * G2_to_G1);
+
+  /**
+   * @brief Line search step of XkD, which \ref quadraticStep left to the quadratic term of bkp1 :
+   *        XkD <- XkD_k + t(XkD - XkD_k), with XkD_k the quadratic term of Xk
+   */
+  void quadraticStepTo(double t);
+
+  /**
+   * @brief Fill the adjacency of g, with the removal costs if source, the insertion costs otherwise
+   */
+  void buildAdjacency(Graph<NodeAttribute,EdgeAttribute> * g, bool source, Adjacency & adj);
+
+  /**
+   * @brief Add the last run of the iterations (k, S) to the telemetry of the pair
+   */
+  void recordRun(bool converged);
+
+  /**
+   * @brief Solve the LSAPE of M with the selected solver, or by \ref sparseLSAPE on the candidates
+   */
+  void solveLinearProblem(Real * M, int * G1_to_G2, int * G2_to_G1, bool warm);
+
+  /**
+   * @brief Mapping of the initialization of the method : the one of <code>_ed_init</code>, or node i
+   *        of g1 to node i of g2 without it. The continuous inits ignore it.
+   */
+  void initialMapping(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2,
+                      int * G1_to_G2, int * G2_to_G1);
+
+  /**
+   * @brief Refine the mapping of (g1,g2) from the given one (warm) or from the initialization of
+   *        the method, and return its edit cost
+   */
+  double refinePair(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2,
+                    int * G1_to_G2, int * G2_to_G1, bool warm);
+
+  /**
+   * @brief Away-step and pairwise Frank-Wolfe iterations, used by \ref IPFPiterations
+   *        according to <code>fwVariant</code>
+   *
+   *   The line search is exact on the objective of the class, whose expansion along the direction
+   *   is given by \ref getDirectionAlpha and \ref getDirectionBeta.
+   */
+  void IPFPactiveSetIterations(Graph<NodeAttribute,EdgeAttribute> * g1,
+			       Graph<NodeAttribute,EdgeAttribute> * g2);
+
   virtual
   void NodeCostMatrix(Graph<NodeAttribute,EdgeAttribute> * g1,
 		      Graph<NodeAttribute,EdgeAttribute> * g2);
   
   virtual
-  double * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+  Real * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
 			 Graph<NodeAttribute,EdgeAttribute> * g2,
-			 int * G1_to_G2, int * G2_to_G1, double * XkD);
-  
+			 int * G1_to_G2, int * G2_to_G1, Real * XkD);
+
+  /**
+   * @brief Quadratic term of a dense matrix. For undirected graphs, it is computed in
+   *        \f$O(|E_1||E_2| + nm\bar{d})\f$ from the adjacencies and the row and column sums of the matrix
+   */
   virtual
-  double * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+  Real * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
                          Graph<NodeAttribute,EdgeAttribute> * g2,
-                         double * Matrix, double * XkD);
+                         Real * Matrix, Real * XkD);
+
+  /**
+   * @brief Quadratic term of a matrix given by its non-zero entries. For undirected graphs, each
+   *        entry \f$x_{ik}\f$ only updates the neighbours of i and k, in \f$O(nm + \sum d_i d_k)\f$
+   */
   virtual
-  double * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+  Real * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
 			 Graph<NodeAttribute,EdgeAttribute> * g2,
-			 std::vector<std::pair<std::pair<int,int>,double> > mappings, double * XkD);
+			 std::vector<std::pair<std::pair<int,int>,double> > mappings, Real * XkD);
 
   //This linearCost is efficient for sparse Xk matrices
   // n is nb rows of matrices, m is nb columns
-  virtual double linearCost(double * CostMatrix, int * G1_to_G2,int * G2_to_G1, int n, int m);
+  virtual double linearCost(Real * CostMatrix, int * G1_to_G2,int * G2_to_G1, int n, int m);
   // n is nb rows of matrices, m is nb columns
-  virtual double linearCost(double * CostMatrix, double * Xk, int n, int m);
+  virtual double linearCost(Real * CostMatrix, Real * Xk, int n, int m);
+  // X given by its non-zero entries, n is nb rows of CostMatrix
+  virtual double linearCost(Real * CostMatrix, const std::vector<std::pair<std::pair<int,int>,double> > & X, int n);
 
   // Fill this->linearSubProblem with appropriatelinear problem
   virtual void LinearSubProblem();
+  // Only update the given entries (sub2ind) of this->linearSubProblem
+  virtual void LinearSubProblem(const std::vector<int> & entries);
   virtual double getCost(int * G1_to_G2,int * G2_to_G1, int n, int m);
-  virtual double getCost(double * Matrix , int n, int m);
+  virtual double getCost(Real * Matrix , int n, int m);
   virtual double getAlpha();
   virtual double getBeta();
 
-  virtual double * mappingsToMatrix(int * G1_to_G2,int * G2_to_G1, int n, int m, double * Matrix);
+  /**
+   * @brief Coefficients of the objective along the direction (<code>_dirX</code>, <code>_dirD</code>)
+   *        of the active set iterations : \f$f(X_k + td) = f(X_k) + t\alpha + t^2\beta\f$
+   */
+  virtual double getDirectionAlpha();
+  virtual double getDirectionBeta();
+
+  virtual Real * mappingsToMatrix(int * G1_to_G2,int * G2_to_G1, int n, int m, Real * Matrix);
 
 
 
 public:
   IPFPGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
 			GraphEditDistance<NodeAttribute,EdgeAttribute> * ed_init):
-    IPFPQAP<NodeAttribute, EdgeAttribute>(costFunction),
+    IPFPQAP<NodeAttribute, EdgeAttribute, Real>(costFunction),
     GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
     _ed_init(ed_init),
+    cleanEdInit(false),
     cleanCostFunction(false),
     useContinuousRandomInit(false),
     useContinuousFlatInit(false),
-    useSinkhorn(false)
+    useSinkhorn(false),
+    _wsRows(0), _wsCols(0), _u(NULL), _v(NULL), _G1_to_G2(NULL), _G2_to_G1(NULL),
+    fwVariant(FW_CLASSIC), _dirX(NULL), _dirD(NULL), _nbLSAPE(0), _nbAwaySteps(0), _nbDropSteps(0),
+    _XkIsSparse(false), _sharedSource(false), _telemetryStart(0)
   {};
     
   IPFPGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction):
-    IPFPQAP<NodeAttribute, EdgeAttribute>(costFunction),
+    IPFPQAP<NodeAttribute, EdgeAttribute, Real>(costFunction),
     GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
     _ed_init(NULL),
+    cleanEdInit(false),
     cleanCostFunction(false),
     useContinuousRandomInit(false),
     useContinuousFlatInit(false),
-    useSinkhorn(false)
+    useSinkhorn(false),
+    _wsRows(0), _wsCols(0), _u(NULL), _v(NULL), _G1_to_G2(NULL), _G2_to_G1(NULL),
+    fwVariant(FW_CLASSIC), _dirX(NULL), _dirD(NULL), _nbLSAPE(0), _nbAwaySteps(0), _nbDropSteps(0),
+    _XkIsSparse(false), _sharedSource(false), _telemetryStart(0)
   {
     this->C = NULL; this->linearSubProblem=NULL; this->XkD=NULL; this->Xk=NULL; this->Lterm=0; this->oldLterm=0;
     this->Xkp1tD=NULL; this->bkp1=NULL; this->_n=-1; this->_m=-1; this->k=-1; this->_directed=false;
@@ -103,9 +300,152 @@ public:
 				 Graph<NodeAttribute,EdgeAttribute> * g2,
 				 int * G1_to_G2, int * G2_to_G1, bool fromInit=true);
 
+  /**
+   * @brief Refine the mappings between g1 and each graph of g2s, from the given mappings
+   *
+   *   The structures of g1 (adjacency lists, node and edge deletion costs) are computed once for the
+   *   whole batch, and the workspace is sized for the largest pair before the first one.
+   */
+  virtual void getBetterMappings(Graph<NodeAttribute,EdgeAttribute> * g1,
+                                 const std::vector<Graph<NodeAttribute,EdgeAttribute> *> & g2s,
+                                 const std::vector<int*> & G1_to_G2s,
+                                 const std::vector<int*> & G2_to_G1s,
+                                 std::vector<IPFPTelemetry> * telemetry = NULL);
+
+  /**
+   * @brief Approximate GED between g1 and each graph of g2s, i.e. a row of a distance matrix or
+   *        the candidates of a query, the refinements being done in batch
+   * @param telemetry  if not NULL, receives the record of each pair
+   */
+  void rowDistances(Graph<NodeAttribute,EdgeAttribute> * g1,
+                    const std::vector<Graph<NodeAttribute,EdgeAttribute> *> & g2s,
+                    double * distances, std::vector<IPFPTelemetry> * telemetry = NULL);
+
+  /**
+   * @brief Distance matrix (column-major) of the frames of a sequence, e.g. the CMU house, where
+   *        close frames have close mappings
+   *
+   *   Pairs are processed by increasing lag. The pairs (s,s+1) are refined from the initialization
+   *   of the method, then (s,s+L) from the composition of the mappings found for (s,s+L-1) and
+   *   (s+L-1,s+L), and (s+L,s) from the inverse of the mapping of (s,s+L). Pairs further than
+   *   maxLag apart (all of them are within it if maxLag < 0) are refined from the initialization.
+   *
+   * @param report  if not NULL, the warm started pairs are also refined from the initialization
+   *                and compared, which doubles their cost
+   */
+  void sequenceDistances(const std::vector<Graph<NodeAttribute,EdgeAttribute> *> & frames,
+                         double * distances, int maxLag = -1, IPFPWarmStartReport * report = NULL);
+
   void IPFPalgorithm(Graph<NodeAttribute,EdgeAttribute> * g1,
 		     Graph<NodeAttribute,EdgeAttribute> * g2);
 
+  /**
+   * @brief Compute the data which only depends on the pair (g1,g2), i.e. the node cost matrix, and the
+   *        quadratic term of the current <code>Xk</code>
+   */
+  void IPFPsetup(Graph<NodeAttribute,EdgeAttribute> * g1,
+		 Graph<NodeAttribute,EdgeAttribute> * g2);
+
+  /**
+   * @brief Run the IPFP iterations from the current <code>Xk</code>, assuming \ref IPFPsetup has been
+   *        called for (g1,g2)
+   *
+   *   On return, <code>XkD</code> and <code>Lterm</code> hold the quadratic and linear terms of the
+   *   returned <code>Xk</code>, so the iterations can be resumed after a change of the objective
+   *   (e.g. a new \f$\zeta\f$ in GNCCP) without recomputing anything.
+   */
+  void IPFPiterations(Graph<NodeAttribute,EdgeAttribute> * g1,
+		      Graph<NodeAttribute,EdgeAttribute> * g2);
+
+  /**
+   * @brief Recompute the quadratic and linear terms of the current <code>Xk</code>, e.g. after it has
+   *        been overwritten through the workspace
+   */
+  void IPFPupdateTerms(Graph<NodeAttribute,EdgeAttribute> * g1,
+		       Graph<NodeAttribute,EdgeAttribute> * g2);
+
+  /**
+   * @brief Number of iterations performed by the last run of the algorithm
+   */
+  int getNbIterations() const { return this->k; }
+
+  /**
+   * @brief Objective values \f$S_0, \ldots, S_k\f$ along the last run of the algorithm
+   */
+  const std::vector<double> & getObjectives() const { return this->S; }
+
+  /**
+   * @brief Number of LSAPE solved by the last call, including the final projection
+   */
+  int getNbLSAPECalls() const { return this->_nbLSAPE; }
+
+  /**
+   * @brief Number of away (or pairwise) steps, and of steps which dropped an atom, in the last call
+   */
+  int getNbAwaySteps() const { return this->_nbAwaySteps; }
+  int getNbDropSteps() const { return this->_nbDropSteps; }
+
+  /**
+   * @brief Record of the last pair : iterations, objectives, steps, times per phase and final gap
+   */
+  const IPFPTelemetry & getTelemetry() const { return this->_telemetry; }
+
+  /**
+   * @brief  Select the step rule of the Frank-Wolfe iterations, \ref FW_CLASSIC by default
+   *
+   *   The away-step and pairwise variants keep Xk as a convex combination of the visited LSAPE
+   *   solutions, which avoids the zig-zag of the classic iterations near the optimum.
+   *   The linear subproblem and the stopping criterion are the same for all variants.
+   */
+  void frankWolfeVariant(FWVariant variant){
+    this->fwVariant = variant;
+  }
+
+  /**
+   * @brief  Largest proportion of non-zero entries for which Xk is kept in coordinate form, 0 to always
+   *         work on the dense Xk
+   */
+  void setSparseDensity(double density){
+    this->_sparseDensity = density;
+  }
+
+  /**
+   * @brief  Select the solver of the LSAPE, \ref LSAPE_HUNGARIAN by default
+   *
+   *   With \ref LSAPE_JV, the linear subproblem of an iteration starts from the duals and the
+   *   solution of the previous one, which are close to optimal when Xk moves little.
+   */
+  void lsapeSolver(LSAPESolver solver){
+    this->_lsapeSolver = solver;
+  }
+
+  LSAPESolver getLSAPESolver() const { return this->_lsapeSolver; }
+
+  /**
+   * @brief  Warm start the first LSAPE of a call from the duals and the solution of the previous
+   *         call on the same pair, e.g. the previous zeta of GNCCP. Only used by \ref LSAPE_JV
+   */
+  void keepDualsAcrossCalls(bool yes=true){
+    this->_keepDuals = yes;
+  }
+
+  FWVariant getFrankWolfeVariant() const { return this->fwVariant; }
+  LSAPECandidates getCandidates() const { return this->_candidates; }
+  double getCandidatesParam() const { return this->_candidatesParam; }
+  double getSparseDensity() const { return this->_sparseDensity; }
+
+  /**
+   * @brief  Restrict the substitutions to candidates, \ref CANDIDATES_ALL by default
+   *
+   *   Candidates are selected on the node substitution costs, see \ref selectCandidates. The
+   *   linear subproblems and the final projection are then solved by \ref sparseLSAPE, so the
+   *   iterates only mix candidate substitutions. The matrices of the iterations stay dense.
+   */
+  void candidates(LSAPECandidates mode, double param = 0){
+    this->_candidates = mode;
+    this->_candidatesParam = param;
+  }
+
 
 
   virtual double mappingCost( Graph<NodeAttribute,EdgeAttribute> * g1,
@@ -154,15 +494,22 @@ public:
    *  If <code>nJ==NULL</code>, then the geometrical barycenter of error correcting doubly stochastic matrices
    *   \f$J = \frac{2(n+1)\times(m+1)}{n+m+2}\f$ will be used
    */
-  virtual void recenterInit(double* nJ, int n, int m);
+  virtual void recenterInit(Real * nJ, int n, int m);
   
   IPFPGraphEditDistance * clone() const { return new IPFPGraphEditDistance(*this); }
   
+  /**
+   * @brief The cost function and the initialization method are cloned, so copies may be used by different threads
+   */
   IPFPGraphEditDistance( const IPFPGraphEditDistance& other ) :
-    IPFPQAP<NodeAttribute,EdgeAttribute>(NULL),
+    IPFPQAP<NodeAttribute,EdgeAttribute, Real>(NULL),
     GraphEditDistance<NodeAttribute, EdgeAttribute>(NULL),
-    _ed_init(other._ed_init),
-    cleanCostFunction(true)
+    _ed_init(other._ed_init ? other._ed_init->clone() : NULL),
+    cleanEdInit(other._ed_init != NULL),
+    cleanCostFunction(true),
+    _wsRows(0), _wsCols(0), _u(NULL), _v(NULL), _G1_to_G2(NULL), _G2_to_G1(NULL),
+    fwVariant(FW_CLASSIC), _dirX(NULL), _dirD(NULL), _nbLSAPE(0), _nbAwaySteps(0), _nbDropSteps(0),
+    _XkIsSparse(false), _sharedSource(false), _telemetryStart(0)
   {
     this->cf = other.cf->clone();
     this->costFunction = this->cf;
@@ -170,28 +517,32 @@ public:
     this->useContinuousRandomInit = other.useContinuousRandomInit;
     this->useContinuousFlatInit = other.useContinuousFlatInit;
     this->useSinkhorn = other.useSinkhorn;
+    this->fwVariant = other.fwVariant;
+    this->_sparseDensity = other._sparseDensity;
+    this->_lsapeSolver = other._lsapeSolver;
+    this->_candidates = other._candidates;
+    this->_candidatesParam = other._candidatesParam;
+    this->_keepDuals = other._keepDuals;
+    this->_budget = other._budget;
     this->J=NULL;
   }
 
   virtual ~IPFPGraphEditDistance(){
-    if (this->C != NULL) delete [] this->C;
-    if (this->linearSubProblem != NULL) delete [] this->linearSubProblem;
-    if (this->XkD != NULL) delete [] this->XkD;
-    if (this->Xk != NULL) delete [] this->Xk;
-    if (this->Xkp1tD != NULL) delete [] this->Xkp1tD;
-    if (this->bkp1 != NULL) delete [] this->bkp1;
+    this->releaseWorkspace();
+    this->clearAtoms();
     if (this->cleanCostFunction) delete this->cf;
+    if (this->cleanEdInit) delete this->_ed_init;
   }
 
 };
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
-recenterInit(double * nJ, int n, int m)
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+recenterInit(Real * nJ, int n, int m)
 {
   if ( this->J != NULL) delete[] this->J;
-  this->J = new double[(n+1)*(m+1)];
+  this->J = new Real[(n+1)*(m+1)];
   
   this->recenter = true;
   if (nJ == NULL){
@@ -208,95 +559,267 @@ recenterInit(double * nJ, int n, int m)
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::NodeCostMatrix(Graph<NodeAttribute,EdgeAttribute> * g1,
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+reserveWorkspace(int n, int m)
+{
+  if (n+1 <= _wsRows && m+1 <= _wsCols) return;
+
+  this->releaseWorkspace();
+  _wsRows = n+1;
+  _wsCols = m+1;
+  int size = _wsRows * _wsCols;
+
+  this->C = new Real[size];
+  this->linearSubProblem = new Real[size];
+  this->XkD = new Real[size];
+  this->Xk = new Real[size];
+  this->Xkp1tD = new Real[size];
+  this->bkp1 = new Real[size];
+  _dirX = new Real[size];
+  _dirD = new Real[size];
+  _u = new Real[_wsRows];
+  _v = new Real[_wsCols];
+  _G1_to_G2 = new int[_wsRows];
+  _G2_to_G1 = new int[_wsCols];
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+releaseWorkspace()
+{
+  delete [] this->C; this->C = NULL;
+  delete [] this->linearSubProblem; this->linearSubProblem = NULL;
+  delete [] this->XkD; this->XkD = NULL;
+  delete [] this->Xk; this->Xk = NULL;
+  delete [] this->Xkp1tD; this->Xkp1tD = NULL;
+  delete [] this->bkp1; this->bkp1 = NULL;
+  delete [] _dirX; _dirX = NULL;
+  delete [] _dirD; _dirD = NULL;
+  delete [] _u; _u = NULL;
+  delete [] _v; _v = NULL;
+  delete [] _G1_to_G2; _G1_to_G2 = NULL;
+  delete [] _G2_to_G1; _G2_to_G1 = NULL;
+  _wsRows = 0;
+  _wsCols = 0;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+clearAtoms()
+{
+  for (unsigned int a=0; a<_atomsX.size(); a++){
+    delete [] _atomsX[a];
+    delete [] _atomsD[a];
+  }
+  _atomsX.clear();
+  _atomsD.clear();
+  _atomsW.clear();
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::NodeCostMatrix(Graph<NodeAttribute,EdgeAttribute> * g1,
 									 Graph<NodeAttribute,EdgeAttribute> * g2){
   int n=g1->Size();
   int m=g2->Size();
 
-  this->C = new double[(n+1)*(m+1)];
+  if (!(this->C))
+    this->C = new Real[(n+1)*(m+1)];
   //memset(this->C,std::numeric_limits<double>::max(),sizeof(double)*(n+1)*(m+1));
   this->C[sub2ind(n,m,(n+1))] = 0;
   for(int i=0;i<n;i++)
     for(int j=0;j<m;j++)
       this->C[sub2ind(i,j,(n+1))] = this->cf->NodeSubstitutionCost((*g1)[i],(*g2)[j],g1,g2);
   
+  if (this->_adj1.g != g1) this->buildAdjacency(g1, true, this->_adj1);
+  if (this->_adj2.g != g2) this->buildAdjacency(g2, false, this->_adj2);
   for(int i=0;i<n;i++)
-    this->C[sub2ind(i,m,(n+1))] = this->cf->NodeDeletionCost((*g1)[i],g1);
+    this->C[sub2ind(i,m,(n+1))] = this->_adj1.nodeCost[i];
 
   for(int j=0;j<m;j++)
-    this->C[sub2ind(n,j,(n+1))] = this->cf->NodeInsertionCost((*g2)[j],g2);
+    this->C[sub2ind(n,j,(n+1))] = this->_adj2.nodeCost[j];
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double * IPFPGraphEditDistance<NodeAttribute,
-			       EdgeAttribute>::QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+buildAdjacency(Graph<NodeAttribute,EdgeAttribute> * g, bool source, Adjacency & adj)
+{
+  int n = g->Size();
+  adj.g = g;
+  adj.ptr.assign(1, 0);
+  adj.node.clear();
+  adj.edge.clear();
+  adj.edgeCost.clear();
+  adj.nodeCost.resize(n);
+  for (int i=0; i<n; i++){
+    adj.nodeCost[i] = source ? this->cf->NodeDeletionCost((*g)[i],g) : this->cf->NodeInsertionCost((*g)[i],g);
+    for (GEdge<EdgeAttribute> * e = (*g)[i]->getIncidentEdges(); e; e = e->Next()){
+      if (e->IncidentNode() == i) continue;
+      adj.node.push_back(e->IncidentNode());
+      adj.edge.push_back(e);
+      adj.edgeCost.push_back(source ? this->cf->EdgeDeletionCost(e,g) : this->cf->EdgeInsertionCost(e,g));
+    }
+    adj.ptr.push_back(adj.node.size());
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+Real * IPFPGraphEditDistance<NodeAttribute,
+			       EdgeAttribute, Real>::QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
 							     Graph<NodeAttribute,EdgeAttribute> * g2,
-							     double * Matrix, double * XkD){
+							     Real * Matrix, Real * XkD){
   int n = g1->Size();
   int m = g2->Size();
-
-  std::vector<std::pair<std::pair<int,int>, double>> mappings;
-  for(int i=0;i<n+1;i++)
-    for(int j=0;j<m+1;j++){
-      double value = Matrix[sub2ind(i,j,n+1)];
-      if(value > 0.){
-	std::pair<int,int> tmp = std::pair<int,int>(i,j);
-	mappings.push_back(std::pair<std::pair<int,int>,double>(tmp,value));
+  if (!XkD)
+    XkD=new Real[(n+1)*(m+1)];
+
+  if (this->_directed){
+    std::vector<std::pair<std::pair<int,int>, double>> mappings;
+    for(int i=0;i<n+1;i++)
+      for(int j=0;j<m+1;j++){
+        double value = Matrix[sub2ind(i,j,n+1)];
+        if(value > 0.){
+          std::pair<int,int> tmp = std::pair<int,int>(i,j);
+          mappings.push_back(std::pair<std::pair<int,int>,double>(tmp,value));
+        }
       }
-    }
-  if (!(this->XkD))
-    this->XkD=new double[(n+1)*(m+1)];
+    return this->QuadraticTerm(g1,g2,mappings, XkD);
+  }
 
-  return this->QuadraticTerm(g1,g2,mappings, this->XkD);
+  if (this->_adj1.g != g1) this->buildAdjacency(g1, true, this->_adj1);
+  if (this->_adj2.g != g2) this->buildAdjacency(g2, false, this->_adj2);
+  const Adjacency & A1 = this->_adj1;
+  const Adjacency & A2 = this->_adj2;
+
+  Map<MatrixR> m_X(Matrix, n+1, m+1);
+  Map<MatrixR> m_D(XkD, n+1, m+1);
+  Eigen::Matrix<Real, Dynamic, 1> r = m_X.rowwise().sum();
+  Eigen::Matrix<Real, Dynamic, 1> c = m_X.colwise().sum().transpose();
+  m_D.setZero();
+
+  // For an edge (i,j) of g1 and (k,l) of g2, x_ik contributes to d_jl with the substitution cost
+  // and, if only one of them exists, with its deletion or insertion cost. The latter
+  // contributions are summed through the row and column sums of X.
+  for (int j=0; j<n; j++)
+    for (int p=A1.ptr[j]; p<A1.ptr[j+1]; p++){
+      int i = A1.node[p];
+      double del = A1.edgeCost[p];
+      m_D(j,m) += del * r(i);
+      for (int l=0; l<m; l++)
+        m_D(j,l) += del * (r(i) - m_X(i,l));
+    }
+  for (int l=0; l<m; l++)
+    for (int q=A2.ptr[l]; q<A2.ptr[l+1]; q++){
+      int k = A2.node[q];
+      double ins = A2.edgeCost[q];
+      m_D(n,l) += ins * c(k);
+      for (int j=0; j<n; j++)
+        m_D(j,l) += ins * (c(k) - m_X(j,k));
+    }
+  for (int j=0; j<n; j++)
+    for (int p=A1.ptr[j]; p<A1.ptr[j+1]; p++){
+      int i = A1.node[p];
+      for (int l=0; l<m; l++)
+        for (int q=A2.ptr[l]; q<A2.ptr[l+1]; q++){
+          double cost = this->cf->EdgeSubstitutionCost(A1.edge[p],A2.edge[q],g1,g2) - A1.edgeCost[p] - A2.edgeCost[q];
+          m_D(j,l) += cost * m_X(i,A2.node[q]);
+        }
+    }
+  m_D *= 0.5;
+  return XkD;
 
 }
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double * IPFPGraphEditDistance<NodeAttribute,
-			       EdgeAttribute>::QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+template<class NodeAttribute, class EdgeAttribute, class Real>
+Real * IPFPGraphEditDistance<NodeAttribute,
+			       EdgeAttribute, Real>::QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
 							     Graph<NodeAttribute,EdgeAttribute> * g2,
-							     int * G1_to_G2, int * G2_to_G1,double * XkD){
+							     int * G1_to_G2, int * G2_to_G1,Real * XkD){
 
   int n = g1->Size();
   int m = g2->Size();
 
   //Reconstruction d'un mapping
   std::vector<std::pair<std::pair<int,int>, double>> mappings;
-  for (int i =0;i<n;i++){
-    std::pair<int,int> tmp = std::pair<int,int>(i,G1_to_G2[i]);
-    mappings.push_back(std::pair<std::pair<int,int>,double>(tmp,1.));
-  }
-  for (int j =0;j<m;j++)
-    if (G2_to_G1[j] >= n){
-      std::pair<int,int> tmp = std::pair<int,int>(G2_to_G1[j],j);
-      mappings.push_back(std::pair<std::pair<int,int>,double>(tmp,1.));
-    }
-  if (!(this->XkD))
-    XkD=new double[(n+1)*(m+1)];
+  this->mappingsToSparse(G1_to_G2, G2_to_G1, n, m, mappings);
+  if (!XkD)
+    XkD=new Real[(n+1)*(m+1)];
 
-  return this->QuadraticTerm(g1,g2,mappings,this->XkD);
+  return this->QuadraticTerm(g1,g2,mappings,XkD);
 
 }
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double * IPFPGraphEditDistance<NodeAttribute,
-			       EdgeAttribute>::QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+template<class NodeAttribute, class EdgeAttribute, class Real>
+Real * IPFPGraphEditDistance<NodeAttribute,
+			       EdgeAttribute, Real>::QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
 							     Graph<NodeAttribute,EdgeAttribute> * g2,
 							     std::vector<std::pair<std::pair<int,int>,double> > mappings,
-							     double * quadraticTerm){
+							     Real * quadraticTerm){
   int n = g1->Size();
   int m = g2->Size();
 
   if (! quadraticTerm)
-    quadraticTerm=new double[(n+1)*(m+1)];
+    quadraticTerm=new Real[(n+1)*(m+1)];
+
+  if (! this->_directed){
+    if (this->_adj1.g != g1) this->buildAdjacency(g1, true, this->_adj1);
+    if (this->_adj2.g != g2) this->buildAdjacency(g2, false, this->_adj2);
+    const Adjacency & A1 = this->_adj1;
+    const Adjacency & A2 = this->_adj2;
+
+    // Deletions and insertions of edges only depend on the row and column sums of X,
+    // except when the other end of the edge is mapped by the same entry
+    std::vector<double> r(n+1, 0.);
+    std::vector<double> c(m+1, 0.);
+    std::vector<std::pair<std::pair<int,int>,double> >::iterator it;
+    for (it = mappings.begin(); it != mappings.end(); it++){
+      r[it->first.first] += it->second;
+      c[it->first.second] += it->second;
+    }
+    std::vector<double> del(n+1, 0.);
+    std::vector<double> ins(m+1, 0.);
+    for (int j=0; j<n; j++)
+      for (int p=A1.ptr[j]; p<A1.ptr[j+1]; p++)
+        del[j] += A1.edgeCost[p] * r[A1.node[p]];
+    for (int l=0; l<m; l++)
+      for (int q=A2.ptr[l]; q<A2.ptr[l+1]; q++)
+        ins[l] += A2.edgeCost[q] * c[A2.node[q]];
+    for (int l=0; l<m+1; l++)
+      for (int j=0; j<n+1; j++)
+        quadraticTerm[sub2ind(j,l,n+1)] = del[j] + ins[l];
+
+    // Each substitution x_ik only changes the entries of the neighbours of i and k
+    for (it = mappings.begin(); it != mappings.end(); it++){
+      int i = it->first.first;
+      int k = it->first.second;
+      double x = it->second;
+      if (i >= n || k >= m) continue;
+      for (int q=A2.ptr[k]; q<A2.ptr[k+1]; q++)
+        quadraticTerm[sub2ind(i,A2.node[q],n+1)] -= A2.edgeCost[q] * x;
+      for (int p=A1.ptr[i]; p<A1.ptr[i+1]; p++){
+        int j = A1.node[p];
+        quadraticTerm[sub2ind(j,k,n+1)] -= A1.edgeCost[p] * x;
+        for (int q=A2.ptr[k]; q<A2.ptr[k+1]; q++){
+          double cost = this->cf->EdgeSubstitutionCost(A1.edge[p],A2.edge[q],g1,g2) - A1.edgeCost[p] - A2.edgeCost[q];
+          quadraticTerm[sub2ind(j,A2.node[q],n+1)] += cost * x;
+        }
+      }
+    }
+    Map<MatrixR> m_D(quadraticTerm, n+1, m+1);
+    m_D *= 0.5;
+    return quadraticTerm;
+  }
 
-  memset(quadraticTerm,0,sizeof(double)*(n+1)*(m+1));
+  memset(quadraticTerm,0,sizeof(Real)*(n+1)*(m+1));
 
   for(int j = 0; j < n+1; j++){ // Attention : dans le papier sspr, condition sur x_jl /= 0. En effet, inutile pour le cas ou on multiplie a droite par le mapping. Mais nécessaire quand on utilise XtD dans le sous probleme
     for(int l = 0; l < m+1;l++){
@@ -366,23 +889,38 @@ double * IPFPGraphEditDistance<NodeAttribute,
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getOptimalMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
                    Graph<NodeAttribute,EdgeAttribute> * g2,
                    int * G1_to_G2, int * G2_to_G1 )
 {
   //Compute Mapping init
-  if (this->_ed_init)
-    this->_ed_init->getOptimalMapping(g1,g2,G1_to_G2, G2_to_G1);
+  this->initialMapping(g1, g2, G1_to_G2, G2_to_G1);
 
   getBetterMapping(g1, g2, G1_to_G2, G2_to_G1);
 }
 
 
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+initialMapping(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2,
+               int * G1_to_G2, int * G2_to_G1)
+{
+  if (this->_ed_init){
+    this->_ed_init->getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    return;
+  }
+  int n = g1->Size();
+  int m = g2->Size();
+  for (int i=0; i<n; i++) G1_to_G2[i] = (i < m) ? i : m;
+  for (int j=0; j<m; j++) G2_to_G1[j] = (j < n) ? j : n;
+}
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getBetterMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
                   Graph<NodeAttribute,EdgeAttribute> * g2,
                   int * G1_to_G2, int * G2_to_G1, bool fromInit)
@@ -390,8 +928,8 @@ getBetterMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
   this->_n = g1->Size();
   this->_m = g2->Size();
 
-  this->Xk = new double[(this->_n+1)*(  this->_m+1)];
-  Map<MatrixXd> m_Xk(this->Xk,  this->_n+1,  this->_m+1);
+  this->reserveWorkspace(this->_n, this->_m);
+  Map<MatrixR> m_Xk(this->Xk,  this->_n+1,  this->_m+1);
   
   if (!useContinuousRandomInit && !useContinuousFlatInit)
     this->Xk = this->mappingsToMatrix(G1_to_G2,G2_to_G1,this->_n,this->_m,this->Xk);
@@ -399,24 +937,203 @@ getBetterMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
   this->IPFPalgorithm(g1,g2);
 
 
-  m_Xk= MatrixXd::Ones(this->_n+1, this->_m+1)-m_Xk;
-  double *u = new double[this->_n+1];
-  double *v = new double[this->_m+1];
-  hungarianLSAPE(this->Xk,  this->_n+1,  this->_m+1, G1_to_G2,G2_to_G1, u,v,false);
-  delete [] this->Xk; this->Xk=0;
-  delete [] u;
-  delete [] v;
+  m_Xk= MatrixR::Ones(this->_n+1, this->_m+1)-m_Xk;
+  double t = IPFPTelemetry::clock();
+  this->solveLinearProblem(this->Xk, G1_to_G2, G2_to_G1, false);
+  this->_nbLSAPE++;
+  this->_telemetry.nbLSAPE++;
+  this->_telemetry.timeLSAPE += IPFPTelemetry::clock() - t;
+  this->_telemetry.timeTotal = IPFPTelemetry::clock() - this->_telemetryStart;
+}
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+getBetterMappings(Graph<NodeAttribute,EdgeAttribute> * g1,
+                  const std::vector<Graph<NodeAttribute,EdgeAttribute> *> & g2s,
+                  const std::vector<int*> & G1_to_G2s,
+                  const std::vector<int*> & G2_to_G1s,
+                  std::vector<IPFPTelemetry> * telemetry)
+{
+  int mMax = 0;
+  for (unsigned int p=0; p<g2s.size(); p++)
+    mMax = std::max(mMax, g2s[p]->Size());
+  this->reserveWorkspace(g1->Size(), mMax);
+
+  this->buildAdjacency(g1, true, this->_adj1);
+  this->_sharedSource = true;
+  if (telemetry) telemetry->clear();
+  for (unsigned int p=0; p<g2s.size(); p++){
+    this->getBetterMapping(g1, g2s[p], G1_to_G2s[p], G2_to_G1s[p]);
+    if (telemetry) telemetry->push_back(this->_telemetry);
+  }
+  this->_sharedSource = false;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+rowDistances(Graph<NodeAttribute,EdgeAttribute> * g1,
+             const std::vector<Graph<NodeAttribute,EdgeAttribute> *> & g2s,
+             double * distances, std::vector<IPFPTelemetry> * telemetry)
+{
+  int n = g1->Size();
+  std::vector<int*> G1_to_G2s(g2s.size());
+  std::vector<int*> G2_to_G1s(g2s.size());
+  for (unsigned int p=0; p<g2s.size(); p++){
+    G1_to_G2s[p] = new int[n];
+    G2_to_G1s[p] = new int[g2s[p]->Size()];
+    this->initialMapping(g1, g2s[p], G1_to_G2s[p], G2_to_G1s[p]);
+  }
+
+  this->getBetterMappings(g1, g2s, G1_to_G2s, G2_to_G1s, telemetry);
+
+  for (unsigned int p=0; p<g2s.size(); p++){
+    distances[p] = this->GedFromMapping(g1, g2s[p], G1_to_G2s[p], n, G2_to_G1s[p], g2s[p]->Size());
+    delete [] G1_to_G2s[p];
+    delete [] G2_to_G1s[p];
+  }
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+refinePair(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2,
+           int * G1_to_G2, int * G2_to_G1, bool warm)
+{
+  if (warm){
+    // The given mapping is the init, whatever the continuous init of the method
+    bool randomInit = this->useContinuousRandomInit;
+    bool flatInit = this->useContinuousFlatInit;
+    this->useContinuousRandomInit = false;
+    this->useContinuousFlatInit = false;
+    this->getBetterMapping(g1, g2, G1_to_G2, G2_to_G1);
+    this->useContinuousRandomInit = randomInit;
+    this->useContinuousFlatInit = flatInit;
+  }
+  else
+    this->getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+  return this->GedFromMapping(g1, g2, G1_to_G2, g1->Size(), G2_to_G1, g2->Size());
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+sequenceDistances(const std::vector<Graph<NodeAttribute,EdgeAttribute> *> & frames,
+                  double * distances, int maxLag, IPFPWarmStartReport * report)
+{
+  const int N = frames.size();
+  if (maxLag < 0 || maxLag > N-1) maxLag = N-1;
+  if (report) report->clear();
+
+  // Mappings of (s,s+1), of (s,s+L-1) and of (s,s+L) : G1_to_G2 then G2_to_G1
+  std::vector<int*> next(2*N, (int*)NULL), prev(2*N, (int*)NULL), cur(2*N, (int*)NULL);
+  bool prevOwned = false;
+
+  for (int s=0; s<N; s++){
+    int n = frames[s]->Size();
+    int * identity = new int[n];
+    for (int i=0; i<n; i++) identity[i] = i;
+    distances[sub2ind(s,s,N)] = this->GedFromMapping(frames[s], frames[s], identity, n, identity, n);
+    delete [] identity;
+  }
+
+  for (int L=1; L<N; L++){
+    for (int s=0; s+L<N; s++){
+      int t = s+L;
+      Graph<NodeAttribute,EdgeAttribute> * g1 = frames[s];
+      Graph<NodeAttribute,EdgeAttribute> * g2 = frames[t];
+      int n = g1->Size();
+      int m = g2->Size();
+      int * G1_to_G2 = new int[n];
+      int * G2_to_G1 = new int[m];
+      int * H1_to_H2 = new int[m]; // mapping of the reverse pair (t,s)
+      int * H2_to_G1 = new int[n];
+
+      if (L > maxLag){
+        distances[sub2ind(s,t,N)] = refinePair(g1, g2, G1_to_G2, G2_to_G1, false);
+        distances[sub2ind(t,s,N)] = refinePair(g2, g1, H1_to_H2, H2_to_G1, false);
+        delete [] G1_to_G2; delete [] G2_to_G1;
+        delete [] H1_to_H2; delete [] H2_to_G1;
+        continue;
+      }
+
+      bool warm = (L > 1);
+      if (warm){
+        // (s,t-1) then (t-1,t)
+        int u = frames[t-1]->Size();
+        const int * a = prev[2*s];
+        const int * b = next[2*(t-1)];
+        for (int i=0; i<n; i++) G1_to_G2[i] = (a[i] < u) ? b[a[i]] : m;
+        for (int j=0; j<m; j++) G2_to_G1[j] = n;
+        for (int i=0; i<n; i++) if (G1_to_G2[i] < m) G2_to_G1[G1_to_G2[i]] = i;
+      }
+
+      // Forward pair, from the composed mapping. The cold refinements of the report start from the
+      // initialization of the method, in their own mappings.
+      int * cold = new int[n+m];
+      double t0 = IPFPTelemetry::clock();
+      distances[sub2ind(s,t,N)] = refinePair(g1, g2, G1_to_G2, G2_to_G1, warm);
+      if (warm && report){
+        report->nbPairs++;
+        report->iterationsWarm += this->_telemetry.iterations;
+        report->distanceWarm += distances[sub2ind(s,t,N)];
+        report->timeWarm += IPFPTelemetry::clock() - t0;
+        t0 = IPFPTelemetry::clock();
+        report->distanceCold += refinePair(g1, g2, cold, cold+n, false);
+        report->iterationsCold += this->_telemetry.iterations;
+        report->timeCold += IPFPTelemetry::clock() - t0;
+      }
+
+      // Reverse pair, from the inverse of the forward mapping
+      memcpy(H1_to_H2, G2_to_G1, m*sizeof(int));
+      memcpy(H2_to_G1, G1_to_G2, n*sizeof(int));
+      t0 = IPFPTelemetry::clock();
+      distances[sub2ind(t,s,N)] = refinePair(g2, g1, H1_to_H2, H2_to_G1, true);
+      if (report){
+        report->nbPairs++;
+        report->iterationsWarm += this->_telemetry.iterations;
+        report->distanceWarm += distances[sub2ind(t,s,N)];
+        report->timeWarm += IPFPTelemetry::clock() - t0;
+        t0 = IPFPTelemetry::clock();
+        report->distanceCold += refinePair(g2, g1, cold, cold+m, false);
+        report->iterationsCold += this->_telemetry.iterations;
+        report->timeCold += IPFPTelemetry::clock() - t0;
+      }
+      delete [] cold;
+      delete [] H1_to_H2;
+      delete [] H2_to_G1;
+
+      if (L == 1){
+        next[2*s] = G1_to_G2;
+        next[2*s+1] = G2_to_G1;
+      }else{
+        cur[2*s] = G1_to_G2;
+        cur[2*s+1] = G2_to_G1;
+      }
+    }
+
+    // The mappings of lag L are the prev of lag L+1, the ones of lag 1 are kept in next
+    if (prevOwned)
+      for (int p=0; p<2*N; p++) delete [] prev[p];
+    prev = (L == 1) ? next : cur;
+    prevOwned = (L > 1);
+    cur.assign(2*N, (int*)NULL);
+  }
+  for (int p=0; p<2*N; p++) delete [] next[p];
+  if (prevOwned)
+    for (int p=0; p<2*N; p++) delete [] prev[p];
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 IPFPalgorithm(Graph<NodeAttribute,EdgeAttribute> * g1,
 	      Graph<NodeAttribute,EdgeAttribute> * g2)
 {
 
   // If use a random bistochastic continuous matrix :
   if (useContinuousRandomInit){
-    double* _I = randBiStochExt<double,int>(this->_n, this->_m);
+    Real * _I = randBiStochExt<Real,int>(this->_n, this->_m);
     reduceExt(_I, this->_n, this->_m, this->Xk);
     delete [] _I;
   }
@@ -438,72 +1155,410 @@ IPFPalgorithm(Graph<NodeAttribute,EdgeAttribute> * g1,
         this->Xk[sub2ind(i,j,this->_n+1)] = (this->Xk[sub2ind(i,j,this->_n+1)] + this->J[sub2ind(i,j,this->_n+1)]) / 2;
   }
 
-  this->_directed = (g1->isDirected() && g2->isDirected());
   //We assume that Xk is filled with a matrix, binary or not
+  this->IPFPsetup(g1,g2);
+  this->IPFPiterations(g1,g2);
+}
 
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+IPFPsetup(Graph<NodeAttribute,EdgeAttribute> * g1,
+	  Graph<NodeAttribute,EdgeAttribute> * g2)
+{
+  this->_telemetry.clear();
+  this->_telemetryStart = IPFPTelemetry::clock();
+  this->_dualsValid = false;
+  this->_directed = (g1->isDirected() && g2->isDirected());
   this->_n = g1->Size();
   this->_m = g2->Size();
+  this->reserveWorkspace(this->_n, this->_m);
+
+  // Graphs may have changed since the last pair, only a batch keeps the structures of g1
+  if (!this->_sharedSource) this->buildAdjacency(g1, true, this->_adj1);
+  this->buildAdjacency(g2, false, this->_adj2);
+  NodeCostMatrix(g1,g2);
+  if (this->_candidates == CANDIDATES_USEFUL){
+    // Bounds of the stars : the node and its incident edges
+    SparseCostMatrix<Real> & S = this->_sparseLSAPE;
+    S.del.resize(this->_n);
+    S.ins.resize(this->_m);
+    for (int i=0; i<this->_n; i++){
+      S.del[i] = this->_adj1.nodeCost[i];
+      for (int p=this->_adj1.ptr[i]; p<this->_adj1.ptr[i+1]; p++) S.del[i] += this->_adj1.edgeCost[p];
+    }
+    for (int j=0; j<this->_m; j++){
+      S.ins[j] = this->_adj2.nodeCost[j];
+      for (int p=this->_adj2.ptr[j]; p<this->_adj2.ptr[j+1]; p++) S.ins[j] += this->_adj2.edgeCost[p];
+    }
+    usefulCandidates(g1, g2, this->cf, S);
+  }
+  else if (this->_candidates != CANDIDATES_ALL){
+    const Real * C = this->C;
+    const int nrows = this->_n+1;
+    selectCandidates<Real>(this->_n, this->_m, [&](int i, int j){ return C[sub2ind(i,j,nrows)]; },
+                           this->_candidates, this->_candidatesParam, this->_sparseLSAPE);
+  }
+  this->IPFPupdateTerms(g1,g2);
+}
 
-  this->S.clear();
-  this->R.clear();
 
-  NodeCostMatrix(g1,g2);//REdondant for GNCCP
-  Map<MatrixXd> m_C(this->C,this->_n+1,this->_m+1); //REdondant for GNCCP
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+solveLinearProblem(Real * M, int * G1_to_G2, int * G2_to_G1, bool warm)
+{
+  if (this->_candidates != CANDIDATES_ALL){
+    this->_sparseLSAPE.gather(M);
+    sparseLSAPE(this->_sparseLSAPE, G1_to_G2, G2_to_G1);
+  }
+  else
+    solveLSAPE(this->_lsapeSolver, M, this->_n+1, this->_m+1, G1_to_G2, G2_to_G1,
+               this->_u, this->_v, warm, warm);
+}
+
 
-  this->bkp1 = new double [(  this->_n+1) * (  this->_m+1)];
-  Map<MatrixXd> m_bkp1 (this->bkp1,  this->_n+1,  this->_m+1);
-  //this->bkp1 = mappingsToMatrix(G1_to_G2,G2_to_G1,  this->_n,  this->_m,this->bkp1);
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+IPFPupdateTerms(Graph<NodeAttribute,EdgeAttribute> * g1,
+		Graph<NodeAttribute,EdgeAttribute> * g2)
+{
+  double t = IPFPTelemetry::clock();
+  this->sparsifyIterate();
+  if (this->_XkIsSparse){
+    this->XkD = this->QuadraticTerm(g1,g2,this->_XkSparse,this->XkD);
+    this->Lterm = linearCost(this->C,this->_XkSparse,  this->_n+1);
+  }else{
+    this->XkD = this->QuadraticTerm(g1,g2,this->Xk,this->XkD);
+    this->Lterm = linearCost(this->C,this->Xk,  this->_n+1,  this->_m+1);
+  }
+  this->_telemetry.timeQuadratic += IPFPTelemetry::clock() - t;
+}
 
-  this->XkD = this->QuadraticTerm(g1,g2,this->Xk,NULL); //REdondant for GNCCP
-  Map<MatrixXd> m_XkD(this->XkD,  this->_n+1,  this->_m+1);
 
-  Map<MatrixXd> m_Xk(this->Xk,  this->_n+1,  this->_m+1);
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+sparsifyIterate()
+{
+  int rows = this->_n+1;
+  int cols = this->_m+1;
+  unsigned int maxNnz = this->_sparseDensity * rows * cols;
+  this->_XkSparse.clear();
+  this->_XkIsSparse = false;
+  for (int j=0; j<cols; j++)
+    for (int i=0; i<rows; i++)
+      if (this->Xk[sub2ind(i,j,rows)] != 0){
+        if (this->_XkSparse.size() >= maxNnz){
+          this->_XkSparse.clear();
+          return;
+        }
+        std::pair<int,int> tmp = std::pair<int,int>(i,j);
+        this->_XkSparse.push_back(std::pair<std::pair<int,int>,double>(tmp,this->Xk[sub2ind(i,j,rows)]));
+      }
+  std::sort(this->_XkSparse.begin(), this->_XkSparse.end());
+  this->_XkIsSparse = true;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+setIterate(int * G1_to_G2, int * G2_to_G1)
+{
+  int rows = this->_n+1;
+  if (this->_XkIsSparse){
+    std::vector<std::pair<std::pair<int,int>,double> >::iterator it;
+    for (it = this->_XkSparse.begin(); it != this->_XkSparse.end(); it++)
+      this->Xk[sub2ind(it->first.first,it->first.second,rows)] = 0;
+  }else
+    memset(this->Xk,0,sizeof(Real)*rows*(this->_m+1));
+
+  // A binary Xk has at most n+m non-zero entries
+  this->mappingsToSparse(G1_to_G2, G2_to_G1, this->_n, this->_m, this->_XkSparse);
+  std::vector<std::pair<std::pair<int,int>,double> >::iterator it;
+  for (it = this->_XkSparse.begin(); it != this->_XkSparse.end(); it++)
+    this->Xk[sub2ind(it->first.first,it->first.second,rows)] = 1;
+  this->_XkIsSparse = (this->_XkSparse.size() <= this->_sparseDensity * rows * (this->_m+1));
+  if (!this->_XkIsSparse) this->_XkSparse.clear();
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+stepIterate(int * G1_to_G2, int * G2_to_G1, double t)
+{
+  int rows = this->_n+1;
+  int cols = this->_m+1;
+  if (!this->_XkIsSparse){
+    // x + t(b - x), with the entries of b set from the mapping rather than from a dense bkp1
+    std::vector<std::pair<std::pair<int,int>,double> > b;
+    this->mappingsToSparse(G1_to_G2, G2_to_G1, this->_n, this->_m, b);
+    std::vector<Real> x(b.size());
+    for (unsigned int p=0; p<b.size(); p++)
+      x[p] = this->Xk[sub2ind(b[p].first.first,b[p].first.second,rows)];
+    Map<MatrixR> m_Xk(this->Xk, rows, cols);
+    m_Xk -= t*m_Xk;
+    for (unsigned int p=0; p<b.size(); p++)
+      this->Xk[sub2ind(b[p].first.first,b[p].first.second,rows)] = x[p] + t*(1 - x[p]);
+    return;
+  }
+
+  // Entries of bkp1 which are null in Xk are new entries of Xk, merged by rows. The entries are
+  // computed as in the dense form, so both forms give the same iterates.
+  unsigned int nnz = this->_XkSparse.size();
+  std::vector<std::pair<std::pair<int,int>,double> > b;
+  this->mappingsToSparse(G1_to_G2, G2_to_G1, this->_n, this->_m, b);
+  std::vector<Real> x(b.size());
+  for (unsigned int p=0; p<b.size(); p++){
+    x[p] = this->Xk[sub2ind(b[p].first.first,b[p].first.second,rows)];
+    if (x[p] == 0) this->_XkSparse.push_back(b[p]);
+  }
+  std::inplace_merge(this->_XkSparse.begin(), this->_XkSparse.begin()+nnz, this->_XkSparse.end());
+  std::vector<std::pair<std::pair<int,int>,double> >::iterator it;
+  for (it = this->_XkSparse.begin(); it != this->_XkSparse.end(); it++){
+    Real & e = this->Xk[sub2ind(it->first.first,it->first.second,rows)];
+    e -= t*e;
+  }
+  for (unsigned int p=0; p<b.size(); p++)
+    this->Xk[sub2ind(b[p].first.first,b[p].first.second,rows)] = x[p] + t*(1 - x[p]);
+  for (unsigned int p=0; p<this->_XkSparse.size(); p++){
+    Real x = this->Xk[sub2ind(this->_XkSparse[p].first.first,this->_XkSparse[p].first.second,rows)];
+    this->_XkSparse[p].second = x;
+  }
+
+  // Too many entries : switch to the dense form
+  if (this->_XkSparse.size() > nnz && this->_XkSparse.size() > this->_sparseDensity * rows * cols){
+    this->_XkSparse.clear();
+    this->_XkIsSparse = false;
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+mappingsToSparse(int * G1_to_G2, int * G2_to_G1, int n, int m,
+                 std::vector<std::pair<std::pair<int,int>,double> > & X)
+{
+  X.clear();
+  for (int i =0;i<n;i++){
+    std::pair<int,int> tmp = std::pair<int,int>(i,G1_to_G2[i]);
+    X.push_back(std::pair<std::pair<int,int>,double>(tmp,1.));
+  }
+  for (int j =0;j<m;j++)
+    if (G2_to_G1[j] >= n){
+      std::pair<int,int> tmp = std::pair<int,int>(G2_to_G1[j],j);
+      X.push_back(std::pair<std::pair<int,int>,double>(tmp,1.));
+    }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+bool IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+quadraticStep(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2,
+              int * G1_to_G2, int * G2_to_G1)
+{
+  int n = this->_n;
+  int m = this->_m;
+  int rows = n+1;
+  int cols = m+1;
+  const Adjacency & A1 = this->_adj1;
+  const Adjacency & A2 = this->_adj2;
+  // Non-zero entries of bkp1 - Xk, which are also entries of the gradient of GNCCP
+  std::vector<std::pair<std::pair<int,int>,double> > & X = this->_stepX;
+  std::vector<std::pair<std::pair<int,int>,double> > b;
+  std::vector<std::pair<std::pair<int,int>,double> >::iterator it;
+  X.clear();
+  for (it = this->_XkSparse.begin(); it != this->_XkSparse.end(); it++){
+    int i = it->first.first;
+    int k = it->first.second;
+    bool mapped = (i < n) ? (G1_to_G2[i] == k) : (k < m && G2_to_G1[k] >= n);
+    if ((mapped ? 1. : 0.) != it->second)
+      X.push_back(std::pair<std::pair<int,int>,double>(it->first, (mapped ? 1. : 0.) - it->second));
+  }
+  this->mappingsToSparse(G1_to_G2, G2_to_G1, n, m, b);
+  for (it = b.begin(); it != b.end(); it++)
+    if (this->Xk[sub2ind(it->first.first,it->first.second,rows)] == 0)
+      X.push_back(*it);
+
+  // As in the coordinate QuadraticTerm : deletions and insertions of edges through the row and
+  // column sums, then the neighbours of each entry. Each node of g1 and of g2 is mapped once by bkp1
+  // and, up to rounding, by the convex combinations of mappings, so the sums of D on the nodes only
+  // differ from 0 from other iterates, such as the flat one.
+  const double tolerance = 1e-9;
+  std::vector<double> r(rows, 0.);
+  std::vector<double> c(cols, 0.);
+  for (it = X.begin(); it != X.end(); it++){
+    r[it->first.first] += it->second;
+    c[it->first.second] += it->second;
+  }
+  for (int i=0; i<n; i++)
+    if (fabs(r[i]) < tolerance) r[i] = 0;
+  for (int k=0; k<m; k++)
+    if (fabs(c[k]) < tolerance) c[k] = 0;
+
+  // Substitution costs scattered, against the ones of the quadratic term of bkp1 and its fill, which
+  // costs about as much as one substitution cost per 16 entries on graphs of 150 to 800 nodes
+  double work = 0;
+  for (it = X.begin(); it != X.end(); it++){
+    int i = it->first.first;
+    int k = it->first.second;
+    if (i < n && k < m)
+      work += (A1.ptr[i+1] - A1.ptr[i] + 1.) * (A2.ptr[k+1] - A2.ptr[k] + 1.);
+  }
+  for (int i=0; i<n; i++)
+    if (r[i] != 0) work += (A1.ptr[i+1] - A1.ptr[i]) * (double)cols;
+  for (int k=0; k<m; k++)
+    if (c[k] != 0) work += (A2.ptr[k+1] - A2.ptr[k]) * (double)rows;
+  double dense = 0;
+  for (int i=0; i<n; i++)
+    if (G1_to_G2[i] < m)
+      dense += (A1.ptr[i+1] - A1.ptr[i] + 1.) * (A2.ptr[G1_to_G2[i]+1] - A2.ptr[G1_to_G2[i]] + 1.);
+  if (work > dense + (double)rows*cols/16) return false;
+
+  std::vector<int> & index = this->_stepIndex;
+  std::vector<int> & entries = this->_stepEntries;
+  std::vector<Real> & D = this->_stepD;
+  if ((int)index.size() < rows*cols) index.assign(rows*cols, -1);
+  entries.clear();
+  D.clear();
+  auto add = [&](int j, int l, double value){
+    int e = sub2ind(j,l,rows);
+    if (index[e] < 0){
+      index[e] = entries.size();
+      entries.push_back(e);
+      D.push_back(0);
+    }
+    D[index[e]] += value;
+  };
+  for (it = X.begin(); it != X.end(); it++)
+    add(it->first.first, it->first.second, 0.);
+  for (int j=0; j<n; j++){
+    double del = 0.;
+    for (int p=A1.ptr[j]; p<A1.ptr[j+1]; p++)
+      del += A1.edgeCost[p] * r[A1.node[p]];
+    if (del != 0)
+      for (int l=0; l<cols; l++) add(j, l, del);
+  }
+  for (int l=0; l<m; l++){
+    double ins = 0.;
+    for (int q=A2.ptr[l]; q<A2.ptr[l+1]; q++)
+      ins += A2.edgeCost[q] * c[A2.node[q]];
+    if (ins != 0)
+      for (int j=0; j<rows; j++) add(j, l, ins);
+  }
+  for (it = X.begin(); it != X.end(); it++){
+    int i = it->first.first;
+    int k = it->first.second;
+    double x = it->second;
+    if (i >= n || k >= m) continue;
+    for (int q=A2.ptr[k]; q<A2.ptr[k+1]; q++)
+      add(i, A2.node[q], -A2.edgeCost[q] * x);
+    for (int p=A1.ptr[i]; p<A1.ptr[i+1]; p++){
+      int j = A1.node[p];
+      add(j, k, -A1.edgeCost[p] * x);
+      for (int q=A2.ptr[k]; q<A2.ptr[k+1]; q++){
+        double cost = this->cf->EdgeSubstitutionCost(A1.edge[p],A2.edge[q],g1,g2) - A1.edgeCost[p] - A2.edgeCost[q];
+        add(j, A2.node[q], cost * x);
+      }
+    }
+  }
+
+  this->_stepXkD.resize(entries.size());
+  for (unsigned int q=0; q<entries.size(); q++){
+    D[q] *= 0.5;
+    this->_stepXkD[q] = this->XkD[entries[q]];
+    this->XkD[entries[q]] += D[q];
+    index[entries[q]] = -1;
+  }
+  return true;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+quadraticStepTo(double t)
+{
+  // Same rounding as the dense update from the quadratic term of bkp1, held by XkD
+  for (unsigned int q=0; q<this->_stepEntries.size(); q++){
+    Real d = this->XkD[this->_stepEntries[q]];
+    this->XkD[this->_stepEntries[q]] = this->_stepXkD[q] + t*(d - this->_stepXkD[q]);
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+IPFPiterations(Graph<NodeAttribute,EdgeAttribute> * g1,
+	       Graph<NodeAttribute,EdgeAttribute> * g2)
+{
+  if (this->fwVariant != FW_CLASSIC){
+    this->IPFPactiveSetIterations(g1,g2);
+    return;
+  }
+
+  // XkD is the quadratic term of Xk, Xkp1tD the one of bkp1.
+  // As the quadratic term is linear in X, XkD is updated along with Xk
+  // instead of being recomputed from the (continuous) Xk at each iteration.
+  // bkp1 is never built, and while Xk is sparse XkD and the gradient are only updated
+  // on the entries changed by the step, see quadraticStep
+  Map<MatrixR> m_C(this->C,this->_n+1,this->_m+1);
+  Map<MatrixR> m_Xk(this->Xk,  this->_n+1,  this->_m+1);
+  Map<MatrixR> m_linearSubProblem(this->linearSubProblem,  this->_n+1,  this->_m+1);
+
+  this->S.clear();
+  this->R.clear();
 
-  this->Lterm = linearCost(this->C,this->Xk,  this->_n+1,  this->_m+1);
   this->S.push_back(this->getCost(this->Xk,  this->_n,  this->_m));
 #if DEBUG
   std::cout << "S(0) = " << this->S.back() << std::endl;
 #endif
   this->k=0;
-  this->linearSubProblem = new double [(  this->_n+1) * (  this->_m+1)];
-  Map<MatrixXd> m_linearSubProblem(this->linearSubProblem,  this->_n+1,  this->_m+1);
-
-
-  this->Xkp1tD = new double [(  this->_n+1) * (  this->_m+1)];
-  Map<MatrixXd> m_Xkp1tD (this->Xkp1tD,  this->_n+1,  this->_m+1);
-
+  this->_nbLSAPE = 0;
+  this->_nbAwaySteps = 0;
+  this->_nbDropSteps = 0;
 
-  double *u = new double[this->_n+1];
-  double *v = new double[this->_m+1];  int * G1_to_G2 = new int[this->_n];
-  int * G2_to_G1 = new int[this->_m];
+  int * G1_to_G2 = this->_G1_to_G2;
+  int * G2_to_G1 = this->_G2_to_G1;
   bool flag_continue = true;
+  bool gradient = false; // true if linearSubProblem already holds the gradient at Xk
 
   //BipartiteGraphEditDistanceMulti<int,int> ed_multi(this->cf, 30); // To know how many solutions to lsap per iteration
-  while((this->k < this->maxIter) && flag_continue){ //TODO : fixer un epsilon, param ?
-    this->XkD = QuadraticTerm(g1,g2,this->Xk,this->XkD);
-    this->LinearSubProblem();//    should call it gradient direction
-
-    hungarianLSAPE(this->linearSubProblem,  this->_n+1,  this->_m+1, G1_to_G2,G2_to_G1, u,v,false);
-    //bkp1 is the matrix version of mapping G1_to_G2 and G2_to_G1, so a binary matrix
-    this->bkp1 = mappingsToMatrix(G1_to_G2,G2_to_G1,  this->_n,  this->_m,this->bkp1);
+  while((this->k < this->maxIter) && flag_continue && !this->budgetExhausted()){ //TODO : fixer un epsilon, param ?
+    if (!gradient)
+      this->LinearSubProblem();//    should call it gradient direction
+
+    double t = IPFPTelemetry::clock();
+    // Warm start from the previous subproblem of this run, or of the previous run on this pair
+    bool warm = (this->_nbLSAPE > 0) || (this->_keepDuals && this->_dualsValid);
+    this->solveLinearProblem(this->linearSubProblem, G1_to_G2, G2_to_G1, warm);
+    this->_dualsValid = true;
+    this->_nbLSAPE++;
+    this->_telemetry.nbLSAPE++;
+    this->_telemetry.timeLSAPE += IPFPTelemetry::clock() - t;
+    //bkp1, the binary matrix of mapping G1_to_G2 and G2_to_G1, is only used through the mapping
     this->R.push_back(linearCost(this->linearSubProblem,G1_to_G2, G2_to_G1,  this->_n,  this->_m));
     //std::list<int*> mappings = ed_multi.getKOptimalMappings(g1, g2, linearSubProblem, 30);
     //std::cout << mappings.size() << ", ";
 
 #if DEBUG
     IOFormat OctaveFmt(StreamPrecision, 0, ", ", ";\n", "", "", "[", "]");
+    Map<MatrixR> m_XkD(this->XkD,  this->_n+1,  this->_m+1);
     std::cout << "XkD" << std::endl;
     std::cout << m_XkD.format(OctaveFmt) << std::endl;
     std::cout << "linearSubProblem" << std::endl;
     std::cout << m_linearSubProblem.format(OctaveFmt) << std::endl;
-    std::cout << "bkp1" << std::endl;
-    std::cout << m_bkp1.format(OctaveFmt) << std::endl;
     std::cout << "R : " << this->R.back() << std::endl;
 #endif
 
     this->oldLterm = this->Lterm;
     this->Lterm = linearCost(this->C,G1_to_G2, G2_to_G1,  this->_n,  this->_m);
-    this->XkD = QuadraticTerm(g1,g2,G1_to_G2, G2_to_G1, this->XkD);
+    // getCost() works on XkD : swap so that XkD holds the quadratic term of bkp1
+    t = IPFPTelemetry::clock();
+    bool coordinate = this->_XkIsSparse && !this->_directed &&
+      this->quadraticStep(g1,g2,G1_to_G2, G2_to_G1);
+    if (!coordinate){
+      this->Xkp1tD = QuadraticTerm(g1,g2,G1_to_G2, G2_to_G1, this->Xkp1tD);
+      std::swap(this->XkD, this->Xkp1tD);
+    }
+    this->_telemetry.timeQuadratic += IPFPTelemetry::clock() - t;
     this->S.push_back(this->getCost(G1_to_G2, G2_to_G1,  this->_n,  this->_m));
 
 #if DEBUG
@@ -511,11 +1566,16 @@ IPFPalgorithm(Graph<NodeAttribute,EdgeAttribute> * g1,
 
 #endif
 
+    t = IPFPTelemetry::clock();
     double alpha = getAlpha();
     double beta= getBeta();
     double t0 =0.0;
     if(beta > 0.000001)
       t0 = -alpha / (2.*beta);
+    // alpha <= 0 when bkp1 minimizes the linear subproblem. It may be positive with the greedy
+    // LSAPE solvers, which are approximations, or by rounding at a stationary Xk : t0 < 0 would
+    // then leave the segment [Xk, bkp1], i.e. the feasible set. Xk is kept instead, see t0 == 0
+    if (t0 < 0) t0 = 0;
     //Built a new Xk matrix (possibly not permutation)
 #if DEBUG
 
@@ -532,32 +1592,57 @@ IPFPalgorithm(Graph<NodeAttribute,EdgeAttribute> * g1,
 
     //*
     if (this->R.back() < 0.0001)
-      flag_continue = (fabs(alpha) > this->epsilon);
+      this->_telemetry.gap = fabs(alpha);
     else
-      flag_continue = (fabs(alpha / this->R.back()) > this->epsilon);
+      this->_telemetry.gap = fabs(alpha / this->R.back());
+    flag_continue = (this->_telemetry.gap > this->epsilon);
     //*/
 
-    if ((beta < 0.00001) || (t0 >= 1))
+    if ((beta < 0.00001) || (t0 >= 1)){
       //if(flag_continue)
-        memcpy(this->Xk, this->bkp1,sizeof(double)*(  this->_n+1)*(  this->_m+1));
-        
+        this->setIterate(G1_to_G2, G2_to_G1);
+        this->_telemetry.nbFullSteps++;
+        // XkD already holds the quadratic term of bkp1
+    }
+    else if (t0 == 0){
+      // No descent along bkp1 - Xk : Xk and its objective stay. XkD holds the quadratic term
+      // of bkp1 since the swap above, the one of Xk is in Xkp1tD
+      if (coordinate)
+        this->quadraticStepTo(0.);
+      else
+        std::swap(this->XkD, this->Xkp1tD);
+      this->S[this->k+1] = this->S[this->k];
+      this->Lterm = this->oldLterm;
+    }
       //Lterm = Lterm_new;
     else{
       //Line search
-      MatrixXd maj_matrix(  this->_n+1,  this->_m+1);
-      maj_matrix = t0*(m_bkp1 - m_Xk);
+      Map<MatrixR> m_XkD(this->XkD,  this->_n+1,  this->_m+1);
+      Map<MatrixR> m_Xkp1tD (this->Xkp1tD,  this->_n+1,  this->_m+1);
 #if DEBUG
       std::cout << "line search" << std::endl;
-      std::cout << "Norm de la maj : " << maj_matrix.norm() << std::endl;
 #endif
       //if (flag_continue){
-        m_Xk = m_Xk + t0*(m_bkp1 - m_Xk);
+        this->stepIterate(G1_to_G2, G2_to_G1, t0);
+        if (coordinate)
+          this->quadraticStepTo(t0);
+        else
+          m_XkD = m_Xkp1tD + t0*(m_XkD - m_Xkp1tD);
         this->S[this->k+1] = this->S[this->k] - ((pow(alpha,2))/(4*beta));
-        this->Lterm = linearCost(this->C, this->Xk,   this->_n+1,  this->_m+1);
+        if (this->_XkIsSparse)
+          this->Lterm = linearCost(this->C, this->_XkSparse,   this->_n+1);
+        else
+          this->Lterm = linearCost(this->C, this->Xk,   this->_n+1,  this->_m+1);
+        this->_telemetry.nbLineSearchSteps++;
 	//}
     }
+    // The gradient at the new Xk only changes on the entries of the step
+    gradient = coordinate;
+    if (coordinate)
+      this->LinearSubProblem(this->_stepEntries);
+    this->_telemetry.timeLineSearch += IPFPTelemetry::clock() - t;
 #if DEBUG
-    std::cout << "Xk à l'itération " << k << std::endl;
+    std::cout << "Xk à l'itération " << this->k << std::endl;
     std::cout << m_Xk.format(OctaveFmt) << std::endl;
     std::cout << "------------------------------------------------------------"  << std::endl << std::endl;
 #endif
@@ -566,29 +1651,191 @@ IPFPalgorithm(Graph<NodeAttribute,EdgeAttribute> * g1,
   }
 
   //std::cout << this->k << ", " ;
-  
-  delete [] this->Xkp1tD;this->Xkp1tD=0;
-  delete [] this->linearSubProblem;this->linearSubProblem=0;
-  delete [] this->XkD;this->XkD = 0;
-  delete [] this->C;this->C = 0;
-  delete [] this->bkp1;this->bkp1 = 0;
-  delete [] u;
-  delete [] v;
-  delete [] G1_to_G2;
-  delete [] G2_to_G1;
+  this->recordRun(!flag_continue);
+
 #if DEBUG
   std::cout << this->S.back() << std::endl;
-  std::cout << "Fin d'IPFP : "<< k << "iterations " << std::endl;
+  std::cout << "Fin d'IPFP : "<< this->k << "iterations " << std::endl;
 #endif
   //Xk contains the optimal bistochastic matrix, binary or not.
 
 }
 
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+IPFPactiveSetIterations(Graph<NodeAttribute,EdgeAttribute> * g1,
+			Graph<NodeAttribute,EdgeAttribute> * g2)
+{
+  int rows = this->_n+1;
+  int cols = this->_m+1;
+  int size = rows*cols;
+  Map<MatrixR> m_Xk(this->Xk, rows, cols);
+  Map<MatrixR> m_XkD(this->XkD, rows, cols);
+  Map<MatrixR> m_bkp1(this->bkp1, rows, cols);
+  Map<MatrixR> m_dirX(this->_dirX, rows, cols);
+  Map<MatrixR> m_dirD(this->_dirD, rows, cols);
+
+  // Xk is updated in dense form only
+  this->_XkIsSparse = false;
+  this->_XkSparse.clear();
 
+  this->S.clear();
+  this->R.clear();
+  this->S.push_back(this->getCost(this->Xk,  this->_n,  this->_m));
+  this->k=0;
+  this->_nbLSAPE = 0;
+  this->_nbAwaySteps = 0;
+  this->_nbDropSteps = 0;
+
+  // The init is the first atom, binary or not
+  this->clearAtoms();
+  _atomsX.push_back(new Real[size]);
+  _atomsD.push_back(new Real[size]);
+  _atomsW.push_back(1.);
+  memcpy(_atomsX[0], this->Xk, sizeof(Real)*size);
+  memcpy(_atomsD[0], this->XkD, sizeof(Real)*size);
+
+  int * G1_to_G2 = this->_G1_to_G2;
+  int * G2_to_G1 = this->_G2_to_G1;
+  bool flag_continue = true;
+  while((this->k < this->maxIter) && flag_continue && !this->budgetExhausted()){
+    this->LinearSubProblem();
+    double tc = IPFPTelemetry::clock();
+    bool warm = (this->_nbLSAPE > 0) || (this->_keepDuals && this->_dualsValid);
+    this->solveLinearProblem(this->linearSubProblem, G1_to_G2, G2_to_G1, warm);
+    this->_dualsValid = true;
+    this->_nbLSAPE++;
+    this->_telemetry.nbLSAPE++;
+    this->_telemetry.timeLSAPE += IPFPTelemetry::clock() - tc;
+    this->bkp1 = mappingsToMatrix(G1_to_G2,G2_to_G1,  this->_n,  this->_m,this->bkp1);
+    this->R.push_back(linearCost(this->linearSubProblem,G1_to_G2, G2_to_G1,  this->_n,  this->_m));
+
+    // Frank-Wolfe direction bkp1 - Xk, and away direction Xk - a with a the worst atom
+    double gX = linearCost(this->linearSubProblem, this->Xk, rows, cols);
+    double alphaFW = this->R.back() - gX;
+    int a = 0;
+    int b = -1;
+    double ga = -std::numeric_limits<double>::max();
+    for (unsigned int i=0; i<_atomsX.size(); i++){
+      double g = linearCost(this->linearSubProblem, _atomsX[i], rows, cols);
+      if (g > ga){ ga = g; a = i; }
+      if (b < 0 && memcmp(_atomsX[i], this->bkp1, sizeof(Real)*size) == 0) b = i;
+    }
+    double alphaA = gX - ga;
+
+    // Same stopping criterion as the classic iterations
+    if (this->R.back() < 0.0001)
+      this->_telemetry.gap = fabs(alphaFW);
+    else
+      this->_telemetry.gap = fabs(alphaFW / this->R.back());
+    flag_continue = (this->_telemetry.gap > this->epsilon);
+
+    bool away = (this->fwVariant == FW_AWAY && alphaA < alphaFW && _atomsW[a] < 1.);
+    bool pairwise = (this->fwVariant == FW_PAIRWISE && a != b);
+
+    // The quadratic term of bkp1 is only computed if bkp1 is a new atom
+    Real * Db = NULL;
+    if (!away){
+      tc = IPFPTelemetry::clock();
+      if (b < 0) Db = QuadraticTerm(g1,g2,G1_to_G2, G2_to_G1, this->Xkp1tD);
+      else Db = _atomsD[b];
+      this->_telemetry.timeQuadratic += IPFPTelemetry::clock() - tc;
+    }
+    Map<MatrixR> m_Db(Db, rows, cols);
+    Map<MatrixR> m_Xa(_atomsX[a], rows, cols);
+    Map<MatrixR> m_Da(_atomsD[a], rows, cols);
+
+    tc = IPFPTelemetry::clock();
+    double tmax = 1.;
+    if (away){
+      m_dirX = m_Xk - m_Xa;
+      m_dirD = m_XkD - m_Da;
+      tmax = _atomsW[a] / (1. - _atomsW[a]);
+    }else if (pairwise){
+      m_dirX = m_bkp1 - m_Xa;
+      m_dirD = m_Db - m_Da;
+      tmax = _atomsW[a];
+    }else{
+      m_dirX = m_bkp1 - m_Xk;
+      m_dirD = m_Db - m_XkD;
+    }
+
+    // Exact line search on [0,tmax] : f(Xk + t.d) = f(Xk) + t.alpha + t^2.beta
+    double alpha = this->getDirectionAlpha();
+    double beta = this->getDirectionBeta();
+    double t = tmax;
+    if (beta > 0.000001)
+      t = std::min(std::max(-alpha / (2.*beta), 0.), tmax);
+    else if (alpha + beta*tmax > 0) // concave along d, and tmax is worse than 0
+      t = 0;
+
+#if DEBUG
+    std::cout << (away?"away":(pairwise?"pairwise":"FW")) << " step, t : " << t
+              << " / " << tmax << ", alpha : " << alpha << ", beta : " << beta << std::endl;
+#endif
+
+    m_Xk += t*m_dirX;
+    m_XkD += t*m_dirD;
+    if (t >= tmax) this->_telemetry.nbFullSteps++;
+    else this->_telemetry.nbLineSearchSteps++;
+
+    // Update of the active set
+    if ((away || pairwise) && t > 0) this->_nbAwaySteps++;
+    if (!away && b < 0 && t > 0){
+      _atomsX.push_back(new Real[size]);
+      _atomsD.push_back(new Real[size]);
+      _atomsW.push_back(0.);
+      memcpy(_atomsX.back(), this->bkp1, sizeof(Real)*size);
+      memcpy(_atomsD.back(), Db, sizeof(Real)*size);
+      b = _atomsX.size()-1;
+    }
+    if (away){
+      for (unsigned int i=0; i<_atomsW.size(); i++) _atomsW[i] *= (1.+t);
+      _atomsW[a] -= t;
+    }else if (pairwise){
+      _atomsW[a] -= t;
+      if (b >= 0) _atomsW[b] += t;
+    }else{
+      for (unsigned int i=0; i<_atomsW.size(); i++) _atomsW[i] *= (1.-t);
+      if (b >= 0) _atomsW[b] += t;
+    }
+    // Atoms with a null weight leave the active set (drop steps for the away and pairwise steps)
+    for (int i=_atomsW.size()-1; i>=0; i--)
+      if (_atomsW[i] <= 0.000000001){
+        delete [] _atomsX[i];
+        delete [] _atomsD[i];
+        _atomsX.erase(_atomsX.begin()+i);
+        _atomsD.erase(_atomsD.begin()+i);
+        _atomsW.erase(_atomsW.begin()+i);
+        if (away || pairwise) this->_nbDropSteps++;
+      }
+
+    this->oldLterm = this->Lterm;
+    this->Lterm = linearCost(this->C, this->Xk, rows, cols);
+    this->S.push_back(this->getCost(this->Xk,  this->_n,  this->_m));
+    this->_telemetry.timeLineSearch += IPFPTelemetry::clock() - tc;
+#if DEBUG
+    std::cout << "S : " << this->S.back() << ", " << _atomsX.size() << " atoms" << std::endl;
+#endif
+    this->k++;
+  }
+  this->recordRun(!flag_continue);
+}
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
-linearCost(double * CostMatrix, int * G1_to_G2,int * G2_to_G1, int n, int m){
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+recordRun(bool converged)
+{
+  this->_telemetry.iterations += this->k;
+  this->_telemetry.objectives.insert(this->_telemetry.objectives.end(), this->S.begin(), this->S.end());
+  this->_telemetry.converged = converged;
+  this->_telemetry.timeTotal = IPFPTelemetry::clock() - this->_telemetryStart;
+}
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+linearCost(Real * CostMatrix, int * G1_to_G2,int * G2_to_G1, int n, int m){
   double sum = 0.0;
   for(int i=0;i<n;i++)
     sum += CostMatrix[sub2ind(i,G1_to_G2[i],n+1)];
@@ -598,9 +1845,9 @@ linearCost(double * CostMatrix, int * G1_to_G2,int * G2_to_G1, int n, int m){
   return sum;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
-linearCost(double * CostMatrix, double * X, int n, int m){
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+linearCost(Real * CostMatrix, Real * X, int n, int m){
   //Todo : optimiser avec dot product ?
   double sum = 0.0;
   for(int i=0;i<n;i++)
@@ -609,50 +1856,82 @@ linearCost(double * CostMatrix, double * X, int n, int m){
   return sum;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+linearCost(Real * CostMatrix, const std::vector<std::pair<std::pair<int,int>,double> > & X, int n){
+  double sum = 0.0;
+  std::vector<std::pair<std::pair<int,int>,double> >::const_iterator it;
+  for (it = X.begin(); it != X.end(); it++)
+    sum += CostMatrix[sub2ind(it->first.first,it->first.second,n)] * it->second;
+  return sum;
+}
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 LinearSubProblem(){
-  Map<MatrixXd> m_linearSubProblem(this->linearSubProblem,this->_n+1,this->_m+1);
+  Map<MatrixR> m_linearSubProblem(this->linearSubProblem,this->_n+1,this->_m+1);
 
-  Map<MatrixXd> m_XkD(this->XkD,this->_n+1,this->_m+1);
-  Map<MatrixXd> m_C(this->C,this->_n+1,this->_m+1);
+  Map<MatrixR> m_XkD(this->XkD,this->_n+1,this->_m+1);
+  Map<MatrixR> m_C(this->C,this->_n+1,this->_m+1);
 
   m_linearSubProblem = 2*m_XkD + m_C;
 
 }
 
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+LinearSubProblem(const std::vector<int> & entries){
+  for (unsigned int q=0; q<entries.size(); q++)
+    this->linearSubProblem[entries[q]] = 2*this->XkD[entries[q]] + this->C[entries[q]];
+}
+
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
-getCost(double * Matrix, int n, int m){
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+getCost(Real * Matrix, int n, int m){
+  if (Matrix == this->Xk && this->_XkIsSparse)
+    return linearCost(this->XkD,this->_XkSparse,n+1)+ this->Lterm;
   return linearCost(this->XkD,Matrix,n+1,m+1)+ this->Lterm;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getCost(int * G1_to_G2,int * G2_to_G1, int n, int m){
 
   return linearCost(this->XkD,G1_to_G2, G2_to_G1,n,m)+ this->Lterm;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getAlpha(){
   return this->R.back() - 2 * this->S[this->k] + this->oldLterm;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getBeta(){
   return this->S.back() + this->S[this->k] - this->R.back() - this->oldLterm;
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double * IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
-mappingsToMatrix(int * G1_to_G2,int * G2_to_G1, int n, int m, double * Matrix){
-  memset(Matrix,0,sizeof(double)*(n+1)*(m+1));
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+getDirectionAlpha(){
+  return linearCost(this->linearSubProblem, this->_dirX, this->_n+1, this->_m+1);
+}
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+getDirectionBeta(){
+  return linearCost(this->_dirD, this->_dirX, this->_n+1, this->_m+1);
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+Real * IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+mappingsToMatrix(int * G1_to_G2,int * G2_to_G1, int n, int m, Real * Matrix){
+  memset(Matrix,0,sizeof(Real)*(n+1)*(m+1));
   for (int i =0;i<n;i++)
     Matrix[sub2ind(i,G1_to_G2[i],n+1)] = 1;
   for (int j =0;j<m;j++)
@@ -663,8 +1942,8 @@ mappingsToMatrix(int * G1_to_G2,int * G2_to_G1, int n, int m, double * Matrix){
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 mappingCost( Graph<NodeAttribute,EdgeAttribute> * g1,
              Graph<NodeAttribute,EdgeAttribute> * g2,
              int* G1_to_G2 , int* G2_to_G1)
@@ -9,12 +9,14 @@ using namespace Eigen;
 #include "MappingRefinement.h"
 #include "utils.h"
 
-template<class NodeAttribute, class EdgeAttribute>
+template<class NodeAttribute, class EdgeAttribute, class Real = double>
 class IPFPQAP: 
   public MappingRefinement<NodeAttribute, EdgeAttribute>
 {
 
 protected:
+  typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic> MatrixR; //!< matrices of the solver, in the working precision
+
 
   EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction; 
         //!< Cost function used to compute node and edge substitution costs
@@ -24,14 +26,14 @@ protected:
 
 
   //Data inherent to *one* computation
-  double * C = 0;
-  double * linearSubProblem = 0;
-  double * XkD = 0;
-  double * Xk = 0;
+  Real * C = 0;
+  Real * linearSubProblem = 0;
+  Real * XkD = 0;
+  Real * Xk = 0;
   double Lterm = 0;
   double oldLterm = 0;
-  double * Xkp1tD = 0;
-  double * bkp1 = 0;
+  Real * Xkp1tD = 0;
+  Real * bkp1 = 0;
   int _n = -1;
   int _m = -1;
   int k = -1;
@@ -39,7 +41,7 @@ protected:
   std::vector<double> S;
   std::vector<double> R;
   
-  double* J = NULL;
+  Real * J = NULL;
   bool recenter=false;
 
   void (*_MappingInit)(Graph<NodeAttribute,EdgeAttribute> * g1,
@@ -51,34 +53,34 @@ protected:
                       Graph<NodeAttribute,EdgeAttribute> * g2);
 
   virtual
-  double * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+  Real * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
                          Graph<NodeAttribute,EdgeAttribute> * g2,
-                         int * G1_to_G2, double * XkD);
+                         int * G1_to_G2, Real * XkD);
 
   virtual
-  double * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+  Real * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
                          Graph<NodeAttribute,EdgeAttribute> * g2,
-                         double * Matrix, double * XkD);
+                         Real * Matrix, Real * XkD);
   
   virtual
-  double * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
+  Real * QuadraticTerm(Graph<NodeAttribute,EdgeAttribute> * g1,
                          Graph<NodeAttribute,EdgeAttribute> * g2,
-                         std::vector<std::pair<std::pair<int,int>,double> > mappings, double * XkD);
+                         std::vector<std::pair<std::pair<int,int>,double> > mappings, Real * XkD);
 
   //This linearCost is efficient for sparse Xk matrices
   // n is nb rows of matrices, m is nb columns
-  virtual double linearCost(double * CostMatrix, int * G1_to_G2, int n, int m);
+  virtual double linearCost(Real * CostMatrix, int * G1_to_G2, int n, int m);
   // n is nb rows of matrices, m is nb columns
-  virtual double linearCost(double * CostMatrix, double * Xk, int n, int m);
+  virtual double linearCost(Real * CostMatrix, Real * Xk, int n, int m);
 
   // Fill this->linearSubProblem with appropriatelinear problem
   virtual void LinearSubProblem();
   virtual double getCost(int * G1_to_G2, int n, int m);
-  virtual double getCost(double * Matrix , int n, int m);
+  virtual double getCost(Real * Matrix , int n, int m);
   virtual double getAlpha();
   virtual double getBeta();
 
-  virtual double * mappingsToMatrix(int * G1_to_G2, int n, int m, double * Matrix);
+  virtual Real * mappingsToMatrix(int * G1_to_G2, int n, int m, Real * Matrix);
 
 
 
@@ -103,7 +105,7 @@ public:
    */
   virtual void getBetterMappingFromInit( Graph<NodeAttribute,EdgeAttribute> * g1,
                                          Graph<NodeAttribute,EdgeAttribute> * g2,
-                                         int* G1_to_G2, double * X0 = NULL);
+                                         int* G1_to_G2, Real * X0 = NULL);
 
   virtual void IPFPalgorithm(Graph<NodeAttribute,EdgeAttribute> * g1,
                      Graph<NodeAttribute,EdgeAttribute> * g2);
@@ -130,7 +132,7 @@ public:
    *  On the next IPFP algorithm call, the initialization \f$X_0\f$ will be translated to \f$\frac{1}{2}\times(X_0+J)\f$.
    *  If <code>nJ==NULL</code>, then the geometrical barycenter of doubly stochastic matrices \f$J = (1/n)\f$ will be used
    */
-  virtual void recenterInit(double* nJ, int n);
+  virtual void recenterInit(Real * nJ, int n);
 
   IPFPQAP * clone() const { return new IPFPQAP(*this); }
 
@@ -150,12 +152,12 @@ public:
 };
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPQAP<NodeAttribute, EdgeAttribute>::
-recenterInit(double * nJ, int n)
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
+recenterInit(Real * nJ, int n)
 {
   if ( this->J != NULL) delete[] this->J;
-  this->J = new double[n*n];
+  this->J = new Real[n*n];
   
   this->recenter = true;
   if (nJ == NULL){
@@ -171,26 +173,26 @@ recenterInit(double * nJ, int n)
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 NodeCostMatrix( Graph<NodeAttribute,EdgeAttribute> * g1,
                 Graph<NodeAttribute,EdgeAttribute> * g2)
 {
   int n=g1->Size();
   int m=g2->Size();
 
-  this->C = new double[n*m];
+  this->C = new Real[n*m];
   for(int i=0;i<n;i++)
     for(int j=0;j<m;j++)
       C[sub2ind(i,j,n)] = this->costFunction->NodeSubstitutionCost((*g1)[i],(*g2)[j],g1,g2);
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double * IPFPQAP<NodeAttribute,EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+Real * IPFPQAP<NodeAttribute,EdgeAttribute, Real>::
 QuadraticTerm( Graph<NodeAttribute,EdgeAttribute> * g1,
                Graph<NodeAttribute,EdgeAttribute> * g2,
-               double * Matrix, double * XkD)
+               Real * Matrix, Real * XkD)
 {
   int n = g1->Size();
   int m = g2->Size();
@@ -205,18 +207,18 @@ QuadraticTerm( Graph<NodeAttribute,EdgeAttribute> * g1,
       }
     }
   if (! XkD)
-    XkD=new double[n*m];
+    XkD=new Real[n*m];
 
   return this->QuadraticTerm(g1,g2,mappings, XkD);
 }
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double * IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+Real * IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 QuadraticTerm( Graph<NodeAttribute,EdgeAttribute> * g1,
                Graph<NodeAttribute,EdgeAttribute> * g2,
-               int * G1_to_G2,double * XkD )
+               int * G1_to_G2,Real * XkD )
 {
   
   int n = g1->Size();
@@ -231,7 +233,7 @@ QuadraticTerm( Graph<NodeAttribute,EdgeAttribute> * g1,
     }
   }
   if (! XkD)
-    XkD=new double[n*m];
+    XkD=new Real[n*m];
 
   return this->QuadraticTerm(g1,g2,mappings,XkD);
 
@@ -239,20 +241,20 @@ QuadraticTerm( Graph<NodeAttribute,EdgeAttribute> * g1,
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double * IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+Real * IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 QuadraticTerm( Graph<NodeAttribute,EdgeAttribute> * g1,
                Graph<NodeAttribute,EdgeAttribute> * g2,
                std::vector<std::pair<std::pair<int,int>,double> > mappings,
-               double * quadraticTerm )
+               Real * quadraticTerm )
 {
   int n = g1->Size();
   int m = g2->Size();
 
   if (! quadraticTerm)
-    quadraticTerm=new double[n*m];
+    quadraticTerm=new Real[n*m];
 
-  memset(quadraticTerm,0,sizeof(double)*n*m);
+  memset(quadraticTerm,0,sizeof(Real)*n*m);
 
   for(int j = 0; j < n; j++){
     for(int l = 0; l < m;l++){
@@ -296,8 +298,8 @@ QuadraticTerm( Graph<NodeAttribute,EdgeAttribute> * g1,
 }
 
 /*
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 getOptimalMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
                    Graph<NodeAttribute,EdgeAttribute> * g2,
                    int * G1_to_G2, int* G2_to_G1 )
@@ -333,8 +335,8 @@ getOptimalMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 getBetterMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
                   Graph<NodeAttribute,EdgeAttribute> * g2,
                   int * G1_to_G2, int* G2_to_G1, bool fromInit )
@@ -342,7 +344,7 @@ getBetterMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
   this->_n = g1->Size();
   this->_m = g2->Size();
   
-  this->Xk = new double[(this->_n) * (this->_m)];
+  this->Xk = new Real[(this->_n) * (this->_m)];
   
   if (fromInit){
     this->Xk = this->mappingsToMatrix(G1_to_G2,this->_n,this->_m,this->Xk);
@@ -359,17 +361,17 @@ getBetterMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 getBetterMappingFromInit( Graph<NodeAttribute,EdgeAttribute> * g1,
                            Graph<NodeAttribute,EdgeAttribute> * g2,
-                           int* G1_to_G2, double * X0)
+                           int* G1_to_G2, Real * X0)
 {
   this->_n = g1->Size();
   this->_m = g2->Size();
 
   if (this->Xk == NULL)
-    this->Xk = new double[(this->_n) * (this->_m)];
+    this->Xk = new Real[(this->_n) * (this->_m)];
 
   if (this->Xk != X0){
     for (int j=0; j<this->_m; j++)
@@ -377,15 +379,15 @@ getBetterMappingFromInit( Graph<NodeAttribute,EdgeAttribute> * g1,
 	this->Xk[sub2ind(i,j,this->_n)] = X0[sub2ind(i,j,this->_n)];
   }
 
-  Map<MatrixXd> m_Xk(Xk, this->_n, this->_m);
+  Map<MatrixR> m_Xk(Xk, this->_n, this->_m);
 
   this->IPFPalgorithm(g1,g2);
 
 
   m_Xk= m_Xk *-1;
-  double *u = new double[this->_n];
-  double *v = new double[this->_m];
-  hungarianLSAP<double, int>(this->Xk,  this->_n,  this->_m, G1_to_G2, u,v);
+  Real * u = new Real[this->_n];
+  Real * v = new Real[this->_m];
+  hungarianLSAP<Real, int>(this->Xk,  this->_n,  this->_m, G1_to_G2, u,v);
   delete [] this->Xk; this->Xk=NULL;
   delete [] u;
   delete [] v;
@@ -394,15 +396,15 @@ getBetterMappingFromInit( Graph<NodeAttribute,EdgeAttribute> * g1,
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 IPFPalgorithm( Graph<NodeAttribute,EdgeAttribute> * g1,
                Graph<NodeAttribute,EdgeAttribute> * g2 )
 {
   
   // Recenter the init mapping ?
   if (this->recenter){
-    if (this->J == NULL) this->recenterInit(NULL, this->_n); // @see recenterInit(double*, int)
+    if (this->J == NULL) this->recenterInit(NULL, this->_n); // @see recenterInit(Real*, int)
     for (int j=0; j<this->_n;  j++)
       for (int i=0; i<this->_n;  i++)
         this->Xk[sub2ind(i,j,this->_n)] = (this->Xk[sub2ind(i,j,this->_n)] + this->J[sub2ind(i,j,this->_n)]) / 2;
@@ -418,16 +420,16 @@ IPFPalgorithm( Graph<NodeAttribute,EdgeAttribute> * g1,
   R.clear();
 
   NodeCostMatrix(g1,g2);//REdondant for GNCCP
-  Map<MatrixXd> m_C(this->C, this->_n, this->_m); //REdondant for GNCCP
+  Map<MatrixR> m_C(this->C, this->_n, this->_m); //REdondant for GNCCP
 
-  this->bkp1 = new double [(this->_n) * (this->_m)];
-  Map<MatrixXd> m_bkp1 (this->bkp1,  this->_n,  this->_m);
+  this->bkp1 = new Real [(this->_n) * (this->_m)];
+  Map<MatrixR> m_bkp1 (this->bkp1,  this->_n,  this->_m);
   //this->bkp1 = mappingsToMatrix(G1_to_G2,  this->_n,  this->_m,this->bkp1);
 
   this->XkD = this->QuadraticTerm(g1,g2,this->Xk,NULL); //REdondant for GNCCP
-  Map<MatrixXd> m_XkD(XkD,  this->_n,  this->_m);
+  Map<MatrixR> m_XkD(XkD,  this->_n,  this->_m);
 
-  Map<MatrixXd> m_Xk(this->Xk,  this->_n,  this->_m);
+  Map<MatrixR> m_Xk(this->Xk,  this->_n,  this->_m);
 
   Lterm = linearCost(this->C,this->Xk,  this->_n,  this->_m);
   S.push_back(this->getCost(Xk,  this->_n,  this->_m));
@@ -435,16 +437,16 @@ IPFPalgorithm( Graph<NodeAttribute,EdgeAttribute> * g1,
   std::cout << "S(0) = " << S.back() << std::endl;
 #endif
   k=0;
-  this->linearSubProblem = new double [(  this->_n) * (  this->_m)];
-  Map<MatrixXd> m_linearSubProblem(linearSubProblem,  this->_n,  this->_m);
+  this->linearSubProblem = new Real [(  this->_n) * (  this->_m)];
+  Map<MatrixR> m_linearSubProblem(linearSubProblem,  this->_n,  this->_m);
 
 
-  this->Xkp1tD = new double [(  this->_n) * (  this->_m)];
-  Map<MatrixXd> m_Xkp1tD (this->Xkp1tD,  this->_n,  this->_m);
+  this->Xkp1tD = new Real [(  this->_n) * (  this->_m)];
+  Map<MatrixR> m_Xkp1tD (this->Xkp1tD,  this->_n,  this->_m);
 
 
-  double *u = new double[this->_n];
-  double *v = new double[this->_m];  int * G1_to_G2 = new int[this->_n];
+  Real * u = new Real[this->_n];
+  Real * v = new Real[this->_m];  int * G1_to_G2 = new int[this->_n];
   bool flag_continue = true;
 
   //BipartiteGraphEditDistanceMulti<int,int> ed_multi(this->cf, 30); // To know how many solutions to lsap per iteration
@@ -452,7 +454,7 @@ IPFPalgorithm( Graph<NodeAttribute,EdgeAttribute> * g1,
     this->XkD = QuadraticTerm(g1, g2, Xk, this->XkD);
     this->LinearSubProblem();//    should call it gradient direction
 
-    hungarianLSAP<double,int>(linearSubProblem,  this->_n,  this->_m, G1_to_G2, u,v);
+    hungarianLSAP<Real,int>(linearSubProblem,  this->_n,  this->_m, G1_to_G2, u,v);
     //bkp1 is the matrix version of mapping G1_to_G2 so a binary matrix
     this->bkp1 = mappingsToMatrix(G1_to_G2,  this->_n,  this->_m,this->bkp1);
     R.push_back(linearCost(linearSubProblem,G1_to_G2,  this->_n,  this->_m));
@@ -508,12 +510,12 @@ IPFPalgorithm( Graph<NodeAttribute,EdgeAttribute> * g1,
 
     if ((beta < 0.00001) || (t0 >= 1))
       //if(flag_continue)
-        memcpy(this->Xk,bkp1,sizeof(double)*(  this->_n)*(  this->_m));
+        memcpy(this->Xk,bkp1,sizeof(Real)*(  this->_n)*(  this->_m));
         
       //Lterm = Lterm_new;
     else{
       //Line search
-      MatrixXd maj_matrix(  this->_n,  this->_m);
+      MatrixR maj_matrix(  this->_n,  this->_m);
       maj_matrix = t0*(m_bkp1 - m_Xk);
 #if DEBUG
       std::cout << "line search" << std::endl;
@@ -551,18 +553,18 @@ IPFPalgorithm( Graph<NodeAttribute,EdgeAttribute> * g1,
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPQAP<NodeAttribute, EdgeAttribute>::
-linearCost(double * CostMatrix, int * G1_to_G2, int n, int m){
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
+linearCost(Real * CostMatrix, int * G1_to_G2, int n, int m){
   double sum = 0.0;
   for(int i=0;i<n;i++)
     if (G1_to_G2[i]>=0) sum += CostMatrix[sub2ind(i,G1_to_G2[i],n)];
   return sum;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPQAP<NodeAttribute, EdgeAttribute>::
-linearCost(double * CostMatrix, double * X, int n, int m){
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
+linearCost(Real * CostMatrix, Real * X, int n, int m){
   //Todo : optimiser avec dot product ?
   double sum = 0.0;
   for(int i=0;i<n;i++)
@@ -571,49 +573,49 @@ linearCost(double * CostMatrix, double * X, int n, int m){
   return sum;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 LinearSubProblem(){
-  Map<MatrixXd> m_linearSubProblem(this->linearSubProblem,this->_n,this->_m);
+  Map<MatrixR> m_linearSubProblem(this->linearSubProblem,this->_n,this->_m);
 
-  Map<MatrixXd> m_XkD(this->XkD,this->_n,this->_m);
-  Map<MatrixXd> m_C(this->C,this->_n,this->_m);
+  Map<MatrixR> m_XkD(this->XkD,this->_n,this->_m);
+  Map<MatrixR> m_C(this->C,this->_n,this->_m);
 
   m_linearSubProblem = 2*m_XkD + m_C;
 }
 
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPQAP<NodeAttribute, EdgeAttribute>::
-getCost(double * Matrix, int n, int m){
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
+getCost(Real * Matrix, int n, int m){
   return linearCost(this->XkD,Matrix, n,m )+ this->Lterm;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 getCost(int * G1_to_G2, int n, int m){
 
   return linearCost(this->XkD,G1_to_G2, n, m)+ this->Lterm;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 getAlpha(){
   return this->R.back() - 2 * this->S[k] + this->oldLterm;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 getBeta(){
   return S.back() + S[k] -R.back() - this->oldLterm;
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double * IPFPQAP<NodeAttribute, EdgeAttribute>::
-mappingsToMatrix(int * G1_to_G2, int n, int m, double * Matrix){
-  memset(Matrix,0,sizeof(double)*n*m);
+template<class NodeAttribute, class EdgeAttribute, class Real>
+Real * IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
+mappingsToMatrix(int * G1_to_G2, int n, int m, Real * Matrix){
+  memset(Matrix,0,sizeof(Real)*n*m);
   for (int i =0;i<n;i++){
     //if (G1_to_G2[i] >= m) std::cout << G1_to_G2[i] << std::endl;
     if (G1_to_G2[i] >= 0)  Matrix[sub2ind(i,G1_to_G2[i],n)] = 1;
@@ -622,8 +624,8 @@ mappingsToMatrix(int * G1_to_G2, int n, int m, double * Matrix){
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPQAP<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPQAP<NodeAttribute, EdgeAttribute, Real>::
 mappingCost( Graph<NodeAttribute,EdgeAttribute> * g1,
              Graph<NodeAttribute,EdgeAttribute> * g2,
              int* G1_to_G2 , int* G2_to_G1)
@@ -634,12 +636,12 @@ mappingCost( Graph<NodeAttribute,EdgeAttribute> * g1,
 
   this->_directed = true;
 
-  this->Xk = new double[n*m];
+  this->Xk = new Real[n*m];
   this->Xk = this->mappingsToMatrix(G1_to_G2, n, m, this->Xk);
   this->XkD = QuadraticTerm(g1, g2, Xk, this->XkD);
 
   NodeCostMatrix(g1, g2);
-  this->linearSubProblem = new double [n*m];
+  this->linearSubProblem = new Real [n*m];
   this->LinearSubProblem();
   this->Lterm = linearCost(this->C, this->Xk, n, m);
 
@@ -0,0 +1,109 @@
+/**
+ * @file IPFPTelemetry.h
+ * @version     0.0.1
+ *
+ * Record of the last run of an IPFP like solver (IPFP, its Frank-Wolfe variants, GNCCP, Sinkhorn),
+ * used to tune <code>maxIter</code> and <code>epsilon</code> and to spot pathological pairs.
+ */
+
+#ifndef __IPFPTELEMETRY_H__
+#define __IPFPTELEMETRY_H__
+
+#include <sys/time.h>
+#include <vector>
+#include <ostream>
+
+struct IPFPTelemetry
+{
+  int iterations;         //!< iterations of the solver (IPFP iterations summed over the zeta steps for GNCCP)
+  int nbFullSteps;        //!< iterations which moved Xk to the solution of the linear subproblem
+  int nbLineSearchSteps;  //!< iterations which stopped inside the segment
+  int nbLSAPE;            //!< LSAPE solved, including the final projection
+  std::vector<double> objectives; //!< objective along the iterations, concatenated over the zeta steps for GNCCP
+  double gap;             //!< last stopping criterion : Frank-Wolfe gap, relative to the linear bound when it is not small
+                          //!< (largest change of an entry of Xk for Sinkhorn)
+  bool converged;         //!< true if the last run stopped on <code>epsilon</code> rather than <code>maxIter</code>
+                          //!< (on a binary Xk rather than on <code>zeta = -1</code> for GNCCP)
+
+  double timeQuadratic;   //!< seconds spent computing quadratic terms
+  double timeLSAPE;       //!< seconds spent in the LSAPE solver
+  double timeLineSearch;  //!< seconds spent computing the steps (line search, Sinkhorn projections)
+  double timeTotal;       //!< seconds from the setup of the pair to the final projection
+
+  IPFPTelemetry(){ clear(); }
+
+  void clear(){
+    iterations = 0;
+    nbFullSteps = 0;
+    nbLineSearchSteps = 0;
+    nbLSAPE = 0;
+    objectives.clear();
+    gap = 0;
+    converged = false;
+    timeQuadratic = 0;
+    timeLSAPE = 0;
+    timeLineSearch = 0;
+    timeTotal = 0;
+  }
+
+  /**
+   * @brief Wall clock time in seconds
+   */
+  static double clock(){
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + (double)tv.tv_usec / 1000000;
+  }
+};
+
+
+/**
+ * @brief One line summary : iterations, steps, LSAPE, final objective, gap, and the times per phase
+ */
+inline std::ostream & operator<<(std::ostream & out, const IPFPTelemetry & t)
+{
+  out << t.iterations << " iterations (" << t.nbFullSteps << " full, " << t.nbLineSearchSteps << " line search), "
+      << t.nbLSAPE << " LSAPE, objective " << (t.objectives.empty() ? 0. : t.objectives.back())
+      << ", gap " << t.gap << (t.converged ? "" : " (maxIter)")
+      << ", time " << t.timeTotal << "s (quadratic " << t.timeQuadratic << "s, LSAPE " << t.timeLSAPE
+      << "s, line search " << t.timeLineSearch << "s)";
+  return out;
+}
+
+/**
+ * @brief Comparison of the pairs of a sequence refined from a composed mapping with the same pairs
+ *        refined from the usual initialization, see IPFPGraphEditDistance::sequenceDistances
+ */
+struct IPFPWarmStartReport
+{
+  int nbPairs;            //!< pairs started from a composed or inverted mapping
+  long iterationsWarm;    //!< iterations of these pairs
+  long iterationsCold;    //!< iterations of the same pairs from the initialization of the method
+  double distanceWarm;    //!< sum of the distances of these pairs
+  double distanceCold;
+  double timeWarm;        //!< seconds spent on these pairs
+  double timeCold;
+
+  IPFPWarmStartReport(){ clear(); }
+
+  void clear(){
+    nbPairs = 0;
+    iterationsWarm = 0;
+    iterationsCold = 0;
+    distanceWarm = 0;
+    distanceCold = 0;
+    timeWarm = 0;
+    timeCold = 0;
+  }
+};
+
+
+inline std::ostream & operator<<(std::ostream & out, const IPFPWarmStartReport & r)
+{
+  out << r.nbPairs << " warm started pairs : " << r.iterationsWarm << " iterations vs " << r.iterationsCold
+      << " cold (" << r.iterationsCold - r.iterationsWarm << " saved), distances " << r.distanceWarm
+      << " vs " << r.distanceCold << ", time " << r.timeWarm << "s vs " << r.timeCold << "s";
+  return out;
+}
+
+#endif // __IPFPTELEMETRY_H__
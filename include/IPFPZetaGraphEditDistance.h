@@ -19,45 +19,47 @@ using namespace Eigen;
 #include "RandomWalksGraphEditDistance.h"
 #include "utils.h"
 
-template<class NodeAttribute, class EdgeAttribute>
+template<class NodeAttribute, class EdgeAttribute, class Real = double>
 class IPFPZetaGraphEditDistance:
-  public virtual IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>{
+  public virtual IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>{
 protected:
+  typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic> MatrixR; //!< matrices of the solver, in the working precision
   
 private:
   double _zeta;
 protected:
   virtual void LinearSubProblem();
+  virtual void LinearSubProblem(const std::vector<int> & entries);
   virtual   double getCost(int * G1_to_G2,int * G2_to_G1, int n, int m);
-  virtual   double getCost(double * , int n, int m);
+  virtual   double getCost(Real * , int n, int m);
   virtual   double getAlpha();
   virtual   double getBeta();
+  virtual   double getDirectionAlpha();
+  virtual   double getDirectionBeta();
   
 public:
   IPFPZetaGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
 			    GraphEditDistance<NodeAttribute,EdgeAttribute> * ed_init,
 			    double zeta):
-    IPFPGraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction,ed_init),_zeta(zeta){};
+    IPFPGraphEditDistance<NodeAttribute,EdgeAttribute, Real>(costFunction,ed_init),_zeta(zeta){};
   IPFPZetaGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
 			    double zeta):
-    IPFPGraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),_zeta(zeta){};
+    IPFPGraphEditDistance<NodeAttribute,EdgeAttribute, Real>(costFunction),_zeta(zeta){};
   
   void setZeta(double zeta){
     this->_zeta = zeta;
   };
-  double * getCurrentMatrix(){
+  Real * getCurrentMatrix(){
     return this->Xk;
   }
 
-  void setCurrentMatrix(double * Matrix, int n, int m ){//N and m are matrix sizes
-    if(this->Xk == NULL)
-      this->Xk = new double[n*m];
-    memcpy(this->Xk,Matrix,n*m*sizeof(double));  
+  void setCurrentMatrix(Real * Matrix, int n, int m ){//N and m are matrix sizes
+    this->reserveWorkspace(n-1,m-1);
+    memcpy(this->Xk,Matrix,n*m*sizeof(Real));  
   }
 
   void setCurrentMatrix(int * G1_to_G2, int * G2_to_G1, int n, int m ){//N and m are graph sizes
-    if(this->Xk == NULL)
-      this->Xk = new double[(n+1)*(m+1)];
+    this->reserveWorkspace(n,m);
     this->mappingsToMatrix(G1_to_G2,G2_to_G1,n,m, this->Xk);
   }
 
@@ -65,47 +67,80 @@ public:
 };
 
 
-template<class NodeAttribute, class EdgeAttribute>
-void IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 LinearSubProblem(){
-  Map<MatrixXd> m_linearSubProblem(this->linearSubProblem,this->_n+1,this->_m+1);
+  Map<MatrixR> m_linearSubProblem(this->linearSubProblem,this->_n+1,this->_m+1);
 
-  Map<MatrixXd> m_XkD(this->XkD,this->_n+1,this->_m+1);
-  Map<MatrixXd> m_Xk(this->Xk,this->_n+1,this->_m+1);
-  Map<MatrixXd> m_C(this->C,this->_n+1,this->_m+1);
+  Map<MatrixR> m_XkD(this->XkD,this->_n+1,this->_m+1);
+  Map<MatrixR> m_Xk(this->Xk,this->_n+1,this->_m+1);
+  Map<MatrixR> m_C(this->C,this->_n+1,this->_m+1);
   
   m_linearSubProblem = ((m_XkD + m_C) * (1.-fabs(this->_zeta)) + m_Xk*this->_zeta*2) ;
   
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute>::
-getCost(double * Matrix, int n, int m){
-  double S_k = IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::getCost(Matrix, n, m);
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+LinearSubProblem(const std::vector<int> & entries){
+  for (unsigned int q=0; q<entries.size(); q++){
+    int e = entries[q];
+    this->linearSubProblem[e] = ((this->XkD[e] + this->C[e]) * (1.-fabs(this->_zeta)) + this->Xk[e]*this->_zeta*2);
+  }
+}
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+getCost(Real * Matrix, int n, int m){
+  double S_k = IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::getCost(Matrix, n, m);
+  if (this->_XkIsSparse)
+    return S_k*(1-fabs(this->_zeta)) + this->_zeta*this->linearCost(this->Xk,this->_XkSparse,n+1);
   return S_k*(1-fabs(this->_zeta)) + this->_zeta*this->linearCost(this->Xk,this->Xk,n+1,m+1);
 }
 
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getCost(int * G1_to_G2,int * G2_to_G1, int n, int m){
-  double S_k = IPFPGraphEditDistance<NodeAttribute, EdgeAttribute>::getCost(G1_to_G2,G2_to_G1, n, m);
-  return S_k*(1-fabs(this->_zeta)) + this->_zeta*this->linearCost(this->bkp1,this->bkp1,n+1,m+1);
+  double S_k = IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::getCost(G1_to_G2,G2_to_G1, n, m);
+  // x^Tx of a binary matrix is its number of non-zero entries
+  int nnz = n;
+  for (int j=0; j<m; j++)
+    if (G2_to_G1[j] >= n) nnz++;
+  return S_k*(1-fabs(this->_zeta)) + this->_zeta*nnz;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getAlpha(){
   return this->R.back() - 2 * this->S[this->k] + (1.-fabs(this->_zeta))*this->oldLterm;
 }
 
-template<class NodeAttribute, class EdgeAttribute>
-double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute>::
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
 getBeta(){
   return this->S.back() + this->S[this->k] - this->R.back() - (1.-fabs(this->_zeta))*this->oldLterm;
 }
 
 
+// Along d, (1-|zeta|)(x^TDx + c^Tx) + zeta.x^Tx grows by t(1-|zeta|)(2d^TDx + c^Td) + 2t.zeta.d^Tx
+// and t^2((1-|zeta|)d^TDd + zeta.d^Td). The linear subproblem is not this gradient.
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+getDirectionAlpha(){
+  int rows = this->_n+1, cols = this->_m+1;
+  return (1.-fabs(this->_zeta))*(2*this->linearCost(this->XkD, this->_dirX, rows, cols) +
+                                 this->linearCost(this->C, this->_dirX, rows, cols)) +
+    2*this->_zeta*this->linearCost(this->Xk, this->_dirX, rows, cols);
+}
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+double IPFPZetaGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+getDirectionBeta(){
+  int rows = this->_n+1, cols = this->_m+1;
+  return (1.-fabs(this->_zeta))*this->linearCost(this->_dirD, this->_dirX, rows, cols) +
+    this->_zeta*this->linearCost(this->_dirX, this->_dirX, rows, cols);
+}
 
 
 
@@ -0,0 +1,74 @@
+/**
+ * @file KDTree.h
+ * @version     0.0.1
+ *
+ * KD-tree over a set of 2D points, for the radius queries of the geometric candidate
+ * restriction, see PointDistanceCost.h
+ */
+
+#ifndef __KDTREE_H__
+#define __KDTREE_H__
+
+#include <vector>
+#include <algorithm>
+
+/**
+ * @brief Implicit KD-tree over 2D points : the points are reordered so that each range is split
+ *        at its median, alternately on x and y. \f$O(n\log n)\f$ to build.
+ */
+class KDTree2D
+{
+private:
+  std::vector<int> _idx;   //!< points in tree order
+  std::vector<double> _x;
+  std::vector<double> _y;
+
+  void build(int lo, int hi, int axis){
+    if (hi - lo <= 1) return;
+    int mid = (lo + hi) / 2;
+    const std::vector<double> & c = axis ? _y : _x;
+    std::nth_element(_idx.begin()+lo, _idx.begin()+mid, _idx.begin()+hi,
+                     [&c](int a, int b){ return c[a] < c[b]; });
+    build(lo, mid, 1-axis);
+    build(mid+1, hi, 1-axis);
+  }
+
+  void query(int lo, int hi, int axis, double x, double y, double r2, std::vector<int> & out) const {
+    if (lo >= hi) return;
+    int mid = (lo + hi) / 2;
+    int p = _idx[mid];
+    double dx = x - _x[p];
+    double dy = y - _y[p];
+    if (dx*dx + dy*dy <= r2) out.push_back(p);
+    // Points before mid are on the lower side of the split, points after on the upper side
+    double d = axis ? dy : dx;
+    if (d <= 0 || d*d <= r2) query(lo, mid, 1-axis, x, y, r2, out);
+    if (d >= 0 || d*d <= r2) query(mid+1, hi, 1-axis, x, y, r2, out);
+  }
+
+public:
+  KDTree2D(){}
+
+  /**
+   * @brief Build the tree over the n points (x[i], y[i])
+   */
+  KDTree2D(const double * x, const double * y, int n):
+    _idx(n), _x(x, x+n), _y(y, y+n)
+  {
+    for (int i=0; i<n; i++) _idx[i] = i;
+    build(0, n, 0);
+  }
+
+  int size() const { return _idx.size(); }
+
+  /**
+   * @brief Indices, in increasing order, of the points at distance at most r of (x,y)
+   */
+  void radiusQuery(double x, double y, double r, std::vector<int> & out) const {
+    out.clear();
+    query(0, _idx.size(), 0, x, y, r*r, out);
+    std::sort(out.begin(), out.end());
+  }
+};
+
+#endif // __KDTREE_H__
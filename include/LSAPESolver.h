@@ -0,0 +1,683 @@
+/**
+ * @file LSAPESolver.h
+ * @version     0.0.1
+ *
+ * In-tree solver of the Linear Sum Assignment Problem with Error-correction (LSAPE), and the
+ * policy selecting it or the Hungarian algorithm of the LSAPE library.
+ *
+ * The cost matrix is the \f$(n+1)\times(m+1)\f$ column-major matrix used everywhere in the
+ * toolbox : row \f$n\f$ holds the insertion costs, column \f$m\f$ the deletion costs, and entry
+ * \f$(n,m)\f$ is ignored. The problem is solved as a transportation problem where the
+ * \f$\epsilon\f$ row (resp. column) may be assigned up to \f$m\f$ (resp. \f$n\f$) times,
+ * so neither the \f$(n+m)\times(n+m)\f$ extended matrix nor its copies of \f$\epsilon\f$ are built.
+ */
+
+#ifndef __LSAPESOLVER_H__
+#define __LSAPESOLVER_H__
+
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include "hungarian-lsape.hh"
+
+/**
+ * @brief Solvers of the LSAPE
+ */
+enum LSAPESolver {
+  LSAPE_HUNGARIAN,  //!< hungarianLSAPE of the LSAPE library
+  LSAPE_JV,         //!< in-tree Jonker-Volgenant like shortest augmenting paths, see \ref jvLSAPE
+  LSAPE_AUCTION,    //!< in-tree parallel auction with epsilon scaling, see \ref auctionLSAPE
+  LSAPE_GREEDY_ROW,      //!< approximation, each row takes its best free column, see \ref greedyRowLSAPE
+  LSAPE_GREEDY_SORT,     //!< approximation, pairs taken by increasing gain, see \ref greedySortLSAPE
+  LSAPE_GREEDY_REFINED   //!< approximation, LSAPE_GREEDY_SORT improved by 2-opt, see \ref twoOptLSAPE
+};
+
+
+/**
+ * @brief  Solve the LSAPE by shortest augmenting paths, in the spirit of Jonker and Volgenant
+ *
+ *   Columns are reduced and their tight rows are assigned first, then each unassigned column
+ *   (the \f$\epsilon\f$ column as many times as needed) is augmented along a shortest path
+ *   found by Dijkstra on the reduced costs. Paths grow column by column, each step scanning a
+ *   contiguous column of C with a branch free loop the compiler can vectorize.
+ *
+ *   On exit, u and v are optimal duals with \f$u_n = v_m = 0\f$, \f$u_i + v_j \leq c_{ij}\f$,
+ *   \f$u_i \leq c_{i\epsilon}\f$ and \f$v_j \leq c_{\epsilon j}\f$.
+ *
+ * @param C         \f$(n+1)\times(m+1)\f$ cost matrix, column-major, finite entries
+ * @param nrows     n+1
+ * @param ncols     m+1
+ * @param rho       assignment of the rows : \f$\rho_i \in \{0,\ldots,m\}\f$, m for a deletion
+ * @param varrho    assignment of the columns : \f$\varrho_j \in \{0,\ldots,n\}\f$, n for an insertion
+ * @param u         duals of the rows (n+1)
+ * @param v         duals of the columns (m+1)
+ * @param warmDuals       start from the row duals given in u (e.g. the ones of a close problem) instead of 0
+ * @param warmAssignment  keep the pairs of the given rho and varrho which are tight w.r.t. the initial duals
+ */
+template <typename DT>
+void jvLSAPE(const DT * C, const int & nrows, const int & ncols, int * rho, int * varrho, DT * u, DT * v,
+             bool warmDuals = false, bool warmAssignment = false)
+{
+  const int n = nrows-1;
+  const int m = ncols-1;
+  const DT inf = std::numeric_limits<DT>::infinity();
+
+  if (!warmDuals)
+    for (int i=0; i<=n; i++) u[i] = 0;
+
+  // Column reduction : v_j = min_i c_ij - u_i, the entry (n,m) counting as 0
+  for (int j=0; j<=m; j++){
+    const DT * Cj = C + j*nrows;
+    DT vj = ((j<m) ? Cj[n] : 0) - u[n];
+    for (int i=0; i<n; i++)
+      vj = std::min(vj, Cj[i] - u[i]);
+    v[j] = vj;
+  }
+
+  // Initial assignment : the given (or the minimal) pairs which are tight
+  int * rhoInit = NULL;
+  int * varrhoInit = NULL;
+  if (warmAssignment){
+    rhoInit = new int[n];
+    varrhoInit = new int[m];
+    memcpy(rhoInit, rho, sizeof(int)*n);
+    memcpy(varrhoInit, varrho, sizeof(int)*m);
+  }
+  for (int i=0; i<n; i++) rho[i] = -1;
+  for (int j=0; j<m; j++) varrho[j] = -1;
+  int nbEpsRow = 0;  // columns fed by the epsilon row, epsilon column included
+  int nbEpsEps = 0;  // units from the epsilon row to the epsilon column
+  int nbEpsCol = 0;  // rows assigned to the epsilon column, epsilon row included
+
+  for (int j=0; j<m; j++){
+    const DT * Cj = C + j*nrows;
+    int i = -1;
+    if (warmAssignment){
+      int k = varrhoInit[j];
+      if (k == n || (k >= 0 && k < n && rhoInit[k] == j)) i = k;
+    }
+    else{
+      // Last row reaching the minimum
+      for (int k=n; k>=0 && i<0; k--)
+        if (((k<n) ? Cj[k] - u[k] : Cj[n] - u[n]) == v[j]) i = k;
+    }
+    if (i < 0 || (i<n && rho[i] >= 0)) continue;
+    if (Cj[i] - u[i] - v[j] != 0) continue;
+    varrho[j] = i;
+    if (i<n) rho[i] = j; else nbEpsRow++;
+  }
+  for (int i=0; i<n; i++)
+    if (rho[i] < 0 && (!warmAssignment || rhoInit[i] == m) && C[i+m*nrows] - u[i] - v[m] == 0){
+      rho[i] = m;
+      nbEpsCol++;
+    }
+  delete [] rhoInit;
+  delete [] varrhoInit;
+
+  // Workspace of the shortest paths
+  DT * d = new DT[nrows];         // distance of the rows
+  int * pred = new int[nrows];    // column from which the row has been reached
+  DT * dRow = new DT[nrows];      // final distance of the settled rows
+  int * predRow = new int[nrows]; // final predecessor of the settled rows
+  char * settled = new char[nrows];
+  int * settledRows = new int[nrows];
+  DT * dCol = new DT[ncols];      // distance of the scanned columns
+  int * predCol = new int[ncols]; // row from which the column has been reached
+  char * scanned = new char[ncols];
+  int * scannedCols = new int[ncols];
+  memset(scanned, 0, ncols);
+
+  // Relaxation of the rows from column c, reached from row r at distance dc
+  auto scanColumn = [&](int c, DT dc, int r, int & nbScanned){
+    dCol[c] = dc;
+    predCol[c] = r;
+    scanned[c] = 1;
+    scannedCols[nbScanned++] = c;
+    const DT * Cc = C + c*nrows;
+    const DT h = dc - v[c];
+    #ifdef _OPENMP
+    #pragma omp simd
+    #endif
+    for (int i=0; i<n; i++){
+      DT di = h + Cc[i] - u[i];
+      bool better = di < d[i];
+      d[i] = better ? di : d[i];
+      pred[i] = better ? c : pred[i];
+    }
+    DT dn = h + ((c<m) ? Cc[n] : 0) - u[n];
+    if (dn < d[n]){ d[n] = dn; pred[n] = c; }
+  };
+
+  // Augmentations : real columns first, then the epsilon column until it holds n rows
+  for (int f=0; f<m || nbEpsCol<n; f++){
+    const int start = (f<m) ? f : m;
+    if (start<m && varrho[start] >= 0) continue;
+
+    for (int i=0; i<=n; i++){ d[i] = inf; pred[i] = start; }
+    memset(settled, 0, nrows);
+    int nbSettled = 0;
+    int nbScanned = 0;
+    int end = -1;
+
+    scanColumn(start, 0, -1, nbScanned);
+    while (true){
+      // Settle the closest row
+      int r = -1;
+      DT dmin = inf;
+      for (int i=0; i<=n; i++)
+        if (!settled[i] && d[i] < dmin){ dmin = d[i]; r = i; }
+      if (r < 0) break; // Only with infinite costs
+      settled[r] = 1;
+      settledRows[nbSettled++] = r;
+      dRow[r] = dmin;
+      predRow[r] = pred[r];
+      if ((r<n) ? rho[r] < 0 : nbEpsRow < m){
+        end = r;
+        break;
+      }
+      // Columns fed by r are reached at the distance of r, through tight arcs
+      if (r<n){
+        if (!scanned[rho[r]]) scanColumn(rho[r], dmin, r, nbScanned);
+      }
+      else{
+        for (int j=0; j<m; j++)
+          if (varrho[j] == n && !scanned[j]) scanColumn(j, dmin, r, nbScanned);
+        if (nbEpsEps > 0 && !scanned[m]) scanColumn(m, dmin, r, nbScanned);
+      }
+    }
+    if (end < 0) break;
+
+    // Update the duals of the settled rows and scanned columns, so that the path becomes tight
+    const DT dEnd = dRow[end];
+    for (int k=0; k<nbSettled; k++){
+      int r = settledRows[k];
+      u[r] += dRow[r] - dEnd;
+    }
+    for (int k=0; k<nbScanned; k++){
+      int j = scannedCols[k];
+      v[j] -= dCol[j] - dEnd;
+    }
+
+    // Flip the assignments along the path
+    int r = end;
+    if (r == n) nbEpsRow++;
+    if (start == m) nbEpsCol++;
+    while (true){
+      int j = predRow[r];
+      if (r<n) rho[r] = j;
+      if (j<m) varrho[j] = r;
+      else if (r == n) nbEpsEps++;
+      if (j == start) break;
+      int prev = predCol[j];
+      if (prev == n && j == m) nbEpsEps--;
+      r = prev;
+    }
+    for (int k=0; k<nbScanned; k++) scanned[scannedCols[k]] = 0;
+  }
+
+  // Duals in the LSAPE form, u_n = v_m = 0
+  if (nbEpsEps > 0){
+    DT a = u[n];
+    for (int i=0; i<n; i++) u[i] -= a;
+    for (int j=0; j<m; j++) v[j] += a;
+  }
+  else{
+    // No substitution : deletion and insertion costs are optimal duals
+    for (int i=0; i<n; i++) u[i] = C[i+m*nrows];
+    for (int j=0; j<m; j++) v[j] = C[n+j*nrows];
+  }
+  u[n] = 0;
+  v[m] = 0;
+
+  delete [] d;
+  delete [] pred;
+  delete [] dRow;
+  delete [] predRow;
+  delete [] settled;
+  delete [] settledRows;
+  delete [] dCol;
+  delete [] predCol;
+  delete [] scanned;
+  delete [] scannedCols;
+}
+
+
+/**
+ * @brief  Solve the LSAPE by a parallel forward auction with epsilon scaling, for large cost matrices
+ *
+ *   The auction runs on the \f$(n+m)\times(n+m)\f$ extension of the LSAPE without building it :
+ *   the bidders are the m columns, each of which may also take its own copy of the \f$\epsilon\f$ row,
+ *   and the n copies of the \f$\epsilon\f$ column, one per row, which may also take any copy of
+ *   the \f$\epsilon\f$ row at no cost. A column bids by scanning its contiguous entries of C.
+ *   At each round, all the unassigned bidders compute their bids in parallel (OpenMP), then each
+ *   row goes to its highest bidder.
+ *
+ *   The solution is optimal for integer costs, and otherwise within \f$(n+m)\epsilon\f$ of the
+ *   optimum. u and v are feasible duals in the LSAPE form, derived from the final prices, so
+ *   their sum is a lower bound which is tight up to the same amount.
+ *
+ * @param epsilon  final epsilon of the scaling, 0 for \f$1/(n+m+1)\f$ with integer costs and
+ *                 \f$10^{-9}\max|c_{ij}|/(n+m)\f$ otherwise
+ * @see jvLSAPE for the other parameters
+ */
+template <typename DT>
+void auctionLSAPE(const DT * C, const int & nrows, const int & ncols, int * rho, int * varrho, DT * u, DT * v,
+                  double epsilon = 0)
+{
+  const int n = nrows-1;
+  const int m = ncols-1;
+  const int N = n+m;  // number of bidders, and of objects : the n rows then the m copies of epsilon
+  const double inf = std::numeric_limits<double>::infinity();
+
+  double cmax = 0;
+  bool integer = true;
+  for (int j=0; j<=m; j++)
+    for (int i=0; i<=n; i++)
+      if (i<n || j<m){
+        double c = C[i+j*nrows];
+        cmax = std::max(cmax, fabs(c));
+        integer = integer && (c == floor(c));
+      }
+  double epsFinal = epsilon;
+  if (epsFinal <= 0)
+    epsFinal = integer ? 1.0/(N+1) : std::max(cmax, 1e-12) * 1e-9 / std::max(N, 1);
+
+  double * p = new double[N];        // prices of the objects
+  int * owner = new int[N];          // bidder holding each object
+  int * object = new int[N];         // object held by each bidder
+  int * bidders = new int[N];        // unassigned bidders
+  int * nextBidders = new int[N];
+  int * bidObject = new int[N];
+  double * bidValue = new double[N];
+  int * bestBid = new int[N];        // index in bidders of the best bid on each object
+  for (int k=0; k<N; k++){ p[k] = 0; bestBid[k] = -1; }
+
+  double eps = std::max(epsFinal, cmax/4);
+  while (true){
+    for (int k=0; k<N; k++){ owner[k] = -1; object[k] = -1; bidders[k] = k; }
+    int nbBidders = N;
+    while (nbBidders > 0){
+      #ifdef _OPENMP
+      #pragma omp parallel for schedule(static) if(nbBidders > 64)
+      #endif
+      for (int b=0; b<nbBidders; b++){
+        int k = bidders[b];
+        double w1 = -inf, w2 = -inf;
+        int o1 = -1;
+        if (k < m){
+          // Column k : the rows, and its copy of epsilon
+          const DT * Ck = C + k*nrows;
+          for (int i=0; i<n; i++){
+            double w = -Ck[i] - p[i];
+            if (w > w1){ w2 = w1; w1 = w; o1 = i; }
+            else if (w > w2) w2 = w;
+          }
+          double w = -Ck[n] - p[n+k];
+          if (w > w1){ w2 = w1; w1 = w; o1 = n+k; }
+          else if (w > w2) w2 = w;
+        }
+        else{
+          // Copy of epsilon for row i : deletion of i, or any copy of epsilon at no cost
+          int i = k-m;
+          w1 = -C[i+m*nrows] - p[i];
+          o1 = i;
+          for (int j=0; j<m; j++){
+            double w = -p[n+j];
+            if (w > w1){ w2 = w1; w1 = w; o1 = n+j; }
+            else if (w > w2) w2 = w;
+          }
+        }
+        bidObject[b] = o1;
+        bidValue[b] = p[o1] + ((w2 == -inf) ? 0 : w1 - w2) + eps;
+      }
+
+      // Each object goes to its highest bidder, the previous owner bids again at the next round
+      for (int b=0; b<nbBidders; b++){
+        int o = bidObject[b];
+        if (bestBid[o] < 0 || bidValue[b] > bidValue[bestBid[o]]) bestBid[o] = b;
+      }
+      int nbNext = 0;
+      for (int b=0; b<nbBidders; b++){
+        int o = bidObject[b];
+        if (bestBid[o] != b){
+          nextBidders[nbNext++] = bidders[b];
+          continue;
+        }
+        if (owner[o] >= 0){
+          object[owner[o]] = -1;
+          nextBidders[nbNext++] = owner[o];
+        }
+        owner[o] = bidders[b];
+        object[bidders[b]] = o;
+        p[o] = bidValue[b];
+      }
+      for (int b=0; b<nbBidders; b++) bestBid[bidObject[b]] = -1;
+      std::swap(bidders, nextBidders);
+      nbBidders = nbNext;
+    }
+    if (eps <= epsFinal) break;
+    eps = std::max(epsFinal, eps/5);
+  }
+
+  for (int j=0; j<m; j++){
+    varrho[j] = (object[j] < n) ? object[j] : n;
+    if (object[j] < n) rho[object[j]] = j;
+  }
+  for (int i=0; i<n; i++)
+    if (object[m+i] == i) rho[i] = m;
+
+  // Duals from the prices of the rows. Prices are defined up to a constant a : with
+  // u_i = min(a - p_i, c_ie) and g_j = min_i c_ij + p_i, the best v_j is min(c_ej, g_j - a), and
+  // the dual objective is concave in a, maximal where its slope
+  // #{i : a < p_i + c_ie} - #{j : a > g_j - c_ej} changes sign.
+  double * g = bidValue;
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(m > 64)
+  #endif
+  for (int j=0; j<m; j++){
+    const DT * Cj = C + j*nrows;
+    double gj = inf;
+    for (int i=0; i<n; i++)
+      gj = std::min(gj, Cj[i] + p[i]);
+    g[j] = gj;
+  }
+  std::vector<double> up(n), down(m);
+  for (int i=0; i<n; i++) up[i] = p[i] + C[i+m*nrows];
+  for (int j=0; j<m; j++) down[j] = g[j] - C[n+j*nrows];
+  std::sort(up.begin(), up.end());
+  std::sort(down.begin(), down.end());
+  // Largest a with #{i : up_i > a} >= #{j : down_j < a} : scan the breakpoints in increasing order
+  double a = (n > 0) ? up[0] : ((m > 0) ? down[m-1] : 0);
+  int iu = 0, id = 0;
+  while (iu < n || id < m){
+    double x = (id < m && (iu >= n || down[id] <= up[iu])) ? down[id] : up[iu];
+    // slope right after x
+    while (iu < n && up[iu] <= x) iu++;
+    while (id < m && down[id] <= x) id++;
+    a = x;
+    if ((n - iu) - id <= 0) break;
+  }
+  for (int i=0; i<n; i++)
+    u[i] = std::min((DT)(a - p[i]), C[i+m*nrows]);
+  u[n] = 0;
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(m > 64)
+  #endif
+  for (int j=0; j<m; j++){
+    const DT * Cj = C + j*nrows;
+    DT vj = Cj[n];
+    for (int i=0; i<n; i++)
+      vj = std::min(vj, Cj[i] - u[i]);
+    v[j] = vj;
+  }
+  v[m] = 0;
+
+  delete [] p;
+  delete [] owner;
+  delete [] object;
+  delete [] bidders;
+  delete [] nextBidders;
+  delete [] bidObject;
+  delete [] bidValue;
+  delete [] bestBid;
+}
+
+
+/**
+ * @brief Largest number of rows and of columns of the problems solved by \ref tinyLSAPEBatch
+ */
+#define TINY_LSAPE_MAX 6
+
+/**
+ * @brief  Optimal costs of a batch of small LSAPE of the same size, by dynamic programming over
+ *         the subsets of columns (of rows if there are more columns than rows)
+ *
+ *   The P problems are interleaved : entry (i,j) of problem p is <code>C[sub2ind(i,j,n+1)*P + p]</code>,
+ *   so that each step of the dynamic programming runs over the P problems in contiguous SIMD lanes.
+ *   Only the optimal costs are computed, which are the ones of the general solvers.
+ *
+ * @param C      P interleaved (n+1)x(m+1) cost matrices, with \f$n,m \leq\f$ TINY_LSAPE_MAX
+ * @param cost   optimal cost of each problem (P)
+ * @param work   workspace of \f$2^{\min(n,m)+1}P\f$ values, allocated here if NULL
+ */
+template <typename DT>
+void tinyLSAPEBatch(const DT * C, int n, int m, int P, DT * cost, DT * work = NULL)
+{
+  // States are the subsets of the M columns already taken by the first rows
+  int N = n, M = m, rs = 1, cs = n+1;
+  if (m > n){ N = m; M = n; rs = n+1; cs = 1; }
+  const int nbMasks = 1 << M;
+  const DT inf = std::numeric_limits<DT>::infinity();
+  DT * buffer = (work) ? work : new DT[2*nbMasks*P];
+  DT * dp = buffer;
+  DT * next = buffer + nbMasks*P;
+
+  for (int k=0; k<nbMasks*P; k++) dp[k] = inf;
+  for (int p=0; p<P; p++) dp[p] = 0;
+  for (int i=0; i<N; i++){
+    for (int k=0; k<nbMasks*P; k++) next[k] = inf;
+    const DT * Ceps = C + (i*rs + M*cs)*P;
+    for (int mask=0; mask<nbMasks; mask++){
+      if (__builtin_popcount(mask) > i) continue; // not reachable yet
+      const DT * d = dp + mask*P;
+      DT * nd = next + mask*P;
+      #ifdef _OPENMP
+      #pragma omp simd
+      #endif
+      for (int p=0; p<P; p++)
+        nd[p] = std::min(nd[p], d[p] + Ceps[p]);
+      for (int j=0; j<M; j++){
+        if (mask & (1<<j)) continue;
+        const DT * Cij = C + (i*rs + j*cs)*P;
+        DT * nj = next + (mask | (1<<j))*P;
+        #ifdef _OPENMP
+        #pragma omp simd
+        #endif
+        for (int p=0; p<P; p++)
+          nj[p] = std::min(nj[p], d[p] + Cij[p]);
+      }
+    }
+    std::swap(dp, next);
+  }
+
+  // The columns left are assigned to epsilon
+  for (int p=0; p<P; p++) cost[p] = inf;
+  for (int mask=0; mask<nbMasks; mask++){
+    DT * d = dp + mask*P;
+    for (int j=0; j<M; j++){
+      if (mask & (1<<j)) continue;
+      const DT * Cej = C + (N*rs + j*cs)*P;
+      #ifdef _OPENMP
+      #pragma omp simd
+      #endif
+      for (int p=0; p<P; p++)
+        d[p] += Cej[p];
+    }
+    #ifdef _OPENMP
+    #pragma omp simd
+    #endif
+    for (int p=0; p<P; p++)
+      cost[p] = std::min(cost[p], d[p]);
+  }
+
+  if (!work) delete [] buffer;
+}
+
+
+/**
+ * @brief  Approximate the LSAPE by a greedy assignment of the rows
+ *
+ *   Rows are visited in the given order, and each one takes the free column minimizing
+ *   \f$c_{ij} - c_{\epsilon j}\f$, or is deleted if \f$c_{i\epsilon}\f$ is lower.
+ *   Columns left free are inserted. \f$O(nm)\f$.
+ *
+ * @param order  permutation of the n rows giving the order of the visit, natural order if NULL
+ */
+template <typename DT>
+void greedyRowLSAPE(const DT * C, const int & nrows, const int & ncols, int * rho, int * varrho,
+                    const int * order = NULL)
+{
+  const int n = nrows-1;
+  const int m = ncols-1;
+  for (int j=0; j<m; j++) varrho[j] = n;
+
+  for (int t=0; t<n; t++){
+    int i = (order == NULL) ? t : order[t];
+    DT best = C[i+m*nrows];
+    int jbest = m;
+    for (int j=0; j<m; j++){
+      if (varrho[j] != n) continue;
+      DT d = C[i+j*nrows] - C[n+j*nrows];
+      if (d < best){ best = d; jbest = j; }
+    }
+    rho[i] = jbest;
+    if (jbest < m) varrho[jbest] = i;
+  }
+}
+
+
+/**
+ * @brief  Approximate the LSAPE by a greedy assignment of the pairs sorted by gain
+ *
+ *   The gain of a substitution is \f$c_{ij} - c_{i\epsilon} - c_{\epsilon j}\f$, the cost it
+ *   saves w.r.t. deleting i and inserting j. Pairs with a negative gain are sorted, then taken
+ *   while both of their ends are free. Remaining rows are deleted and columns inserted.
+ *   \f$O(nm\log(nm))\f$.
+ */
+template <typename DT>
+void greedySortLSAPE(const DT * C, const int & nrows, const int & ncols, int * rho, int * varrho)
+{
+  const int n = nrows-1;
+  const int m = ncols-1;
+  for (int i=0; i<n; i++) rho[i] = m;
+  for (int j=0; j<m; j++) varrho[j] = n;
+
+  std::vector< std::pair<DT,int> > pairs;
+  for (int j=0; j<m; j++){
+    const DT * Cj = C + j*nrows;
+    for (int i=0; i<n; i++){
+      DT gain = Cj[i] - C[i+m*nrows] - Cj[n];
+      if (gain < 0) pairs.push_back(std::make_pair(gain, i+j*nrows));
+    }
+  }
+  std::sort(pairs.begin(), pairs.end());
+
+  int nfree = std::min(n,m);
+  for (size_t p=0; p<pairs.size() && nfree > 0; p++){
+    int i = pairs[p].second % nrows;
+    int j = pairs[p].second / nrows;
+    if (rho[i] == m && varrho[j] == n){
+      rho[i] = j;
+      varrho[j] = i;
+      nfree--;
+    }
+  }
+}
+
+
+/**
+ * @brief  Improve an LSAPE assignment by 2-opt moves
+ *
+ *   A pass tries, for each row, to exchange its column (or \f$\epsilon\f$) with the one of
+ *   another row, and to move it to a free column or to \f$\epsilon\f$. Every improving move is
+ *   applied, and passes are repeated until none improves or maxPasses is reached.
+ *   \f$O(n(n+m))\f$ per pass.
+ *
+ * @return the number of moves applied
+ */
+template <typename DT>
+int twoOptLSAPE(const DT * C, const int & nrows, const int & ncols, int * rho, int * varrho,
+                int maxPasses = 10)
+{
+  const int n = nrows-1;
+  const int m = ncols-1;
+  // cost of the row i assigned to a, and of the column a if it is inserted
+  auto c  = [&](int i, int a) -> DT { return C[i+a*nrows]; };
+  auto ce = [&](int a) -> DT { return (a < m) ? C[n+a*nrows] : 0; };
+
+  int moves = 0;
+  for (int pass=0; pass<maxPasses; pass++){
+    int passMoves = 0;
+    for (int i=0; i<n; i++){
+      // swap with another row
+      for (int k=i+1; k<n; k++){
+        int a = rho[i], b = rho[k];
+        if (a == b) continue; // both deleted
+        if (c(i,b) + c(k,a) < c(i,a) + c(k,b)){
+          rho[i] = b; rho[k] = a;
+          if (b < m) varrho[b] = i;
+          if (a < m) varrho[a] = k;
+          passMoves++;
+        }
+      }
+      // move to a free column or to epsilon
+      for (int j=0; j<=m; j++){
+        int a = rho[i];
+        if (j == a || (j < m && varrho[j] != n)) continue;
+        if (c(i,j) + ce(a) < c(i,a) + ce(j)){
+          rho[i] = j;
+          if (a < m) varrho[a] = n;
+          if (j < m) varrho[j] = i;
+          passMoves++;
+        }
+      }
+    }
+    moves += passMoves;
+    if (passMoves == 0) break;
+  }
+  return moves;
+}
+
+
+/**
+ * @brief  Split the cost of an LSAPE assignment on u and v
+ *
+ *   \f$u_i = c_{i\rho_i}\f$, \f$v_j = c_{\epsilon j}\f$ for an inserted column and 0 otherwise,
+ *   so the sum of u and v is the cost of the assignment, as for optimal duals.
+ *   These are not feasible duals.
+ */
+template <typename DT>
+void splitLSAPECost(const DT * C, const int & nrows, const int & ncols,
+                    const int * rho, const int * varrho, DT * u, DT * v)
+{
+  const int n = nrows-1;
+  const int m = ncols-1;
+  for (int i=0; i<n; i++) u[i] = C[i+rho[i]*nrows];
+  for (int j=0; j<m; j++) v[j] = (varrho[j] == n) ? C[n+j*nrows] : 0;
+  u[n] = 0;
+  v[m] = 0;
+}
+
+
+/**
+ * @brief  Solve the LSAPE with the given solver
+ *
+ *   The warm start flags are only used by \ref LSAPE_JV, see \ref jvLSAPE.
+ *   The greedy solvers are approximations : their u and v only split the cost
+ *   of the assignment, see \ref splitLSAPECost.
+ */
+template <typename DT>
+void solveLSAPE(LSAPESolver solver, const DT * C, const int & nrows, const int & ncols,
+                int * rho, int * varrho, DT * u, DT * v,
+                bool warmDuals = false, bool warmAssignment = false)
+{
+  if (solver == LSAPE_JV)
+    jvLSAPE(C, nrows, ncols, rho, varrho, u, v, warmDuals, warmAssignment);
+  else if (solver == LSAPE_AUCTION)
+    auctionLSAPE(C, nrows, ncols, rho, varrho, u, v);
+  else if (solver == LSAPE_GREEDY_ROW || solver == LSAPE_GREEDY_SORT || solver == LSAPE_GREEDY_REFINED){
+    if (solver == LSAPE_GREEDY_ROW)
+      greedyRowLSAPE(C, nrows, ncols, rho, varrho);
+    else
+      greedySortLSAPE(C, nrows, ncols, rho, varrho);
+    if (solver == LSAPE_GREEDY_REFINED)
+      twoOptLSAPE(C, nrows, ncols, rho, varrho);
+    splitLSAPECost(C, nrows, ncols, rho, varrho, u, v);
+  }
+  else
+    hungarianLSAPE(C, nrows, ncols, rho, varrho, u, v, false);
+}
+
+#endif // __LSAPESOLVER_H__
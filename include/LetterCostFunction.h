@@ -5,10 +5,13 @@
 //#include <limits>
 #include "GraphEditDistance.h"
 #include "LetterGraph.h"
+#include "PointDistanceCost.h"
 
 
 
-class LetterDistanceCost:public EditDistanceCost<CMUPoint,double>
+class LetterDistanceCost:
+  public EditDistanceCost<CMUPoint,double>,
+  public PointDistanceCost<CMUPoint,double>
 {
 
 private:
@@ -26,6 +29,9 @@ public:
   virtual double EdgeDeletionCost(GEdge<double> * e1,Graph<CMUPoint,double> * g1);
   virtual double EdgeInsertionCost(GEdge<double> * e2,Graph<CMUPoint,double> * g2);
 
+  virtual void nodePoint(GNode<CMUPoint,double> * v, double & x, double & y) const;
+  virtual double substitutionRadius(double cost) const;
+
   virtual LetterDistanceCost * clone() const {return new LetterDistanceCost(*this);}
 
   LetterDistanceCost (double tn, double te, double a) :
@@ -8,6 +8,7 @@
 #define __MAPPING_GENERATOR_H
 
 #include <list>
+#include "graph.h"
 
 
 /**
@@ -30,4 +31,38 @@ template<class NodeAttribute, class EdgeAttribute>
 };
 
 
+/**
+ * @brief Convert an LSAPE assignment to the \f$(n+m)\f$ permutation returned by getMappings
+ *
+ *   Row i is mapped to column m+i when deleted, and column j to the first free row of
+ *   \f$\epsilon\f$ when substituted. Allocated with new[].
+ */
+inline int* lsapeToPermutation(const int * rho, const int * varrho, int n, int m)
+{
+  int* rhoperm = new int[n+m];
+  bool* epsAssign = new bool[n]; // is eps[i] assigned
+  for (int i=0; i<n; i++) epsAssign[i] = false;
+  for (int i=0; i<n; i++){
+    if (rho[i] < m)
+      rhoperm[i] = rho[i];
+    else{
+      rhoperm[i] = i+m;
+      epsAssign[i] = true;
+    }
+  }
+  int firstEpsNonAssign = 0;
+  for (int j=0; j<m; j++){
+    if (varrho[j] == n)
+      rhoperm[j+n] = j;
+    else{ // find the first epsilon not assigned
+      while (firstEpsNonAssign < n && epsAssign[firstEpsNonAssign]) firstEpsNonAssign++;
+      rhoperm[j+n] = firstEpsNonAssign + m;
+      epsAssign[firstEpsNonAssign] = true;
+    }
+  }
+  delete [] epsAssign;
+  return rhoperm;
+}
+
+
 #endif
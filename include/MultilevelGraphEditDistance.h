@@ -0,0 +1,445 @@
+/**
+ * @file MultilevelGraphEditDistance.h
+ * @version     0.0.1
+ *
+ * Coarsen-solve-refine approximation of the GED for graphs too large for the dense
+ * \f$(n+1)\times(m+1)\f$ formulations : both graphs are coarsened into a hierarchy, the coarsest
+ * pair is solved by another method, and the mapping is projected and refined level by level.
+ */
+
+#ifndef __MULTILEVELGRAPHEDITDISTANCE_H__
+#define __MULTILEVELGRAPHEDITDISTANCE_H__
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "GraphEditDistance.h"
+
+
+/**
+ * @brief Multilevel GED : coarsening by matching, solve of the coarsest pair, local search on each level
+ *
+ *   A level is coarsened by matching each node with one of its unmatched neighbours, the one of
+ *   lowest node substitution cost (label-aware), then of heaviest edge, i.e. merging the most
+ *   edges of the finest graph. The merged node keeps the attribute of the first node, a merged
+ *   edge the attribute of one of its edges. Both graphs are coarsened until they have at most
+ *   <code>_coarsestSize</code> nodes or the matching stalls.
+ *
+ *   The coarsest pair is solved by <code>_solver</code>. On each finer level, the members of a
+ *   coarse node are mapped to the members of its image by node costs, then the mapping is improved
+ *   by local search : each node of g1 tries to swap its image with the images of the neighbours of
+ *   its neighbours' images, or to be deleted, and the moves are evaluated on the edit cost of the
+ *   edges incident to the nodes involved. Memory and time are linear in the size of the graphs
+ *   for bounded degrees, apart from the coarsest solve.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class MultilevelGraphEditDistance:
+  public virtual GraphEditDistance<NodeAttribute, EdgeAttribute>
+{
+protected:
+
+  typedef Graph<NodeAttribute,EdgeAttribute> G;
+  typedef std::map<std::pair<int,int>, int> EdgeWeights; //!< number of finest edges merged in each edge
+
+  GraphEditDistance<NodeAttribute,EdgeAttribute> * _solver; //!< Method solving the coarsest pair
+  bool _cleanSolver;   //!< Delete the solver in the destructor if true
+  int _coarsestSize;   //!< Coarsening stops when both graphs have at most this number of nodes
+  int _maxLevels;      //!< Largest number of coarsening steps
+  int _nbPasses;       //!< Largest number of passes of the local search on each level
+  int _maxCandidates;  //!< Largest number of images tried for each node by the local search
+
+  std::vector<std::vector<std::pair<int, GEdge<EdgeAttribute>*> > > _in1, _in2; //!< in-edges of directed graphs
+
+  /**
+   * @brief Weight of the edge (u,v), 1 on the finest level (w NULL)
+   */
+  int edgeWeight(const EdgeWeights * w, int u, int v, bool directed) const;
+
+  /**
+   * @brief Coarsen g by a matching of its nodes
+   *
+   * @param w       weights of the edges of g, NULL on the finest level
+   * @param parent  node of the coarse graph containing each node of g
+   * @param cw      weights of the edges of the coarse graph
+   * @return the coarse graph, to be deleted by the caller
+   */
+  G * coarsen(G * g, const EdgeWeights * w, std::vector<int> & parent, EdgeWeights & cw);
+
+  /**
+   * @brief Map the members of each coarse node of g1 to the members of its image
+   *
+   * @param fc, fcinv  mappings between the coarse graphs, m (resp. n) of the coarse level for epsilon
+   * @param f, finv    mappings between g1 and g2, m (resp. n) for epsilon
+   */
+  void project(G * g1, G * g2, const std::vector<int> & parent1, const std::vector<int> & parent2,
+               int nc, int mc, const std::vector<int> & fc,
+               std::vector<int> & f, std::vector<int> & finv);
+
+  /**
+   * @brief Edit cost of the nodes of S1 and S2 and of the edges incident to them under f
+   *
+   *   S1 must contain the nodes of g1 whose image differs from another mapping, and S2 the nodes
+   *   of g2 whose preimage differs, so that the difference of two local costs is the
+   *   difference of the edit costs of the two mappings.
+   */
+  double localCost(G * g1, G * g2, const std::vector<int> & f, const std::vector<int> & finv,
+                   const int * S1, int k1, const int * S2, int k2);
+
+  /**
+   * @brief Improve f by swaps and deletions until no move decreases the edit cost
+   */
+  void localSearch(G * g1, G * g2, std::vector<int> & f, std::vector<int> & finv);
+
+public:
+
+  MultilevelGraphEditDistance( EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
+                               GraphEditDistance<NodeAttribute,EdgeAttribute> * coarseSolver,
+                               int coarsestSize = 100 ):
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
+    _solver(coarseSolver),
+    _cleanSolver(false),
+    _coarsestSize(coarsestSize),
+    _maxLevels(20),
+    _nbPasses(10),
+    _maxCandidates(64)
+  {}
+
+  MultilevelGraphEditDistance( const MultilevelGraphEditDistance<NodeAttribute,EdgeAttribute> & other ):
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(other.cf),
+    _solver(other._solver->clone()),
+    _cleanSolver(true),
+    _coarsestSize(other._coarsestSize),
+    _maxLevels(other._maxLevels),
+    _nbPasses(other._nbPasses),
+    _maxCandidates(other._maxCandidates)
+  {
+    this->setBudget(other._budget);
+  }
+
+  virtual ~MultilevelGraphEditDistance(){
+    if (_cleanSolver) delete _solver;
+  }
+
+  virtual void getOptimalMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
+                                  Graph<NodeAttribute,EdgeAttribute> * g2,
+                                  int * G1_to_G2, int * G2_to_G1 );
+
+  /**
+   * @brief Coarsening stops when both graphs have at most size nodes, 100 by default
+   */
+  void coarsestSize(int size){
+    this->_coarsestSize = size;
+  }
+
+  /**
+   * @brief Largest number of passes of the local search on each level, 10 by default, 0 to only project
+   */
+  void refinementPasses(int passes){
+    this->_nbPasses = passes;
+  }
+
+  /**
+   * @brief The budget stops the coarse solver and the local searches, the levels are still projected
+   */
+  virtual void setBudget(ComputeBudget * budget){
+    this->_budget = budget;
+    this->_solver->setBudget(budget);
+  }
+
+  virtual MultilevelGraphEditDistance<NodeAttribute,EdgeAttribute> * clone() const {
+    return new MultilevelGraphEditDistance<NodeAttribute,EdgeAttribute>(*this);
+  }
+};
+
+
+
+template<class NodeAttribute, class EdgeAttribute>
+int MultilevelGraphEditDistance<NodeAttribute, EdgeAttribute>::
+edgeWeight(const EdgeWeights * w, int u, int v, bool directed) const
+{
+  if (w == NULL) return 1;
+  if (!directed && v < u) std::swap(u, v);
+  typename EdgeWeights::const_iterator it = w->find(std::make_pair(u, v));
+  return (it == w->end()) ? 1 : it->second;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+Graph<NodeAttribute,EdgeAttribute> * MultilevelGraphEditDistance<NodeAttribute, EdgeAttribute>::
+coarsen(G * g, const EdgeWeights * w, std::vector<int> & parent, EdgeWeights & cw)
+{
+  const int n = g->Size();
+  const bool directed = g->isDirected();
+
+  // nodes of low degree first, so that they still find an unmatched neighbour
+  std::vector<int> order(n), degree(n);
+  for (int u=0; u<n; u++){ order[u] = u; degree[u] = (*g)[u]->Degree(); }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b){ return degree[a] < degree[b]; });
+
+  parent.assign(n, -1);
+  std::vector<int> rep; // first node of each coarse node
+  for (int t=0; t<n; t++){
+    int u = order[t];
+    if (parent[u] >= 0) continue;
+    int best = -1, bestW = 0;
+    double bestCost = 0;
+    for (GEdge<EdgeAttribute> * p = (*g)[u]->getIncidentEdges(); p; p = p->Next()){
+      int v = p->IncidentNode();
+      if (v == u || parent[v] >= 0) continue;
+      double c = this->cf->NodeSubstitutionCost((*g)[u], (*g)[v], g, g);
+      int wv = edgeWeight(w, u, v, directed);
+      if (best < 0 || c < bestCost || (c == bestCost && wv > bestW)){
+        best = v; bestCost = c; bestW = wv;
+      }
+    }
+    parent[u] = rep.size();
+    if (best >= 0) parent[best] = rep.size();
+    rep.push_back(u);
+  }
+
+  G * coarse = new G(directed);
+  for (unsigned int a=0; a<rep.size(); a++)
+    coarse->Add(new GNode<NodeAttribute,EdgeAttribute>(a, (*g)[rep[a]]->attr));
+
+  cw.clear();
+  for (int u=0; u<n; u++){
+    for (GEdge<EdgeAttribute> * p = (*g)[u]->getIncidentEdges(); p; p = p->Next()){
+      int v = p->IncidentNode();
+      int a = parent[u], b = parent[v];
+      if (a == b || (!directed && b < a)) continue; // undirected edges are linked both ways at once
+      std::pair<int,int> key(a, b);
+      typename EdgeWeights::iterator it = cw.find(key);
+      if (it == cw.end()){
+        coarse->Link(a, b, p->attr);
+        cw[key] = edgeWeight(w, u, v, directed);
+      }
+      else
+        it->second += edgeWeight(w, u, v, directed);
+    }
+  }
+  return coarse;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+void MultilevelGraphEditDistance<NodeAttribute, EdgeAttribute>::
+project(G * g1, G * g2, const std::vector<int> & parent1, const std::vector<int> & parent2,
+        int nc, int mc, const std::vector<int> & fc,
+        std::vector<int> & f, std::vector<int> & finv)
+{
+  const int n = g1->Size();
+  const int m = g2->Size();
+  std::vector<std::vector<int> > members1(nc), members2(mc);
+  for (int i=0; i<n; i++) members1[parent1[i]].push_back(i);
+  for (int j=0; j<m; j++) members2[parent2[j]].push_back(j);
+
+  f.assign(n, m);
+  finv.assign(m, n);
+  for (int a=0; a<nc; a++){
+    if (fc[a] >= mc) continue; // deleted with all its members
+    const std::vector<int> & A = members1[a];
+    const std::vector<int> & B = members2[fc[a]];
+    // at most 2 members each : try every injection of the smaller set into the larger one
+    double best = -1;
+    int bestA = 0, bestB = 0, bestSwap = 0;
+    for (unsigned int s=0; s<A.size(); s++){
+      for (unsigned int t=0; t<B.size(); t++){
+        double c = this->cf->NodeSubstitutionCost((*g1)[A[s]], (*g2)[B[t]], g1, g2);
+        if (A.size() == 2 && B.size() == 2)
+          c += this->cf->NodeSubstitutionCost((*g1)[A[1-s]], (*g2)[B[1-t]], g1, g2);
+        if (best < 0 || c < best){ best = c; bestA = s; bestB = t; bestSwap = (A.size() == 2 && B.size() == 2); }
+      }
+    }
+    f[A[bestA]] = B[bestB];
+    finv[B[bestB]] = A[bestA];
+    if (bestSwap){
+      f[A[1-bestA]] = B[1-bestB];
+      finv[B[1-bestB]] = A[1-bestA];
+    }
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+double MultilevelGraphEditDistance<NodeAttribute, EdgeAttribute>::
+localCost(G * g1, G * g2, const std::vector<int> & f, const std::vector<int> & finv,
+          const int * S1, int k1, const int * S2, int k2)
+{
+  const int n = g1->Size();
+  const int m = g2->Size();
+  const bool directed = g1->isDirected();
+  auto in1 = [&](int x){ for (int s=0; s<k1; s++) if (S1[s] == x) return true; return false; };
+  auto in2 = [&](int x){ for (int s=0; s<k2; s++) if (S2[s] == x) return true; return false; };
+
+  double cost = 0;
+  for (int s=0; s<k1; s++){
+    int a = S1[s];
+    if (f[a] < m) cost += this->cf->NodeSubstitutionCost((*g1)[a], (*g2)[f[a]], g1, g2);
+    else cost += this->cf->NodeDeletionCost((*g1)[a], g1);
+
+    // each edge once : from its first end in S1
+    for (GEdge<EdgeAttribute> * p = (*g1)[a]->getIncidentEdges(); p; p = p->Next()){
+      int b = p->IncidentNode();
+      if (!directed && b < a && in1(b)) continue;
+      GEdge<EdgeAttribute> * e2 = (f[a] < m && f[b] < m) ? g2->getEdge(f[a], f[b]) : NULL;
+      if (e2) cost += this->cf->EdgeSubstitutionCost(p, e2, g1, g2);
+      else cost += this->cf->EdgeDeletionCost(p, g1);
+    }
+    if (directed){
+      for (unsigned int t=0; t<_in1[a].size(); t++){
+        int b = _in1[a][t].first;
+        if (in1(b)) continue;
+        GEdge<EdgeAttribute> * e2 = (f[a] < m && f[b] < m) ? g2->getEdge(f[b], f[a]) : NULL;
+        if (e2) cost += this->cf->EdgeSubstitutionCost(_in1[a][t].second, e2, g1, g2);
+        else cost += this->cf->EdgeDeletionCost(_in1[a][t].second, g1);
+      }
+    }
+  }
+
+  for (int s=0; s<k2; s++){
+    int c = S2[s];
+    if (finv[c] >= n) cost += this->cf->NodeInsertionCost((*g2)[c], g2);
+
+    // substituted edges are counted with g1, only insertions here
+    for (GEdge<EdgeAttribute> * p = (*g2)[c]->getIncidentEdges(); p; p = p->Next()){
+      int d = p->IncidentNode();
+      if (!directed && d < c && in2(d)) continue;
+      if (finv[c] >= n || finv[d] >= n || !g1->isLinked(finv[c], finv[d]))
+        cost += this->cf->EdgeInsertionCost(p, g2);
+    }
+    if (directed){
+      for (unsigned int t=0; t<_in2[c].size(); t++){
+        int d = _in2[c][t].first;
+        if (in2(d)) continue;
+        if (finv[c] >= n || finv[d] >= n || !g1->isLinked(finv[d], finv[c]))
+          cost += this->cf->EdgeInsertionCost(_in2[c][t].second, g2);
+      }
+    }
+  }
+  return cost;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+void MultilevelGraphEditDistance<NodeAttribute, EdgeAttribute>::
+localSearch(G * g1, G * g2, std::vector<int> & f, std::vector<int> & finv)
+{
+  const int n = g1->Size();
+  const int m = g2->Size();
+
+  _in1.assign(g1->isDirected() ? n : 0, std::vector<std::pair<int, GEdge<EdgeAttribute>*> >());
+  _in2.assign(g2->isDirected() ? m : 0, std::vector<std::pair<int, GEdge<EdgeAttribute>*> >());
+  for (unsigned int a=0; a<_in1.size(); a++)
+    for (GEdge<EdgeAttribute> * p = (*g1)[a]->getIncidentEdges(); p; p = p->Next())
+      _in1[p->IncidentNode()].push_back(std::make_pair((int)a, p));
+  for (unsigned int c=0; c<_in2.size(); c++)
+    for (GEdge<EdgeAttribute> * p = (*g2)[c]->getIncidentEdges(); p; p = p->Next())
+      _in2[p->IncidentNode()].push_back(std::make_pair((int)c, p));
+
+  std::vector<int> targets;
+  std::vector<char> seen(m, 0);
+  bool improved = true;
+  for (int pass=0; pass<_nbPasses && improved && !this->budgetExhausted(); pass++){
+    improved = false;
+    for (int i=0; i<n; i++){
+      // images of the neighbours of the images of the neighbours of i, and epsilon
+      targets.clear();
+      for (GEdge<EdgeAttribute> * p = (*g1)[i]->getIncidentEdges(); p; p = p->Next()){
+        int fk = f[p->IncidentNode()];
+        if (fk >= m) continue;
+        for (GEdge<EdgeAttribute> * q = (*g2)[fk]->getIncidentEdges(); q; q = q->Next()){
+          int j = q->IncidentNode();
+          if (!seen[j] && (int)targets.size() < _maxCandidates){ seen[j] = 1; targets.push_back(j); }
+        }
+      }
+      for (unsigned int t=0; t<targets.size(); t++) seen[targets[t]] = 0;
+      targets.push_back(m);
+
+      for (unsigned int t=0; t<targets.size(); t++){
+        int j = targets[t];
+        int fi = f[i];
+        if (j == fi) continue;
+        int k = (j < m) ? finv[j] : n; // swap with k if j is taken
+
+        int S1[2], S2[2], k1 = 0, k2 = 0;
+        S1[k1++] = i;
+        if (k < n) S1[k1++] = k;
+        if (fi < m) S2[k2++] = fi;
+        if (j < m) S2[k2++] = j;
+
+        double before = localCost(g1, g2, f, finv, S1, k1, S2, k2);
+        f[i] = j;
+        if (j < m) finv[j] = i;
+        if (k < n){ f[k] = fi; if (fi < m) finv[fi] = k; }
+        else if (fi < m) finv[fi] = n;
+        double after = localCost(g1, g2, f, finv, S1, k1, S2, k2);
+
+        if (after < before - 1e-9)
+          improved = true;
+        else{
+          f[i] = fi;
+          if (fi < m) finv[fi] = i;
+          if (k < n){ f[k] = j; finv[j] = k; }
+          else if (j < m) finv[j] = n;
+        }
+      }
+    }
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+void MultilevelGraphEditDistance<NodeAttribute, EdgeAttribute>::
+getOptimalMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
+                   Graph<NodeAttribute,EdgeAttribute> * g2,
+                   int * G1_to_G2, int * G2_to_G1 )
+{
+  // Hierarchies, level 0 is the input graph
+  std::vector<G*> h1(1, g1), h2(1, g2);
+  std::vector<std::vector<int> > parent1, parent2;
+  std::vector<EdgeWeights> w1(1), w2(1);
+  while ((int)parent1.size() < _maxLevels &&
+         std::max(h1.back()->Size(), h2.back()->Size()) > _coarsestSize){
+    std::vector<int> p1, p2;
+    EdgeWeights cw1, cw2;
+    G * c1 = coarsen(h1.back(), h1.size() > 1 ? &w1.back() : NULL, p1, cw1);
+    G * c2 = coarsen(h2.back(), h2.size() > 1 ? &w2.back() : NULL, p2, cw2);
+    // the matching stalls on graphs with few edges
+    if (c1->Size() > 0.9*h1.back()->Size() && c2->Size() > 0.9*h2.back()->Size()){
+      delete c1;
+      delete c2;
+      break;
+    }
+    h1.push_back(c1); h2.push_back(c2);
+    parent1.push_back(p1); parent2.push_back(p2);
+    w1.push_back(cw1); w2.push_back(cw2);
+  }
+
+  int L = parent1.size();
+  int nc = h1[L]->Size(), mc = h2[L]->Size();
+  std::vector<int> f(nc), finv(mc);
+  _solver->getOptimalMapping(h1[L], h2[L], f.data(), finv.data());
+  for (int i=0; i<nc; i++) if (f[i] >= mc) f[i] = mc;
+  for (int j=0; j<mc; j++) if (finv[j] >= nc) finv[j] = nc;
+#if DEBUG
+  std::cerr << "Multilevel : " << L << " levels, coarsest graphs of " << nc << " and " << mc << " nodes" << std::endl;
+#endif
+
+  for (int l=L-1; l>=0; l--){
+    std::vector<int> fc;
+    fc.swap(f);
+    project(h1[l], h2[l], parent1[l], parent2[l], nc, mc, fc, f, finv);
+    localSearch(h1[l], h2[l], f, finv);
+    nc = h1[l]->Size();
+    mc = h2[l]->Size();
+  }
+
+  std::copy(f.begin(), f.end(), G1_to_G2);
+  std::copy(finv.begin(), finv.end(), G2_to_G1);
+  for (int l=1; l<=L; l++){
+    delete h1[l];
+    delete h2[l];
+  }
+}
+
+#endif // __MULTILEVELGRAPHEDITDISTANCE_H__
@@ -75,7 +75,9 @@ public:
     MultistartMappingRefinement<NodeAttribute, EdgeAttribute> (other.initGen->clone(), other.k),
     method(other.method->clone()),
     cleanMethod(true)
-  {}
+  {
+    this->setBudget(other._budget);
+  }
 
 
   ~MultistartRefinementGraphEditDistance(){
@@ -139,6 +141,17 @@ public:
   std::list<int*>& getReverseMappings(){ return refinedReverseMappings; }
 
 
+  /**
+   * @brief The budget is forwarded to the refinement method, and so to its clones on each start
+   */
+  virtual void setBudget(ComputeBudget * budget){
+    this->_budget = budget;
+    GraphEditDistance<NodeAttribute,EdgeAttribute> * ed =
+      dynamic_cast<GraphEditDistance<NodeAttribute,EdgeAttribute>*>(method);
+    if (ed) ed->setBudget(budget);
+  }
+
+
   /**
    * Clone
    */
@@ -0,0 +1,100 @@
+/**
+ * @file PointDistanceCost.h
+ * @version     0.0.1
+ *
+ * Candidate restriction for graphs whose nodes are 2D points (Letter dataset) : a substitution
+ * whose node cost exceeds the deletion plus the insertion of its nodes can be replaced by them,
+ * so only the pairs within a radius are kept, found with a KD-tree over the nodes of g2.
+ */
+
+#ifndef __POINTDISTANCECOST_H__
+#define __POINTDISTANCECOST_H__
+
+#include <vector>
+#include <algorithm>
+#include "GraphEditDistance.h"
+#include "SparseLSAPE.h"
+#include "KDTree.h"
+
+/**
+ * @brief Cost functions whose node substitution cost only grows with the distance between
+ *        the 2D points of the nodes
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class PointDistanceCost
+{
+public:
+  /**
+   * @brief Coordinates of the point of v
+   */
+  virtual void nodePoint(GNode<NodeAttribute,EdgeAttribute> * v, double & x, double & y) const = 0;
+
+  /**
+   * @brief Largest distance between two nodes whose substitution costs at most cost
+   */
+  virtual double substitutionRadius(double cost) const = 0;
+
+  virtual ~PointDistanceCost(){}
+};
+
+
+/**
+ * @brief  Select the substitutions of node cost lower than S.del[i] + S.ins[j]
+ *
+ *   With the deletion and insertion costs of the stars (node and incident edges) in S.del and
+ *   S.ins, any other substitution can be replaced by a deletion and an insertion without
+ *   increasing the edit cost, so no optimal mapping is lost.
+ *
+ *   If cf is a \ref PointDistanceCost, the candidates of i are searched in a KD-tree over the
+ *   nodes of g2, within the radius of \f$c_{i\epsilon} + \max_j c_{\epsilon j}\f$, in
+ *   \f$O(m\log m + n\log m + \textrm{candidates})\f$ for well spread points. Otherwise all
+ *   the pairs are scored. The node costs of the candidates are left in S.cost.
+ */
+template<class NodeAttribute, class EdgeAttribute, typename DT>
+void usefulCandidates(Graph<NodeAttribute,EdgeAttribute> * g1,
+                      Graph<NodeAttribute,EdgeAttribute> * g2,
+                      EditDistanceCost<NodeAttribute,EdgeAttribute> * cf,
+                      SparseCostMatrix<DT> & S)
+{
+  const int n = g1->Size();
+  const int m = g2->Size();
+  S.n = n;
+  S.m = m;
+  S.ptr.assign(1, 0);
+  S.col.clear();
+  S.cost.clear();
+
+  PointDistanceCost<NodeAttribute,EdgeAttribute> * pcf =
+    dynamic_cast<PointDistanceCost<NodeAttribute,EdgeAttribute> *>(cf);
+  if (pcf == NULL){
+    for (int i=0; i<n; i++){
+      for (int j=0; j<m; j++){
+        DT c = cf->NodeSubstitutionCost((*g1)[i],(*g2)[j],g1,g2);
+        if (c < S.del[i] + S.ins[j]){ S.col.push_back(j); S.cost.push_back(c); }
+      }
+      S.ptr.push_back(S.col.size());
+    }
+    return;
+  }
+
+  std::vector<double> x(m), y(m);
+  for (int j=0; j<m; j++) pcf->nodePoint((*g2)[j], x[j], y[j]);
+  KDTree2D tree(x.data(), y.data(), m);
+  DT maxIns = 0;
+  for (int j=0; j<m; j++) maxIns = std::max(maxIns, S.ins[j]);
+
+  std::vector<int> near;
+  for (int i=0; i<n; i++){
+    double xi, yi;
+    pcf->nodePoint((*g1)[i], xi, yi);
+    tree.radiusQuery(xi, yi, pcf->substitutionRadius(S.del[i] + maxIns), near);
+    for (unsigned int k=0; k<near.size(); k++){
+      int j = near[k];
+      DT c = cf->NodeSubstitutionCost((*g1)[i],(*g2)[j],g1,g2);
+      if (c < S.del[i] + S.ins[j]){ S.col.push_back(j); S.cost.push_back(c); }
+    }
+    S.ptr.push_back(S.col.size());
+  }
+}
+
+#endif // __POINTDISTANCECOST_H__
@@ -2,26 +2,47 @@
 #define __RANDOMMAPPINGS_H__
 
 
+#include <stdint.h>
 #include "BipartiteGraphEditDistanceMulti.h"
 #include "MappingGenerator.h"
-
+#include "RandomStream.h"
+
+/**
+ * @brief Uniformly random mappings
+ *
+ *   Mapping t of the pair (g1,g2) is drawn from the stream t of the seed \f$s\oplus h(g_1,g_2)\f$
+ *   (see \ref RandomStream), with h a hash of the sizes and edges of the graphs. The mappings are
+ *   generated in parallel, and the ones of a pair do not depend on the number of threads, nor on
+ *   the pairs given before to this generator or to its clones.
+ */
 template<class NodeAttribute, class EdgeAttribute>
 class RandomMappings :
   public MappingGenerator<NodeAttribute, EdgeAttribute>
 {
 protected:
 
-  std::default_random_engine randGen;
+  uint64_t _seed;
 
 public:
 
-  RandomMappings(unsigned int seed = 123)
-  {
-    randGen.seed(seed);
-  }
+  RandomMappings(unsigned int seed = 123):
+    _seed(seed)
+  {}
   
   virtual ~RandomMappings(){}
 
+  /**
+   * @brief Hash of the sizes and edges of g1 and g2, which identifies the streams of the pair
+   */
+  static uint64_t pairHash(Graph<NodeAttribute,EdgeAttribute> * g1,
+                           Graph<NodeAttribute,EdgeAttribute> * g2);
+
+  /**
+   * @brief Write k random permutations of \f$\{0,\ldots,size-1\}\f$ contiguously in buffer, of size k*size,
+   *        the t-th one from the stream t of the pair of hash pair
+   */
+  void randomPermutations(uint64_t pair, int size, int k, int * buffer);
+
 public:
 
   virtual std::list<int*> getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
@@ -55,12 +76,50 @@ public:
 				       Graph<NodeAttribute,EdgeAttribute> * g2,
 				       int k = -1 );
 
+  virtual RandomMappingsGED<NodeAttribute, EdgeAttribute> * clone() const {
+   return new RandomMappingsGED<NodeAttribute, EdgeAttribute>(*this);
+  }
+
 };
 
 
 
 
 
+template<class NodeAttribute, class EdgeAttribute>
+uint64_t RandomMappings<NodeAttribute, EdgeAttribute>::
+pairHash(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2)
+{
+  uint64_t h = 1469598103934665603ULL;
+  Graph<NodeAttribute,EdgeAttribute> * g[2] = {g1, g2};
+  for (int s=0; s<2; s++){
+    h = (h ^ (uint64_t)g[s]->Size()) * 1099511628211ULL;
+    for (int i=0; i<g[s]->Size(); i++){
+      h = (h ^ (uint64_t)(*g[s])[i]->Degree()) * 1099511628211ULL;
+      for (GEdge<EdgeAttribute> * e = (*g[s])[i]->getIncidentEdges(); e; e = e->Next())
+        h = (h ^ (uint64_t)e->IncidentNode()) * 1099511628211ULL;
+    }
+  }
+  return h;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+void RandomMappings<NodeAttribute, EdgeAttribute>::
+randomPermutations(uint64_t pair, int size, int k, int * buffer)
+{
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (int t=0; t<k; t++){
+    int* perm = buffer + (long)t*size;
+    for (int a=0; a<size; a++) perm[a] = a;
+    RandomStream rs(_seed ^ pair, t);
+    rs.shuffle(perm, size);
+  }
+}
+
+
 template<class NodeAttribute, class EdgeAttribute>
 std::list<int*> RandomMappings<NodeAttribute, EdgeAttribute>::
 getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
@@ -75,24 +134,18 @@ getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
   std::list<int*> mappings;
 
   int mx = std::max(n,m);
+  int* buffer = new int[(long)k*mx];
+  randomPermutations(this->pairHash(g1,g2), mx, k, buffer);
 
   for (int i=0; i<k; i++){
-    int* _map = new int[mx];
-    for (int a=0; a<m; a++)  _map[a] = a;
-    for (int a=m; a<mx; a++) _map[a] = -1; // if m<max(n,m) : complete with -1
-
-    std::shuffle(&_map[0], &_map[mx], randGen);
-
-
-    if (mx != n){
-      int* mapping = new int[n];
-      memcpy(mapping, _map, n*sizeof(int));
-      mappings.push_back(mapping);
-      delete [] _map;
+    int* mapping = new int[n];
+    for (int a=0; a<n; a++){
+      int j = buffer[(long)i*mx + a];
+      mapping[a] = (j < m) ? j : -1; // if m<max(n,m) : complete with -1
     }
-    else
-      mappings.push_back(_map);
+    mappings.push_back(mapping);
   }
+  delete [] buffer;
 
   return mappings;
 }
@@ -112,14 +165,15 @@ getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
   int m = g2->Size();
   
   std::list<int*> mappings;
+  int* buffer = new int[(long)k*(n+m)];
+  this->randomPermutations(this->pairHash(g1,g2), n+m, k, buffer);
   
   for (int i=0; i<k; i++){
     int* _map = new int[n+m];
-    for (int a=0; a<n+m; a++) _map[a] = a;
-    
-    std::shuffle(&_map[0], &_map[n+m], this->randGen);
+    std::copy(buffer + (long)i*(n+m), buffer + (long)(i+1)*(n+m), _map);
     mappings.push_back(_map);
   }
+  delete [] buffer;
   
   return mappings;
 }
@@ -0,0 +1,89 @@
+/**
+ * @file RandomStream.h
+ * @version     0.0.1
+ *
+ * Reproducible random numbers for parallel loops : each (seed, stream) pair has its own xoshiro256**
+ * generator, so a loop drawing the numbers of iteration t from stream t gives the same result for
+ * any number of threads.
+ */
+
+#ifndef __RANDOMSTREAM_H__
+#define __RANDOMSTREAM_H__
+
+#include <stdint.h>
+#include <limits>
+#include <algorithm>
+
+
+/**
+ * @brief xoshiro256** generator of the stream of a seed
+ *
+ *   The state is initialized by splitmix64 from the seed and the stream, as recommended by the
+ *   authors of xoshiro. Satisfies the UniformRandomBitGenerator requirements of the standard
+ *   distributions, but \ref below and \ref shuffle do not depend on the standard library.
+ */
+class RandomStream
+{
+protected:
+
+  uint64_t s[4];
+
+  static uint64_t rotl(uint64_t x, int k){ return (x << k) | (x >> (64 - k)); }
+
+  static uint64_t splitmix64(uint64_t & x){
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+public:
+
+  typedef uint64_t result_type;
+
+  static constexpr result_type min(){ return 0; }
+  static constexpr result_type max(){ return std::numeric_limits<uint64_t>::max(); }
+
+  RandomStream(uint64_t seed = 123, uint64_t stream = 0){
+    uint64_t x = seed;
+    x = splitmix64(x) + stream;
+    for (int i=0; i<4; i++) s[i] = splitmix64(x);
+  }
+
+  result_type operator()(){
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+  }
+
+  /**
+   * @brief Integer in [0, n), by a multiplication of the 32 high bits (bias below n/2^32)
+   */
+  uint32_t below(uint32_t n){
+    return (uint32_t)(((*this)() >> 32) * n >> 32);
+  }
+
+  /**
+   * @brief Real in [0, 1)
+   */
+  double uniform(){
+    return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  /**
+   * @brief Fisher-Yates shuffle of the n values at first
+   */
+  template <typename T>
+  void shuffle(T * first, int n){
+    for (int i=n-1; i>0; i--)
+      std::swap(first[i], first[below(i+1)]);
+  }
+};
+
+#endif // __RANDOMSTREAM_H__
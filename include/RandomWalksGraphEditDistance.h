@@ -36,6 +36,13 @@ protected:
   void computeCostMatrix(Graph<int,int> * g1,
 			 Graph<int,int> * g2);
 
+  // The random walks costs are only computed for all the pairs at once
+  void computeSparseCostMatrix(Graph<int,int> * g1,
+			       Graph<int,int> * g2,
+			       SparseCostMatrix<double> & S){
+    this->sparseFromDense(g1, g2, S);
+  }
+
 public:
   RandomWalksGraphEditDistance(ConstantEditDistanceCost * costFunction, int k):
     BipartiteGraphEditDistance<int,int>(costFunction),cf(costFunction),_k(k){};
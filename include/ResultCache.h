@@ -0,0 +1,416 @@
+/**
+ * @file ResultCache.h
+ * @version     0.0.1
+ *
+ * Persistent cache of edit distances and mappings, shared by the runs and processes which use the
+ * same file, so the pairs of graphs already computed by a method are never computed again.
+ */
+
+#ifndef __RESULTCACHE_H__
+#define __RESULTCACHE_H__
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "GraphEditDistance.h"
+
+/** Version of the results of the library, part of every key : change it when a method changes its results */
+#define GED_RESULTS_VERSION "0.0.1"
+
+
+inline uint64_t cacheMix(uint64_t h, uint64_t x){
+  h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+inline uint64_t cacheHashBytes(uint64_t h, const void * data, size_t size){
+  const unsigned char * p = (const unsigned char *)data;
+  for (size_t k=0; k<size; k++) h = (h ^ p[k]) * 1099511628211ULL;
+  return cacheMix(h, size);
+}
+
+/**
+ * @brief Hash of a label, from its bytes : overload it for the labels which hold pointers
+ */
+template<class Attribute>
+uint64_t hashAttribute(const Attribute & attr){
+  return cacheHashBytes(1469598103934665603ULL, &attr, sizeof(Attribute));
+}
+
+/**
+ * @brief Hash of the content of a graph : its labels and edges, in the order of its nodes
+ *
+ *   Unlike \ref GraphIsomorphism::hash, the hash depends on the order of the nodes, since the
+ *   approximations and the mappings do : a cached result is exactly the one the method would compute.
+ *   The order of the edges of a node does not matter.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+uint64_t contentHash(Graph<NodeAttribute,EdgeAttribute> * g){
+  const int n = g->Size();
+  uint64_t h = cacheMix(cacheMix(0, n), g->isDirected());
+  std::vector<std::pair<int, uint64_t> > edges;
+  for (int i=0; i<n; i++){
+    h = cacheMix(h, hashAttribute((*g)[i]->attr));
+    edges.clear();
+    for (GEdge<EdgeAttribute> * p = (*g)[i]->getIncidentEdges(); p; p = p->Next())
+      edges.push_back(std::make_pair(p->IncidentNode(), hashAttribute(p->attr)));
+    std::sort(edges.begin(), edges.end());
+    h = cacheMix(h, edges.size());
+    for (unsigned int t=0; t<edges.size(); t++)
+      h = cacheMix(cacheMix(h, edges[t].first), edges[t].second);
+  }
+  return h;
+}
+
+
+/**
+ * @brief Append-only file of results, keyed by (hash of g1, hash of g2, hash of the method)
+ *
+ *   The file starts with a magic number, followed by records : a header with the keys, the distance,
+ *   the sizes n and m of the mapping (0 if it is not stored) and a checksum, then the n+m entries of
+ *   G1_to_G2 and G2_to_G1, padded to 8 bytes. Records are never modified, the last one stored for a key wins.
+ *
+ *   Readers map the file in memory and take no lock : a record is only indexed once its checksum is
+ *   valid, so a record being appended by another process is ignored until it is complete. Writers
+ *   append whole records under an exclusive flock, so several processes can share the file. The file
+ *   is mapped again when it has grown, before a lookup is reported as a miss.
+ *
+ *   An object is not thread safe : give each thread its own object on the same file.
+ */
+class ResultCache
+{
+protected:
+
+  struct Record {
+    uint64_t g1, g2, method;
+    double distance;
+    int32_t n, m;
+    uint64_t checksum;
+  };
+
+  struct KeyHash {
+    size_t operator()(const std::pair<uint64_t, std::pair<uint64_t,uint64_t> > & k) const {
+      return cacheMix(cacheMix(k.first, k.second.first), k.second.second);
+    }
+  };
+
+  typedef std::pair<uint64_t, std::pair<uint64_t,uint64_t> > Key;
+
+  static const uint64_t MAGIC = 0x3148434143444547ULL; // "GEDCACH1"
+
+  int _fd;
+  const char * _data;   //!< mapped file, NULL if empty
+  size_t _mapped;       //!< size of the mapping
+  size_t _indexed;      //!< offset of the first record not indexed
+  std::unordered_map<Key, size_t, KeyHash> _index; //!< offset of the record of each key
+  long _hits, _misses;
+
+  static size_t recordSize(int n, int m){
+    return sizeof(Record) + ((sizeof(int32_t)*(n+m) + 7) & ~(size_t)7);
+  }
+
+  static uint64_t checksum(const Record & r, const int32_t * mapping){
+    uint64_t h = cacheMix(cacheMix(cacheMix(MAGIC, r.g1), r.g2), r.method);
+    h = cacheHashBytes(h, &r.distance, sizeof(double));
+    h = cacheMix(cacheMix(h, (uint32_t)r.n), (uint32_t)r.m);
+    return cacheHashBytes(h, mapping, sizeof(int32_t)*(r.n+r.m));
+  }
+
+  /**
+   * @brief Map the file again if it has grown, and index its new complete records
+   */
+  void refresh();
+
+  const Record * find(uint64_t g1, uint64_t g2, uint64_t method){
+    std::unordered_map<Key, size_t, KeyHash>::iterator it = _index.find(Key(method, std::make_pair(g1, g2)));
+    if (it == _index.end()){
+      refresh();
+      it = _index.find(Key(method, std::make_pair(g1, g2)));
+      if (it == _index.end()) return NULL;
+    }
+    return (const Record *)(_data + it->second);
+  }
+
+public:
+
+  /**
+   * @param filename  the file, created if it does not exist
+   */
+  ResultCache(const std::string & filename);
+
+  ~ResultCache(){
+    if (_data) munmap((void*)_data, _mapped);
+    if (_fd >= 0) close(_fd);
+  }
+
+  bool isOpen() const { return _fd >= 0; }
+
+  long getNbHits() const { return _hits; }
+  long getNbMisses() const { return _misses; }
+
+  /**
+   * @brief Hash of a method : its name, its parameters, its cost function and the version of the library
+   */
+  static uint64_t methodHash(const std::string & description){
+    std::string s = description + "@" GED_RESULTS_VERSION;
+    return cacheHashBytes(1469598103934665603ULL, s.data(), s.size());
+  }
+
+  /**
+   * @brief Stored distance of the pair, false if none
+   */
+  bool lookup(uint64_t g1, uint64_t g2, uint64_t method, double & distance){
+    const Record * r = find(g1, g2, method);
+    if (r == NULL){ _misses++; return false; }
+    _hits++;
+    distance = r->distance;
+    return true;
+  }
+
+  /**
+   * @brief Stored distance and mapping of the pair, false if none or if the mapping was not stored
+   */
+  bool lookup(uint64_t g1, uint64_t g2, uint64_t method, double & distance,
+              int * G1_to_G2, int n, int * G2_to_G1, int m){
+    const Record * r = find(g1, g2, method);
+    if (r == NULL || r->n != n || r->m != m){ _misses++; return false; }
+    _hits++;
+    distance = r->distance;
+    const int32_t * mapping = (const int32_t *)(r+1);
+    std::copy(mapping, mapping+n, G1_to_G2);
+    std::copy(mapping+n, mapping+n+m, G2_to_G1);
+    return true;
+  }
+
+  /**
+   * @brief Append a result, the mapping is not stored if G1_to_G2 is NULL
+   */
+  void store(uint64_t g1, uint64_t g2, uint64_t method, double distance,
+             const int * G1_to_G2 = NULL, int n = 0, const int * G2_to_G1 = NULL, int m = 0);
+};
+
+
+
+inline ResultCache::ResultCache(const std::string & filename):
+  _data(NULL), _mapped(0), _indexed(sizeof(uint64_t)), _hits(0), _misses(0)
+{
+  _fd = open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (_fd < 0) return;
+  flock(_fd, LOCK_EX);
+  struct stat st;
+  if (fstat(_fd, &st) == 0 && st.st_size == 0){
+    uint64_t magic = MAGIC;
+    if (write(_fd, &magic, sizeof(magic)) != (ssize_t)sizeof(magic)){
+      close(_fd); _fd = -1;
+    }
+  }
+  if (_fd >= 0) flock(_fd, LOCK_UN);
+  refresh();
+  if (_data && *(const uint64_t *)_data != MAGIC){
+    munmap((void*)_data, _mapped); _data = NULL;
+    close(_fd); _fd = -1;
+  }
+}
+
+
+inline void ResultCache::refresh()
+{
+  if (_fd < 0) return;
+  struct stat st;
+  if (fstat(_fd, &st) != 0 || (size_t)st.st_size <= _indexed) return;
+  if ((size_t)st.st_size != _mapped){
+    if (_data) munmap((void*)_data, _mapped);
+    _mapped = st.st_size;
+    void * p = mmap(NULL, _mapped, PROT_READ, MAP_SHARED, _fd, 0);
+    _data = (p == MAP_FAILED) ? NULL : (const char *)p;
+    if (_data == NULL){ _mapped = 0; return; }
+  }
+
+  while (_indexed + sizeof(Record) <= _mapped){
+    const Record * r = (const Record *)(_data + _indexed);
+    if (r->n < 0 || r->m < 0 || _indexed + recordSize(r->n, r->m) > _mapped ||
+        r->checksum != checksum(*r, (const int32_t *)(r+1)))
+      break; // incomplete record
+    _index[Key(r->method, std::make_pair(r->g1, r->g2))] = _indexed;
+    _indexed += recordSize(r->n, r->m);
+  }
+}
+
+
+inline void ResultCache::store(uint64_t g1, uint64_t g2, uint64_t method, double distance,
+                               const int * G1_to_G2, int n, const int * G2_to_G1, int m)
+{
+  if (_fd < 0) return;
+  if (G1_to_G2 == NULL || G2_to_G1 == NULL) n = m = 0;
+  std::vector<char> buffer(recordSize(n, m), 0);
+  Record * r = (Record *)&buffer[0];
+  r->g1 = g1; r->g2 = g2; r->method = method;
+  r->distance = distance;
+  r->n = n; r->m = m;
+  int32_t * mapping = (int32_t *)(r+1);
+  for (int i=0; i<n; i++) mapping[i] = G1_to_G2[i];
+  for (int j=0; j<m; j++) mapping[n+j] = G2_to_G1[j];
+  r->checksum = checksum(*r, mapping);
+
+  flock(_fd, LOCK_EX);
+  // a record left incomplete by a crash would hide the next ones : no write is in progress, drop it
+  refresh();
+  struct stat st;
+  if (fstat(_fd, &st) == 0 && (size_t)st.st_size > _indexed && ftruncate(_fd, _indexed) != 0){
+    flock(_fd, LOCK_UN);
+    return;
+  }
+  ssize_t written = write(_fd, &buffer[0], buffer.size());
+  flock(_fd, LOCK_UN);
+  if (written != (ssize_t)buffer.size()) return;
+  refresh();
+}
+
+
+
+/**
+ * @brief A graph edit distance looking up a \ref ResultCache before computing with another method
+ *
+ *   The description of the method must hold everything its results depend on (name, parameters,
+ *   costs), the graphs are identified by \ref contentHash. Mappings are stored if requested.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class CachedGraphEditDistance :
+  public GraphEditDistance<NodeAttribute, EdgeAttribute>
+{
+protected:
+
+  GraphEditDistance<NodeAttribute,EdgeAttribute> * _ed;
+  bool _cleanEd;          //!< Delete _ed in the destructor if true
+  std::string _filename;
+  ResultCache * _cache;
+  uint64_t _method;
+  std::string _description;
+  bool _storeMappings;
+
+public:
+
+  CachedGraphEditDistance( EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
+                           GraphEditDistance<NodeAttribute,EdgeAttribute> * ed,
+                           const std::string & filename, const std::string & description ):
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
+    _ed(ed),
+    _cleanEd(false),
+    _filename(filename),
+    _cache(new ResultCache(filename)),
+    _method(ResultCache::methodHash(description)),
+    _description(description),
+    _storeMappings(false)
+  {}
+
+  /**
+   * The copy has its own \ref ResultCache on the same file, and may be used by another thread
+   */
+  CachedGraphEditDistance( const CachedGraphEditDistance<NodeAttribute,EdgeAttribute> & other ):
+    GraphEditDistance<NodeAttribute,EdgeAttribute>(other.cf),
+    _ed(other._ed->clone()),
+    _cleanEd(true),
+    _filename(other._filename),
+    _cache(new ResultCache(other._filename)),
+    _method(other._method),
+    _description(other._description),
+    _storeMappings(other._storeMappings)
+  {
+    this->setBudget(other._budget);
+  }
+
+  virtual ~CachedGraphEditDistance(){
+    delete _cache;
+    if (_cleanEd) delete _ed;
+  }
+
+  /**
+   * @brief Store the mappings with the distances, false by default
+   */
+  void storeMappings(bool store = true){
+    this->_storeMappings = store;
+  }
+
+  const ResultCache & cache() const { return *_cache; }
+
+  /**
+   * @brief The cached method, e.g. to compute in batch the pairs missing from the cache
+   */
+  GraphEditDistance<NodeAttribute,EdgeAttribute> * method() const { return _ed; }
+
+  /**
+   * @brief Stored distance of the pair, false if none
+   */
+  bool lookup(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2,
+              double & distance){
+    return _cache->lookup(contentHash(g1), contentHash(g2), _method, distance);
+  }
+
+  /**
+   * @brief Store a distance of the cached method computed without this object
+   */
+  void store(Graph<NodeAttribute,EdgeAttribute> * g1, Graph<NodeAttribute,EdgeAttribute> * g2,
+             double distance){
+    _cache->store(contentHash(g1), contentHash(g2), _method, distance);
+  }
+
+  /**
+   * @brief Forwarded to the cached method. The results of the computations stopped by the budget
+   *        are returned but not stored
+   */
+  virtual void setBudget(ComputeBudget * budget){
+    this->_budget = budget;
+    _ed->setBudget(budget);
+  }
+
+  virtual double operator()(Graph<NodeAttribute,EdgeAttribute> * g1,
+                            Graph<NodeAttribute,EdgeAttribute> * g2)
+  {
+    uint64_t h1 = contentHash(g1), h2 = contentHash(g2);
+    double d;
+    if (_cache->lookup(h1, h2, _method, d)) return d;
+    if (!_storeMappings){
+      d = (*_ed)(g1, g2);
+      if (!this->budgetExhausted()) _cache->store(h1, h2, _method, d);
+      return d;
+    }
+    int n = g1->Size(), m = g2->Size();
+    int * G1_to_G2 = new int[n];
+    int * G2_to_G1 = new int[m];
+    _ed->getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    d = this->GedFromMapping(g1, g2, G1_to_G2, n, G2_to_G1, m);
+    if (!this->budgetExhausted()) _cache->store(h1, h2, _method, d, G1_to_G2, n, G2_to_G1, m);
+    delete [] G1_to_G2;
+    delete [] G2_to_G1;
+    return d;
+  }
+
+  virtual void getOptimalMapping(Graph<NodeAttribute,EdgeAttribute> * g1,
+                                 Graph<NodeAttribute,EdgeAttribute> * g2,
+                                 int * G1_to_G2, int * G2_to_G1)
+  {
+    uint64_t h1 = contentHash(g1), h2 = contentHash(g2);
+    int n = g1->Size(), m = g2->Size();
+    double d;
+    if (_cache->lookup(h1, h2, _method, d, G1_to_G2, n, G2_to_G1, m)) return;
+    _ed->getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    d = this->GedFromMapping(g1, g2, G1_to_G2, n, G2_to_G1, m);
+    if (!this->budgetExhausted()) _cache->store(h1, h2, _method, d, G1_to_G2, n, G2_to_G1, m);
+  }
+
+  virtual CachedGraphEditDistance<NodeAttribute, EdgeAttribute> * clone() const {
+    return new CachedGraphEditDistance<NodeAttribute, EdgeAttribute>(*this);
+  }
+};
+
+#endif // __RESULTCACHE_H__
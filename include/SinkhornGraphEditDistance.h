@@ -0,0 +1,203 @@
+/**
+ * @file SinkhornGraphEditDistance.h
+ * @version     0.0.1
+ *
+ * @todo the list of improvements suggested for the file.
+ * @bug the list of known bugs.
+ *
+ * Entropic mirror descent on the continuous relaxation of the GED quadratic problem.
+ * Each iteration multiplies Xk by \f$\exp(-\eta\nabla f(X_k))\f$ and projects the result
+ * back on the error-correcting doubly stochastic matrices with Sinkhorn scalings of the
+ * \f$(n+1)\times(m+1)\f$ matrix, with marginals \f$(1,\ldots,1,m)\f$ on rows and
+ * \f$(1,\ldots,1,n)\f$ on columns. The final Xk is rounded with a single LSAPE.
+ */
+
+#ifndef __SINKHORNGRAPHEDITDISTANCE_H__
+#define __SINKHORNGRAPHEDITDISTANCE_H__
+#include <Eigen/Dense>
+using namespace Eigen;
+#include "GraphEditDistance.h"
+#include "IPFPGraphEditDistance.h"
+#include "utils.h"
+
+template<class NodeAttribute, class EdgeAttribute, class Real = double>
+class SinkhornGraphEditDistance:
+  public IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>
+{
+
+protected:
+  typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic> MatrixR; //!< matrices of the solver, in the working precision
+
+
+  double _eta = 10.;           //!< largest change of \f$\log X\f$ allowed by one mirror step
+  int _sinkhornIter = 20;      //!< maximal number of scalings per projection
+  double _sinkhornTol = 1e-6;  //!< tolerance on the marginals of the projection
+  double _truncation = 1e-6;   //!< entries below it are ignored by the quadratic term
+
+  /**
+   * @brief Scale the rows and the columns of Xk until its marginals are the ones of the
+   *        error-correcting doubly stochastic matrices
+   */
+  void SinkhornProjection();
+
+  /**
+   * @brief Entropic mirror descent from the current Xk, assuming \ref IPFPsetup has been called
+   */
+  void SinkhornIterations(Graph<NodeAttribute,EdgeAttribute> * g1,
+			  Graph<NodeAttribute,EdgeAttribute> * g2);
+
+public:
+
+  SinkhornGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
+			    GraphEditDistance<NodeAttribute,EdgeAttribute> * ed_init):
+    IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>(costFunction, ed_init)
+  {};
+
+  SinkhornGraphEditDistance(EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction):
+    IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>(costFunction)
+  {};
+
+  SinkhornGraphEditDistance(const SinkhornGraphEditDistance & other):
+    IPFPGraphEditDistance<NodeAttribute, EdgeAttribute, Real>(other),
+    _eta(other._eta),
+    _sinkhornIter(other._sinkhornIter),
+    _sinkhornTol(other._sinkhornTol),
+    _truncation(other._truncation)
+  {};
+
+  /**
+   * @brief  Without init, the mirror descent starts from the flat matrix. Otherwise it starts from
+   *         the middle of the flat matrix and the init, as the multiplicative updates cannot
+   *         leave a vertex. The init is kept when the rounding of the descent is not better.
+   */
+  virtual void getBetterMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
+				 Graph<NodeAttribute,EdgeAttribute> * g2,
+				 int * G1_to_G2, int * G2_to_G1, bool fromInit=true);
+
+  void setEta(double eta){ this->_eta = eta; }
+  void setSinkhornIterations(int nb){ this->_sinkhornIter = nb; }
+
+  virtual SinkhornGraphEditDistance * clone() const { return new SinkhornGraphEditDistance(*this); }
+
+};
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void SinkhornGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+getBetterMapping( Graph<NodeAttribute,EdgeAttribute> * g1,
+                  Graph<NodeAttribute,EdgeAttribute> * g2,
+                  int * G1_to_G2, int * G2_to_G1, bool fromInit)
+{
+  this->_n = g1->Size();
+  this->_m = g2->Size();
+  this->reserveWorkspace(this->_n, this->_m);
+  Map<MatrixR> m_Xk(this->Xk,  this->_n+1,  this->_m+1);
+
+  int * init = NULL;
+  if (fromInit && this->_ed_init){
+    init = new int[this->_n + this->_m];
+    memcpy(init, G1_to_G2, sizeof(int)*this->_n);
+    memcpy(init + this->_n, G2_to_G1, sizeof(int)*this->_m);
+    this->Xk = this->mappingsToMatrix(G1_to_G2,G2_to_G1,this->_n,this->_m,this->Xk);
+    m_Xk = (m_Xk.array() + 1.) / 2.;
+  }
+  else
+    m_Xk.setOnes();
+  this->SinkhornProjection();
+
+  this->IPFPsetup(g1,g2);
+  this->SinkhornIterations(g1,g2);
+
+  m_Xk= MatrixR::Ones(this->_n+1, this->_m+1)-m_Xk;
+  double t = IPFPTelemetry::clock();
+  solveLSAPE(this->_lsapeSolver, this->Xk, this->_n+1, this->_m+1, G1_to_G2, G2_to_G1, this->_u, this->_v);
+  this->_nbLSAPE = 1;
+  this->_telemetry.nbLSAPE = 1;
+  this->_telemetry.timeLSAPE += IPFPTelemetry::clock() - t;
+
+  if (init){
+    if (this->GedFromMapping(g1, g2, init, this->_n, init + this->_n, this->_m) <
+        this->GedFromMapping(g1, g2, G1_to_G2, this->_n, G2_to_G1, this->_m)){
+      memcpy(G1_to_G2, init, sizeof(int)*this->_n);
+      memcpy(G2_to_G1, init + this->_n, sizeof(int)*this->_m);
+    }
+    delete [] init;
+  }
+  this->_telemetry.timeTotal = IPFPTelemetry::clock() - this->_telemetryStart;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void SinkhornGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+SinkhornProjection()
+{
+  int n = this->_n;
+  int m = this->_m;
+  Map<MatrixR> m_Xk(this->Xk, n+1, m+1);
+
+  // Marginals of the extended matrix : the dummy row and column carry the insertions and
+  // deletions, and the (n,m) entry the slack between both
+  Array<Real, Dynamic, 1> rows = Array<Real, Dynamic, 1>::Ones(n+1);
+  Array<Real, Dynamic, 1> cols = Array<Real, Dynamic, 1>::Ones(m+1);
+  rows(n) = m;
+  cols(m) = n;
+
+  // Column-major storage : the column scaling and the row sums are contiguous vector kernels
+  for (int it=0; it<this->_sinkhornIter; it++){
+    m_Xk.array().colwise() *= rows / m_Xk.rowwise().sum().array();
+    m_Xk.array().rowwise() *= (cols / m_Xk.colwise().sum().transpose().array()).transpose();
+    if (((m_Xk.rowwise().sum().array() - rows).abs() / rows).maxCoeff() < this->_sinkhornTol)
+      break;
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute, class Real>
+void SinkhornGraphEditDistance<NodeAttribute, EdgeAttribute, Real>::
+SinkhornIterations(Graph<NodeAttribute,EdgeAttribute> * g1,
+		   Graph<NodeAttribute,EdgeAttribute> * g2)
+{
+  int n = this->_n;
+  int m = this->_m;
+  Map<MatrixR> m_Xk(this->Xk, n+1, m+1);
+  Map<MatrixR> m_grad(this->linearSubProblem, n+1, m+1);
+  Map<MatrixR> m_Xprev(this->bkp1, n+1, m+1);
+
+  this->S.clear();
+  this->R.clear();
+  this->S.push_back(this->getCost(this->Xk,  this->_n,  this->_m));
+  this->k = 0;
+
+  bool flag_continue = true;
+  while((this->k < this->maxIter) && flag_continue && !this->budgetExhausted()){
+    this->LinearSubProblem();
+    // The (n,m) entry has no cost, it only balances the marginals
+    m_grad(n,m) = 0;
+
+    // Mirror step, scaled so that log(Xk) moves by at most _eta
+    double t = IPFPTelemetry::clock();
+    double range = m_grad.maxCoeff() - m_grad.minCoeff();
+    double eta = (range > 0.000001) ? this->_eta / range : 0.;
+    m_Xprev = m_Xk;
+    m_Xk = (m_Xk.array().log() - eta*m_grad.array()).matrix();
+    m_Xk = (m_Xk.array() - m_Xk.maxCoeff()).exp().matrix();
+    this->SinkhornProjection();
+
+    // Negligible entries are dropped from the quadratic term, which is the costly part
+    m_Xk = (m_Xk.array() < this->_truncation).select(0., m_Xk);
+    this->_telemetry.timeLineSearch += IPFPTelemetry::clock() - t;
+    this->IPFPupdateTerms(g1,g2);
+    this->S.push_back(this->getCost(this->Xk,  this->_n,  this->_m));
+
+    this->_telemetry.gap = (m_Xk - m_Xprev).cwiseAbs().maxCoeff();
+    flag_continue = (this->_telemetry.gap > this->epsilon);
+#if DEBUG
+    std::cout << "S(" << this->k+1 << ") = " << this->S.back() << std::endl;
+#endif
+    this->k++;
+  }
+  this->recordRun(!flag_continue);
+}
+
+
+#endif // __SINKHORNGRAPHEDITDISTANCE_H__
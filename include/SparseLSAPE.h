@@ -0,0 +1,216 @@
+/**
+ * @file SparseLSAPE.h
+ * @version     0.0.1
+ *
+ * LSAPE restricted to candidate substitutions. Only the candidate pairs of each row are stored,
+ * with the deletion and insertion costs, so memory and time scale with the number of candidates
+ * instead of \f$nm\f$. Pairs left out are never substituted.
+ */
+
+#ifndef __SPARSELSAPE_H__
+#define __SPARSELSAPE_H__
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <queue>
+#include <functional>
+
+/**
+ * @brief Substitutions kept as candidates of the LSAPE
+ */
+enum LSAPECandidates {
+  CANDIDATES_ALL,         //!< every substitution, the dense LSAPE is solved
+  CANDIDATES_TOP,         //!< the c cheapest substitutions of each node of g1
+  CANDIDATES_COMPATIBLE,  //!< the substitutions whose node cost is at most a threshold, e.g. 0 for equal labels
+  CANDIDATES_USEFUL       //!< the substitutions cheaper than a deletion and an insertion, see \ref usefulCandidates
+};
+
+
+/**
+ * @brief Cost matrix of the LSAPE restricted to candidate substitutions, by rows (CSR)
+ */
+template <typename DT>
+struct SparseCostMatrix {
+  int n;                 //!< number of rows (nodes of g1)
+  int m;                 //!< number of columns (nodes of g2)
+  std::vector<int> ptr;  //!< candidates of row i are in [ptr[i], ptr[i+1])
+  std::vector<int> col;  //!< column of each candidate
+  std::vector<DT> cost;  //!< substitution cost of each candidate
+  std::vector<DT> del;   //!< deletion cost of each row, \f$c_{i\epsilon}\f$
+  std::vector<DT> ins;   //!< insertion cost of each column, \f$c_{\epsilon j}\f$
+  SparseCostMatrix(): n(0), m(0) {}
+
+  int nbCandidates() const { return col.size(); }
+
+  /**
+   * @brief Gather the entries of the candidates, and the epsilon row and column, from a
+   *        dense \f$(n+1)\times(m+1)\f$ column-major matrix. ptr and col must be set.
+   */
+  void gather(const DT * C){
+    const int nrows = n+1;
+    cost.resize(col.size());
+    for (int i=0; i<n; i++)
+      for (int p=ptr[i]; p<ptr[i+1]; p++)
+        cost[p] = C[i+col[p]*nrows];
+    del.resize(n);
+    ins.resize(m);
+    for (int i=0; i<n; i++) del[i] = C[i+m*nrows];
+    for (int j=0; j<m; j++) ins[j] = C[n+j*nrows];
+  }
+};
+
+
+/**
+ * @brief  Select the candidates of each row from a score of the pairs
+ *
+ *   With \ref CANDIDATES_TOP, row i keeps the round(param) columns of lowest score (ties to the
+ *   lowest index), with \ref CANDIDATES_COMPATIBLE the columns whose score is at most param.
+ *   \ref CANDIDATES_USEFUL is selected by \ref usefulCandidates instead.
+ *   Scores are computed one row at a time, so no \f$n\times m\f$ matrix is built, and the
+ *   scores of the candidates are left in S.cost.
+ *
+ * @param score  score(i,j) of the substitution of i by j, e.g. the node substitution cost
+ */
+template <typename DT, class Score>
+void selectCandidates(int n, int m, Score score, LSAPECandidates mode, double param,
+                      SparseCostMatrix<DT> & S)
+{
+  S.n = n;
+  S.m = m;
+  S.ptr.assign(1, 0);
+  S.col.clear();
+  S.cost.clear();
+  int c = (mode == CANDIDATES_ALL) ? m : std::min(m, std::max(0, (int)(param+0.5)));
+  std::vector<std::pair<DT,int> > row(m);
+  for (int i=0; i<n; i++){
+    if (mode == CANDIDATES_COMPATIBLE){
+      for (int j=0; j<m; j++){
+        DT sc = score(i,j);
+        if (sc <= param){ S.col.push_back(j); S.cost.push_back(sc); }
+      }
+    }
+    else{
+      for (int j=0; j<m; j++) row[j] = std::make_pair(score(i,j), j);
+      if (c < m) std::nth_element(row.begin(), row.begin()+c, row.end());
+      std::sort(row.begin(), row.begin()+c, [](const std::pair<DT,int> & a, const std::pair<DT,int> & b){
+          return a.second < b.second; });
+      for (int k=0; k<c; k++){ S.col.push_back(row[k].second); S.cost.push_back(row[k].first); }
+    }
+    S.ptr.push_back(S.col.size());
+  }
+}
+
+
+/**
+ * @brief  Solve the LSAPE restricted to the candidates by shortest augmenting paths
+ *
+ *   Taking j saves its insertion, so row i pays \f$c_{ij} - c_{\epsilon j}\f$ for a candidate j
+ *   and \f$c_{i\epsilon}\f$ for its own copy of \f$\epsilon\f$. Each row is then augmented
+ *   along a shortest path found by Dijkstra with a heap on the reduced costs, only visiting
+ *   candidate pairs. \f$O(n\,(nc+n)\log(nc+n))\f$ in the worst case, for c candidates per row.
+ *
+ * @param rho       assignment of the rows : \f$\rho_i \in \{0,\ldots,m\}\f$, m for a deletion
+ * @param varrho    assignment of the columns : \f$\varrho_j \in \{0,\ldots,n\}\f$, n for an insertion
+ * @return the cost of the assignment
+ */
+template <typename DT>
+DT sparseLSAPE(const SparseCostMatrix<DT> & S, int * rho, int * varrho)
+{
+  const int n = S.n;
+  const int m = S.m;
+  const int nc = m+n; // column m+i is the epsilon of row i
+  const DT inf = std::numeric_limits<DT>::max();
+
+  std::vector<DT> v(nc, 0);        // column potentials, reduced cost c - u_i - v_k >= 0
+  std::vector<DT> dist(nc, inf);
+  std::vector<DT> arcCost(nc, 0);  // cost of the arc reaching the column on its shortest path
+  std::vector<DT> rowCost(n, 0);   // cost of the arc of the assignment of each row
+  std::vector<int> colRow(nc, -1), rowCol(n, -1), pred(nc, -1), touched;
+  std::vector<char> done(nc, 0);
+  typedef std::pair<DT,int> Item;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item> > heap;
+
+  for (int s=0; s<n; s++){
+    // A free column reached at the distance of the row is a shortest path, no need to pop it
+    int end = -1;
+    DT D = 0;
+
+    // Relax the arcs of row i, reached at distance d with potential ui
+    auto relax = [&](int i, DT d, DT ui){
+      for (int p=S.ptr[i]; p<=S.ptr[i+1]; p++){
+        int k;
+        DT c;
+        if (p < S.ptr[i+1]){ k = S.col[p]; c = S.cost[p] - S.ins[k]; }
+        else { k = m+i; c = S.del[i]; }
+        if (done[k]) continue;
+        DT dk = d + c - v[k] - ui;
+        if (dk < dist[k]){
+          if (dist[k] == inf) touched.push_back(k);
+          dist[k] = dk;
+          arcCost[k] = c;
+          pred[k] = i;
+          heap.push(Item(dk, k));
+          if (end < 0 && colRow[k] < 0 && dk <= d){ end = k; D = dk; }
+        }
+      }
+    };
+
+    // The potential of s makes its cheapest arc tight
+    DT us = S.del[s] - v[m+s];
+    for (int p=S.ptr[s]; p<S.ptr[s+1]; p++)
+      us = std::min(us, S.cost[p] - S.ins[S.col[p]] - v[S.col[p]]);
+    relax(s, 0, us);
+
+    while (end < 0){
+      Item top = heap.top(); heap.pop();
+      int k = top.second;
+      if (done[k] || top.first > dist[k]) continue;
+      done[k] = 1;
+      if (colRow[k] < 0){ end = k; D = top.first; }
+      else{
+        int i = colRow[k];
+        relax(i, top.first, rowCost[i] - v[k]);
+      }
+    }
+    while (!heap.empty()) heap.pop();
+    done[end] = 1;
+
+    // Keep the reduced costs non negative and the new path tight
+    for (unsigned int t=0; t<touched.size(); t++){
+      int k = touched[t];
+      if (done[k] && dist[k] < D) v[k] += dist[k] - D;
+    }
+
+    // Augment
+    int k = end;
+    while (true){
+      int i = pred[k];
+      int prev = rowCol[i];
+      rowCol[i] = k;
+      rowCost[i] = arcCost[k];
+      colRow[k] = i;
+      if (i == s) break;
+      k = prev;
+    }
+
+    for (unsigned int t=0; t<touched.size(); t++){
+      int k = touched[t];
+      dist[k] = inf;
+      done[k] = 0;
+    }
+    touched.clear();
+  }
+
+  DT cost = 0;
+  for (int j=0; j<m; j++) varrho[j] = n;
+  for (int i=0; i<n; i++){
+    rho[i] = (rowCol[i] < m) ? rowCol[i] : m;
+    cost += rowCost[i];
+    if (rowCol[i] < m) varrho[rowCol[i]] = i;
+  }
+  for (int j=0; j<m; j++) cost += S.ins[j];
+  return cost;
+}
+
+#endif // __SPARSELSAPE_H__
@@ -0,0 +1,214 @@
+/**
+ * @file SpectralMappings.h
+ * @version     0.0.1
+ *
+ * Initial mappings from spectral embeddings of the nodes : nodes whose coordinates along the
+ * leading eigenvectors of their graphs are close are mapped together.
+ */
+
+#ifndef __SPECTRALMAPPINGS_H__
+#define __SPECTRALMAPPINGS_H__
+
+#include <set>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Dense>
+#include "BipartiteGraphEditDistance.h"
+#include "MappingGenerator.h"
+#include "LSAPESolver.h"
+
+
+/**
+ * @brief Matrix whose eigenvectors embed the nodes
+ */
+enum SpectralMatrix {
+  SPECTRAL_ADJACENCY,  //!< eigenvectors of the largest eigenvalues of the adjacency matrix
+  SPECTRAL_LAPLACIAN   //!< eigenvectors of the smallest non-zero eigenvalues of the Laplacian \f$D-A\f$
+};
+
+
+/**
+ * @brief Mappings minimizing the star costs plus the distances between spectral embeddings
+ *
+ *   Each node is embedded by its coordinates in the d eigenvectors of its graph, scaled by
+ *   \f$\sqrt{n}\f$ so that graphs of different sizes are comparable. An eigenvector is only
+ *   defined up to its sign : the sign giving a positive sum of cubed coordinates is chosen, and
+ *   the eigenvectors of g2 whose sum is close to 0 in either graph are the first ones flipped to
+ *   diversify the mappings. Two eigenvectors of g2 whose eigenvalues are close are also tried in
+ *   the reverse order. Each mapping solves the LSAPE on the star costs of \ref BipartiteGraphEditDistance
+ *   (node labels included) plus <code>_weight</code> times the squared embedding distances, scaled
+ *   to the mean substitution cost. Duplicates are discarded, so fewer than k mappings may be returned.
+ *   Edge labels are ignored by the embeddings, and directed edges are symmetrized.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class SpectralMappings :
+  public BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute>,
+  public MappingGenerator<NodeAttribute, EdgeAttribute>
+{
+protected:
+
+  SpectralMatrix _matrix;
+  int _dimension;   //!< number of eigenvectors of the embeddings
+  double _weight;   //!< weight of the embedding distances w.r.t. the star costs
+
+  /**
+   * @brief Embedding of the nodes of g, n x d with d at most _dimension, and the eigenvalues
+   */
+  void embed(Graph<NodeAttribute,EdgeAttribute> * g, Eigen::MatrixXd & X, Eigen::VectorXd & lambda);
+
+public:
+
+  SpectralMappings( EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
+                    SpectralMatrix matrix = SPECTRAL_LAPLACIAN, int dimension = 4 ):
+    BipartiteGraphEditDistance<NodeAttribute,EdgeAttribute>(costFunction),
+    _matrix(matrix),
+    _dimension(dimension),
+    _weight(0.3)
+  {}
+
+  SpectralMappings( const SpectralMappings<NodeAttribute,EdgeAttribute> & other ):
+    BipartiteGraphEditDistance<NodeAttribute,EdgeAttribute>(other),
+    _matrix(other._matrix),
+    _dimension(other._dimension),
+    _weight(other._weight)
+  {}
+
+  virtual ~SpectralMappings(){}
+
+  /**
+   * @brief Weight of the embedding distances w.r.t. the star costs, 0.3 by default
+   */
+  void embeddingWeight(double weight){
+    this->_weight = weight;
+  }
+
+public:
+
+  virtual std::list<int*> getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
+                                       Graph<NodeAttribute,EdgeAttribute> * g2,
+                                       int k = -1 );
+
+  virtual SpectralMappings<NodeAttribute, EdgeAttribute> * clone() const {
+    return new SpectralMappings<NodeAttribute, EdgeAttribute>(*this);
+  }
+};
+
+
+
+template<class NodeAttribute, class EdgeAttribute>
+void SpectralMappings<NodeAttribute, EdgeAttribute>::
+embed(Graph<NodeAttribute,EdgeAttribute> * g, Eigen::MatrixXd & X, Eigen::VectorXd & lambda)
+{
+  const int n = g->Size();
+  Eigen::MatrixXd A = Eigen::MatrixXd::Zero(n, n);
+  for (int i=0; i<n; i++)
+    for (GEdge<EdgeAttribute> * p = (*g)[i]->getIncidentEdges(); p; p = p->Next())
+      if (p->IncidentNode() != i)
+        A(i, p->IncidentNode()) = A(p->IncidentNode(), i) = 1;
+  if (_matrix == SPECTRAL_LAPLACIAN){
+    Eigen::VectorXd degree = A.rowwise().sum();
+    A = -A;
+    A.diagonal() += degree;
+  }
+
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(A); // increasing eigenvalues
+  // adjacency : the last ones, Laplacian : the first ones after the constant vector
+  int first = (_matrix == SPECTRAL_LAPLACIAN) ? 1 : 0;
+  int d = std::max(0, std::min(_dimension, n - first));
+  X.resize(n, d);
+  lambda.resize(d);
+  for (int c=0; c<d; c++){
+    int e = (_matrix == SPECTRAL_LAPLACIAN) ? first + c : n-1-c;
+    X.col(c) = es.eigenvectors().col(e) * std::sqrt((double)n);
+    lambda(c) = es.eigenvalues()(e);
+    if (X.col(c).array().cube().sum() < 0) X.col(c) = -X.col(c);
+  }
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+std::list<int*> SpectralMappings<NodeAttribute, EdgeAttribute>::
+getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
+             Graph<NodeAttribute,EdgeAttribute> * g2,
+             int k )
+{
+  if (k < 0) k = 100;
+
+  const int n = g1->Size();
+  const int m = g2->Size();
+  this->computeCostMatrix(g1, g2);
+
+  Eigen::MatrixXd X1, X2;
+  Eigen::VectorXd l1, l2;
+  embed(g1, X1, l1);
+  embed(g2, X2, l2);
+  const int d = std::min(X1.cols(), X2.cols());
+
+  // Ambiguity of the sign of each eigenvector, and of the order of close eigenvalues
+  std::vector<double> conf(d);
+  for (int c=0; c<d; c++)
+    conf[c] = std::min(std::fabs(X1.col(c).array().cube().sum())/std::max(n,1),
+                       std::fabs(X2.col(c).array().cube().sum())/std::max(m,1));
+  double spread = 1e-12;
+  for (int c=0; c<d; c++) spread = std::max(spread, std::fabs(l2(c)));
+  std::vector<std::pair<double, std::pair<int,int> > > variants; // (ambiguity, (flipped, swapped))
+  // Without any eigenvector (d = 0), the only variant is the LSAPE on the star costs
+  for (int swap=-1; swap<std::max(d-1,0); swap++){
+    double gap = (swap < 0) ? 0 : std::fabs(l2(swap) - l2(swap+1))/spread;
+    if (gap > 0.05) continue;
+    for (int mask=0; mask<(1<<d); mask++){
+      double s = gap/0.05;
+      for (int c=0; c<d; c++) if (mask & (1<<c)) s += conf[c];
+      variants.push_back(std::make_pair(s, std::make_pair(mask, swap)));
+    }
+  }
+  std::stable_sort(variants.begin(), variants.end(),
+                   [](const std::pair<double, std::pair<int,int> > & a,
+                      const std::pair<double, std::pair<int,int> > & b){ return a.first < b.first; });
+
+  // The embedding distances are scaled to the star costs. The embeddings of graphs of different
+  // sizes may have different dimensions : only their first d coordinates are compared
+  double meanCost = 0, meanDist = 0;
+  for (int j=0; j<m; j++)
+    for (int i=0; i<n; i++){
+      meanCost += this->C[sub2ind(i,j,n+1)];
+      meanDist += (X1.leftCols(d).row(i) - X2.leftCols(d).row(j)).squaredNorm();
+    }
+  double alpha = (meanDist > 0) ? _weight * meanCost / meanDist : 0;
+
+  std::list<int*> mappings;
+  std::set< std::vector<int> > seen;
+  double* Cs = new double[(n+1)*(m+1)];
+  int* rho = new int[n+1];
+  int* varrho = new int[m+1];
+  double* u = new double[n+1];
+  double* v = new double[m+1];
+  Eigen::MatrixXd Y(m, d);
+  for (unsigned int t=0; t<variants.size() && (int)mappings.size() < k; t++){
+    int mask = variants[t].second.first, swap = variants[t].second.second;
+    for (int c=0; c<d; c++){
+      int e = (c == swap) ? c+1 : ((swap >= 0 && c == swap+1) ? c-1 : c);
+      Y.col(c) = X2.col(e);
+      if (mask & (1<<c)) Y.col(c) = -Y.col(c);
+    }
+    std::copy(this->C, this->C + (n+1)*(m+1), Cs);
+    for (int j=0; j<m; j++)
+      for (int i=0; i<n; i++)
+        Cs[sub2ind(i,j,n+1)] += alpha * (X1.leftCols(d).row(i) - Y.row(j)).squaredNorm();
+    solveLSAPE(this->_lsapeSolver, Cs, n+1, m+1, rho, varrho, u, v);
+
+    if (seen.insert(std::vector<int>(rho, rho+n)).second)
+      mappings.push_back(lsapeToPermutation(rho, varrho, n, m));
+  }
+
+  delete [] v;
+  delete [] u;
+  delete [] varrho;
+  delete [] rho;
+  delete [] Cs;
+  delete [] this->C; this->C = NULL;
+  return mappings;
+}
+
+#endif
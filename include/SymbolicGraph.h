@@ -47,6 +47,11 @@ public:
    */
   SymbolicGraph(int * am, int nb_nodes, bool directed);
 
+  /* Constructor of an empty Symbolic graph, filled by Add and Link
+   * @param directed TRUE if the graph is directed, FALSE otherwise
+   */
+  explicit SymbolicGraph(bool directed):Graph<int,int>(directed){};
+
 
   /* Return a n*n int array encoding the adjacency matrix corresponding to current graph.
    * @return a pointer to adjacency matrix
@@ -0,0 +1,180 @@
+/**
+ * @file UniqueMappings.h
+ * @version     0.0.1
+ *
+ * Removal of the mappings of a generator which are equivalent under the automorphisms of the graphs.
+ */
+
+#ifndef __UNIQUEMAPPINGS_H__
+#define __UNIQUEMAPPINGS_H__
+
+#include <list>
+#include <deque>
+#include <vector>
+#include <unordered_set>
+#include "GraphSymmetries.h"
+#include "MappingGenerator.h"
+
+
+/**
+ * @brief Hash of a vector of integers
+ */
+struct IntVectorHash {
+  size_t operator()(const std::vector<int> & x) const {
+    size_t h = 1469598103934665603ULL;
+    for (unsigned int i=0; i<x.size(); i++) h = (h ^ (size_t)x[i]) * 1099511628211ULL;
+    return h;
+  }
+};
+
+
+/**
+ * @brief Keep one mapping of another generator per class of mappings equivalent under the
+ *        automorphisms of the graphs
+ *
+ *   Two mappings f and \f$\sigma_2\circ f\circ\sigma_1\f$, with \f$\sigma_1\f$ and \f$\sigma_2\f$
+ *   automorphisms of g1 and g2, have the same cost and lead a refinement to the same cost, so only
+ *   the first one is kept. The automorphisms are the ones of \ref GraphSymmetries. Up to permutations of
+ *   twins, a mapping is identified by the number of nodes of each twin class of g1 mapped to each
+ *   twin class of g2, which is hashed. The images of a kept mapping by the other automorphisms are
+ *   enumerated, up to <code>_maxImages</code>, and their keys recorded, so each later mapping is
+ *   only looked up. Identical mappings always have the same key.
+ *
+ *   The mappings are the \f$(n+m)\f$ permutations of the GED generators, only their first n entries
+ *   are compared.
+ */
+template<class NodeAttribute, class EdgeAttribute>
+class UniqueMappings :
+  public MappingGenerator<NodeAttribute, EdgeAttribute>
+{
+protected:
+
+  EditDistanceCost<NodeAttribute,EdgeAttribute> * cf;
+  MappingGenerator<NodeAttribute, EdgeAttribute> * _gen; //!< Generator of the mappings to filter
+  bool _cleanGen;       //!< Delete the generator in the destructor if true
+  int _oversampling;    //!< Number of mappings asked to the generator for each one returned
+  int _maxImages;       //!< Largest number of images enumerated for each kept mapping
+  int _nbDiscarded;     //!< Number of mappings discarded by the last call
+
+  /**
+   * @brief Number of nodes of each twin class of g1 mapped to each twin class of g2, as a sorted vector
+   */
+  std::vector<int> key(const std::vector<int> & f, int m,
+                       const GraphSymmetries<NodeAttribute,EdgeAttribute> & s1,
+                       const GraphSymmetries<NodeAttribute,EdgeAttribute> & s2) const;
+
+public:
+
+  UniqueMappings( EditDistanceCost<NodeAttribute,EdgeAttribute> * costFunction,
+                  MappingGenerator<NodeAttribute, EdgeAttribute> * gen,
+                  int oversampling = 1 ):
+    cf(costFunction),
+    _gen(gen),
+    _cleanGen(false),
+    _oversampling(oversampling),
+    _maxImages(64),
+    _nbDiscarded(0)
+  {}
+
+  UniqueMappings( const UniqueMappings<NodeAttribute,EdgeAttribute> & other ):
+    cf(other.cf),
+    _gen(other._gen->clone()),
+    _cleanGen(true),
+    _oversampling(other._oversampling),
+    _maxImages(other._maxImages),
+    _nbDiscarded(0)
+  {}
+
+  virtual ~UniqueMappings(){
+    if (_cleanGen) delete _gen;
+  }
+
+  /**
+   * @brief Number of mappings discarded by the last call to getMappings
+   */
+  int getNbDiscarded() const { return _nbDiscarded; }
+
+  /**
+   * @brief At most k mappings, all pairwise non equivalent, out of oversampling*k generated ones
+   */
+  virtual std::list<int*> getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
+                                       Graph<NodeAttribute,EdgeAttribute> * g2,
+                                       int k = -1 );
+
+  virtual UniqueMappings<NodeAttribute, EdgeAttribute> * clone() const {
+    return new UniqueMappings<NodeAttribute, EdgeAttribute>(*this);
+  }
+};
+
+
+
+template<class NodeAttribute, class EdgeAttribute>
+std::vector<int> UniqueMappings<NodeAttribute, EdgeAttribute>::
+key(const std::vector<int> & f, int m,
+    const GraphSymmetries<NodeAttribute,EdgeAttribute> & s1,
+    const GraphSymmetries<NodeAttribute,EdgeAttribute> & s2) const
+{
+  std::vector<int> pairs;
+  for (unsigned int i=0; i<f.size(); i++)
+    if (f[i] < m)
+      pairs.push_back(s1.twinClasses()[i] * s2.nbTwinClasses() + s2.twinClasses()[f[i]]);
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+
+
+template<class NodeAttribute, class EdgeAttribute>
+std::list<int*> UniqueMappings<NodeAttribute, EdgeAttribute>::
+getMappings( Graph<NodeAttribute,EdgeAttribute> * g1,
+             Graph<NodeAttribute,EdgeAttribute> * g2,
+             int k )
+{
+  const int n = g1->Size();
+  const int m = g2->Size();
+  std::list<int*> seeds = _gen->getMappings(g1, g2, (k < 0) ? k : k*_oversampling);
+
+  GraphSymmetries<NodeAttribute,EdgeAttribute> s1(g1, cf), s2(g2, cf);
+  const bool symmetric = s1.symmetric() || s2.symmetric();
+
+  std::list<int*> mappings;
+  std::unordered_set<std::vector<int>, IntVectorHash> seen;
+  std::deque<std::vector<int> > queue;
+  std::vector<int> f(n), img(n);
+  _nbDiscarded = 0;
+  for (std::list<int*>::iterator it=seeds.begin(); it!=seeds.end(); it++){
+    if (k >= 0 && (int)mappings.size() >= k){ delete [] *it; continue; }
+    for (int i=0; i<n; i++) f[i] = ((*it)[i] < m) ? (*it)[i] : m;
+    if (!seen.insert(symmetric ? key(f, m, s1, s2) : f).second){
+      delete [] *it;
+      _nbDiscarded++;
+      continue;
+    }
+    mappings.push_back(*it);
+    if (!symmetric) continue;
+
+    // record the keys of the images by the automorphisms
+    queue.assign(1, f);
+    int nbImages = 1;
+    while (!queue.empty() && nbImages < _maxImages){
+      std::vector<int> g = queue.front(); queue.pop_front();
+      const unsigned int nbGen = s1.generators().size() + s2.generators().size();
+      for (unsigned int t=0; t<nbGen && nbImages < _maxImages; t++){
+        if (t < s1.generators().size()){
+          const std::vector<int> & sigma = s1.generators()[t];
+          for (int i=0; i<n; i++) img[sigma[i]] = g[i];
+        }
+        else{
+          const std::vector<int> & sigma = s2.generators()[t - s1.generators().size()];
+          for (int i=0; i<n; i++) img[i] = (g[i] < m) ? sigma[g[i]] : m;
+        }
+        if (seen.insert(key(img, m, s1, s2)).second){
+          queue.push_back(img);
+          nbImages++;
+        }
+      }
+    }
+  }
+  return mappings;
+}
+
+#endif
@@ -6,12 +6,13 @@
 #include <map>
 #include <fstream>
 #include <cstdlib>
-#include <algorithm>    // for std::random_shuffle
+#include <algorithm>
 #include <iostream>
 
 #include <tinyxml.h>
 
 #include "utils.h"
+#include "RandomStream.h"
 
 /** @brief An oriented edge of a graph.
  *
@@ -419,14 +420,14 @@ public :
    return NULL;
   };
   /* Compute a random permutation of the list of nodes contained in the graph. Modify the underlying structure according to this permutatation
-   *
+   * The permutation is drawn from the given stream of the seed, see RandomStream
    */
-  void shuffleize(){
+  void shuffleize(uint64_t seed = 123, uint64_t stream = 0){
     // set some values:
     std::vector<int> perm;
     for (int i=0; i<nbNodes; ++i) perm.push_back(i);
-    // using built-in random generator:
-    std::random_shuffle ( perm.begin(), perm.end() ); //seed ?
+    RandomStream rs(seed, stream);
+    rs.shuffle(perm.data(), nbNodes);
     std::vector<GNode<NodeAttribute,EdgeAttribute>*> new_tnode;
     std::vector<int> inv_tnode(Size());
     //Modification of list nodes
@@ -38,3 +38,32 @@ double  ConstantEditDistanceCost::EdgeDeletionCost(GEdge<int> * e1,
   
 double  ConstantEditDistanceCost::EdgeInsertionCost(GEdge<int> * e2,
 						    Graph<int,int> * g2){return _cei;};
+
+
+EditOperationCounts countEditOperations(Graph<int,int> * g1, Graph<int,int> * g2,
+                                        int * G1toG2, int n, int * G2toG1, int m){
+  EditOperationCounts c;
+  for (int i=0; i<n; i++)
+    if (G1toG2[i] >= m) c.nd++;
+    else if ((*g1)[i]->attr != (*g2)[G1toG2[i]]->attr) c.ns++;
+  for (int j=0; j<m; j++)
+    if (G2toG1[j] >= n) c.ni++;
+
+  // Undirected edges are seen in both directions, and counted once
+  for (int i=0; i<n; i++)
+    for (GEdge<int> * p = (*g1)[i]->getIncidentEdges(); p; p = p->Next()){
+      int f_start = G1toG2[i], f_end = G1toG2[p->IncidentNode()];
+      GEdge<int> * q = (f_start < m && f_end < m) ? g2->getEdge(f_start, f_end) : NULL;
+      if (q == NULL) c.ed++;
+      else if (p->attr != q->attr) c.es++;
+    }
+  for (int j=0; j<m; j++)
+    for (GEdge<int> * p = (*g2)[j]->getIncidentEdges(); p; p = p->Next()){
+      int f_start = G2toG1[j], f_end = G2toG1[p->IncidentNode()];
+      if (f_start >= n || f_end >= n || g1->getEdge(f_start, f_end) == NULL) c.ei++;
+    }
+  if (!g1->isDirected()){
+    c.es /= 2; c.ed /= 2; c.ei /= 2;
+  }
+  return c;
+}
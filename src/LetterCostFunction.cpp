@@ -1,4 +1,6 @@
 
+#include <cmath>
+#include <limits>
 #include "LetterCostFunction.h"
 
 
@@ -42,3 +44,16 @@ double LetterDistanceCost::EdgeInsertionCost(GEdge<double> * e2,Graph<CMUPoint,d
   return (1-_alpha) * _tedges;
 }
 
+
+void LetterDistanceCost::nodePoint(GNode<CMUPoint,double> * v, double & x, double & y) const
+{
+  x = v->attr.x;
+  y = v->attr.y;
+}
+
+
+double LetterDistanceCost::substitutionRadius(double cost) const
+{
+  if (_alpha <= 0) return std::numeric_limits<double>::infinity();
+  return sqrt(std::max(cost, 0.0) / _alpha);
+}
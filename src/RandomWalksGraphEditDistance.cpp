@@ -137,7 +137,7 @@ void RandomWalksGraphEditDistance::computeCostMatrix(Graph<int,int> * g1,
   for(int i = 0;i<ILx.size();i++)
     ILxt(i) = (ILx(i) > 0);
 
-  this->C = new double[(n+1)*(m+1)];
+  this->allocateCostMatrix(n, m);
   assert(this->C != 0);
   
   Map<MatrixXd> matrixC(this->C,n+1,m+1);
@@ -12,6 +12,7 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <fstream>
 
 
 #include "graph.h"
@@ -30,6 +31,14 @@
 #include "RandomMappings.h"
 #include "MultistartRefinementGraphEditDistance.h"
 #include "GNCCPGraphEditDistance.h"
+#include "SinkhornGraphEditDistance.h"
+#include "GreedyMappings.h"
+#include "SpectralMappings.h"
+#include "UniqueMappings.h"
+#include "MultilevelGraphEditDistance.h"
+#include "GraphIsomorphism.h"
+#include "ResultCache.h"
+#include "GEDServer.h"
 #include "utils.h"
 using namespace std;
 
@@ -38,6 +47,7 @@ using namespace std;
 void usage (char * s)
 {
   cerr << "Usage : "<< s << " dataset " << " options"<<endl;
+  cerr << "        "<< s << " dataset [dataset ...] -S socket_path options"<<endl;
   cerr << "options:" << endl;
   cerr << "\t -m method " << endl;
   cerr << "\t \t Specify the algorithm used to compute edit distance" << endl;
@@ -47,6 +57,38 @@ void usage (char * s)
   cerr << "\t \t Specify edit operation costs" << endl;
   cerr << "\t -p n_edit_paths " << endl;
   cerr << "\t \t Specify the number of edit paths to compute GED (lsape_multi)" << endl;
+  cerr << "\t -l hungarian|jv|auction|greedy_row|greedy_sort|greedy_refined " << endl;
+  cerr << "\t \t Specify the LSAPE solver (bipartite, IPFP, GNCCP and sinkhorn methods)" << endl;
+  cerr << "\t -u " << endl;
+  cerr << "\t \t Multistart methods refine a single seed of each class of seeds equivalent under" << endl;
+  cerr << "\t \t the automorphisms of the graphs (out of twice as many generated seeds)" << endl;
+  cerr << "\t -i " << endl;
+  cerr << "\t \t Isomorphic graphs are at distance 0 : only the distances of one graph per isomorphism" << endl;
+  cerr << "\t \t class are computed, and copied to the other graphs of the class" << endl;
+  cerr << "\t -w grid_file " << endl;
+  cerr << "\t \t Sweep the costs : each line of grid_file is a vector cns cni cnd ces cei ced. The mapping" << endl;
+  cerr << "\t \t of each pair is computed once under the costs of -c, and a matrix is output for each vector" << endl;
+  cerr << "\t -W " << endl;
+  cerr << "\t \t With -w, compute the mappings again under each cost vector" << endl;
+  cerr << "\t -f cache_file " << endl;
+  cerr << "\t \t Look up the distances and mappings in cache_file before computing them, and store the" << endl;
+  cerr << "\t \t new ones. Results are keyed by the graphs, the method, its options and the costs." << endl;
+  cerr << "\t \t Not available with -t" << endl;
+  cerr << "\t -d " << endl;
+  cerr << "\t \t Keep the parsed graphs in the sidecar file dataset.cache, loaded by the next runs while" << endl;
+  cerr << "\t \t the dataset and graph files are unchanged" << endl;
+  cerr << "\t -S socket_path " << endl;
+  cerr << "\t \t Serve the distance, k-NN and range requests on the graphs of the datasets over the Unix" << endl;
+  cerr << "\t \t socket socket_path, until a shutdown request (see GEDServer.h)" << endl;
+  cerr << "\t -t max_lag " << endl;
+  cerr << "\t \t The graphs are the frames of a sequence : IPFP methods refine each pair from the" << endl;
+  cerr << "\t \t mappings of closer frames, up to max_lag apart" << endl;
+  cerr << "\t -T " << endl;
+  cerr << "\t \t With -t, also refine each pair from the usual initialization and report the iterations saved" << endl;
+  cerr << "\t -r top,c|compatible,t|useful " << endl;
+  cerr << "\t \t Restrict the substitutions to the c cheapest ones of each node, to the ones of node" << endl;
+  cerr << "\t \t cost at most t, or to the ones cheaper than a deletion and an insertion, and solve" << endl;
+  cerr << "\t \t a sparse LSAPE (bipartite and IPFP methods)" << endl;
 }
 
 struct Options{
@@ -63,6 +105,19 @@ struct Options{
   bool cmu = false;
   int k = 3;
   int nep = 100; // number of edit paths for allsolution
+  LSAPESolver solver = LSAPE_HUNGARIAN;
+  LSAPECandidates candidates = CANDIDATES_ALL;
+  double candidatesParam = 0;
+  int sequenceLag = 0; // sequence mode if > 0
+  bool coldCompare = false; // with sequenceLag, refine again from the usual initialization
+  bool uniqueSeeds = false;
+  bool isomorphisms = false;
+  string grid_file = ""; // cost sweep if not empty
+  bool remapSweep = false;
+  string cache_file = "";
+  bool datasetCache = false;
+  string socket_path = ""; // server mode if not empty
+  std::vector<string> more_datasets; // served with dataset_file
 };
 
 struct Options * parseOptions(int argc, char** argv){
@@ -70,7 +125,7 @@ struct Options * parseOptions(int argc, char** argv){
   options->dataset_file = string(argv[1]);
   int opt;
   stringstream sstream;
-  while ((opt = getopt(argc, argv, "m:o:c:sp:z")) != -1) {
+  while ((opt = getopt(argc, argv, "m:o:c:sp:zl:r:t:Tuiw:Wf:dS:")) != -1) {
     switch (opt) {
     case 'm':
       options->method = string(optarg);
@@ -97,19 +152,187 @@ struct Options * parseOptions(int argc, char** argv){
     case 'z':
       options->cmu = true;
       break;
+    case 'l':
+      if (string(optarg) == "jv") options->solver = LSAPE_JV;
+      else if (string(optarg) == "auction") options->solver = LSAPE_AUCTION;
+      else if (string(optarg) == "greedy_row") options->solver = LSAPE_GREEDY_ROW;
+      else if (string(optarg) == "greedy_sort") options->solver = LSAPE_GREEDY_SORT;
+      else if (string(optarg) == "greedy_refined") options->solver = LSAPE_GREEDY_REFINED;
+      else options->solver = LSAPE_HUNGARIAN;
+      break;
+    case 'u':
+      options->uniqueSeeds = true;
+      break;
+    case 'w':
+      options->grid_file = string(optarg);
+      break;
+    case 'W':
+      options->remapSweep = true;
+      break;
+    case 'S':
+      options->socket_path = string(optarg);
+      break;
+    case 'd':
+      options->datasetCache = true;
+      break;
+    case 'f':
+      options->cache_file = string(optarg);
+      break;
+    case 'i':
+      options->isomorphisms = true;
+      break;
+    case 't':
+      options->sequenceLag = atoi(optarg);
+      break;
+    case 'T':
+      options->coldCompare = true;
+      break;
+    case 'r':{
+      string mode(optarg);
+      size_t comma = mode.find(',');
+      if (comma != string::npos){
+        options->candidatesParam = atof(mode.substr(comma+1).c_str());
+        mode = mode.substr(0, comma);
+      }
+      if (mode == "top") options->candidates = CANDIDATES_TOP;
+      else if (mode == "compatible") options->candidates = CANDIDATES_COMPATIBLE;
+      else if (mode == "useful") options->candidates = CANDIDATES_USEFUL;
+      else options->candidates = CANDIDATES_ALL;
+      break;
+    }
     default: /* '?' */
       cerr << "Options parsing failed."  << endl;
       usage(argv[0]);
       exit(EXIT_FAILURE);
     }
   }
+  // the other arguments, permuted after the options by getopt, are more datasets
+  for (int k=optind; k<argc; k++)
+    if (string(argv[k]) != options->dataset_file)
+      options->more_datasets.push_back(string(argv[k]));
   return options;
 }
 
+/**
+ * Select the LSAPE solver of the methods which have one
+ */
+template <class NodeAttribute, class EdgeAttribute>
+void setLSAPESolver(GraphEditDistance<NodeAttribute, EdgeAttribute> * ed, LSAPESolver solver){
+  if (BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute> * bp =
+      dynamic_cast<BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute> *>(ed))
+    bp->lsapeSolver(solver);
+  if (IPFPGraphEditDistance<NodeAttribute, EdgeAttribute> * ipfp =
+      dynamic_cast<IPFPGraphEditDistance<NodeAttribute, EdgeAttribute> *>(ed))
+    ipfp->lsapeSolver(solver);
+  if (GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute> * gnccp =
+      dynamic_cast<GNCCPGraphEditDistance<NodeAttribute, EdgeAttribute> *>(ed))
+    gnccp->lsapeSolver(solver);
+}
+
+/**
+ * Restrict the substitutions of the methods which solve an LSAPE
+ */
+template <class NodeAttribute, class EdgeAttribute>
+void setCandidates(GraphEditDistance<NodeAttribute, EdgeAttribute> * ed, LSAPECandidates mode, double param){
+  if (BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute> * bp =
+      dynamic_cast<BipartiteGraphEditDistance<NodeAttribute, EdgeAttribute> *>(ed))
+    bp->candidates(mode, param);
+  if (IPFPGraphEditDistance<NodeAttribute, EdgeAttribute> * ipfp =
+      dynamic_cast<IPFPGraphEditDistance<NodeAttribute, EdgeAttribute> *>(ed))
+    ipfp->candidates(mode, param);
+}
+
+/**
+ * Everything the distances depend on, to key the results of option -f. method is the name given
+ * on the command line, before the aliases are rewritten
+ */
+string methodDescription(struct Options * options, const string & method){
+  stringstream ss;
+  ss << method << " costs " << options->cns << " " << options->cni << " " << options->cnd << " "
+     << options->ces << " " << options->cei << " " << options->ced << " solver " << options->solver
+     << " candidates " << options->candidates << " " << options->candidatesParam
+     << " nep " << options->nep << " unique " << options->uniqueSeeds << " cmu " << options->cmu;
+  return ss.str();
+}
+
+/**
+ * Filter the seeds of a multistart method, see option -u
+ */
+MappingGenerator<int,int> * seedGenerator(EditDistanceCost<int,int> * cf, MappingGenerator<int,int> * gen,
+                                          bool unique){
+  return unique ? new UniqueMappings<int,int>(cf, gen, 2) : gen;
+}
+
+/**
+ * Read the cost vectors of a sweep, one per line, skipping empty lines and comments
+ */
+std::vector<std::vector<double> > readCostGrid(const string & filename){
+  std::vector<std::vector<double> > grid;
+  ifstream in(filename.c_str());
+  string line;
+  while (getline(in, line)){
+    if (line.empty() || line[0] == '#') continue;
+    for (unsigned int k=0; k<line.size(); k++) if (line[k] == ',') line[k] = ' ';
+    stringstream ss(line);
+    std::vector<double> c(6);
+    for (int k=0; k<6; k++) ss >> c[k];
+    if (ss.fail()){
+      cerr << "Invalid cost vector : " << line << endl;
+      continue;
+    }
+    grid.push_back(c);
+  }
+  return grid;
+}
+
+/**
+ * Output the distance matrix of each cost vector of the grid, see option -w.
+ * Unless remap, the mapping of each pair is computed once under the current costs of cf, and its
+ * edit operations are weighted by each cost vector. Otherwise, cf is set to each cost vector in turn
+ * and the mappings are computed again.
+ */
+template <class PropertyType>
+void sweepCosts(Dataset<int, int, PropertyType> * dataset, GraphEditDistance<int, int> * ed,
+                ConstantEditDistanceCost * cf, const std::vector<std::vector<double> > & grid,
+                bool shuffle, bool remap){
+  if(shuffle)
+    dataset->shuffleize();
+  int N = dataset->size();
+  const unsigned int nbPasses = remap ? grid.size() : 1;
+  const ConstantEditDistanceCost reference(*cf);
+  std::vector<EditOperationCounts> counts(N*N);
+  for (unsigned int k=0; k<grid.size(); k++){
+    if (k < nbPasses){
+      if (remap)
+        *cf = ConstantEditDistanceCost(grid[k][0], grid[k][1], grid[k][2], grid[k][3], grid[k][4], grid[k][5]);
+      for (int i=0; i<N; i++)
+        for (int j=0; j<N; j++){
+          Graph<int,int> * g1 = (*dataset)[i];
+          Graph<int,int> * g2 = (*dataset)[j];
+          int n = g1->Size(), m = g2->Size();
+          int * G1_to_G2 = new int[n];
+          int * G2_to_G1 = new int[m];
+          ed->getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+          counts[sub2ind(i,j,N)] = countEditOperations(g1, g2, G1_to_G2, n, G2_to_G1, m);
+          delete [] G1_to_G2;
+          delete [] G2_to_G1;
+        }
+    }
+    cout << "# costs";
+    for (int c=0; c<6; c++) cout << " " << grid[k][c];
+    cout << endl;
+    for (int i=0; i<N; i++)
+      for (int j=0; j<N; j++)
+        cout << counts[sub2ind(i,j,N)].cost(&grid[k][0]) << endl;
+  }
+  *cf = reference;
+}
+
 template <class NodeAttribute, class EdgeAttribute, class PropertyType>
 double * computeGraphEditDistance(Dataset< NodeAttribute, EdgeAttribute, PropertyType> * dataset,
 				  GraphEditDistance<NodeAttribute, EdgeAttribute> * ed,
-				  bool shuffle, int nep=0){
+				  bool shuffle, int nep=0, int sequenceLag=0, bool isomorphisms=false,
+				  bool coldCompare=false){
   if(shuffle)
     dataset->shuffleize();
 
@@ -117,13 +340,98 @@ double * computeGraphEditDistance(Dataset< NodeAttribute, EdgeAttribute, Propert
   int N = dataset->size();
   double* distances = new double[N*N];
   struct timeval  tv1, tv2;
+
+  // Representative of the isomorphism class of each graph, rep[i] <= i
+  std::vector<int> rep(N);
+  for (int i=0; i<N; i++) rep[i] = i;
+  if (isomorphisms && sequenceLag == 0){
+    std::vector<Graph<NodeAttribute, EdgeAttribute> *> graphs;
+    for (int j=0; j<N; j++)
+      graphs.push_back((*dataset)[j]);
+    rep = GraphIsomorphism<NodeAttribute, EdgeAttribute>(ed->getCostFunction()).representatives(graphs);
+  }
+  std::vector<int> reps; // the representatives
+  for (int i=0; i<N; i++)
+    if (rep[i] == i) reps.push_back(i);
+  std::vector<int> column(N); // index of the representative of each graph in reps
+  for (unsigned int t=0; t<reps.size(); t++) column[reps[t]] = t;
+  for (int i=0; i<N; i++) column[i] = column[rep[i]];
+
+#ifndef PRINT_TIMES
+  // IPFP based methods compute each row in batch, with -f only the pairs missing from the cache
+  CachedGraphEditDistance<NodeAttribute, EdgeAttribute> * cached =
+    dynamic_cast<CachedGraphEditDistance<NodeAttribute, EdgeAttribute> *>(ed);
+  IPFPGraphEditDistance<NodeAttribute, EdgeAttribute> * ipfp =
+    dynamic_cast<IPFPGraphEditDistance<NodeAttribute, EdgeAttribute> *>(cached ? cached->method() : ed);
+  if (ipfp && sequenceLag > 0){
+    std::vector<Graph<NodeAttribute, EdgeAttribute> *> frames;
+    for (int j=0; j<N; j++)
+      frames.push_back((*dataset)[j]);
+    IPFPWarmStartReport report;
+    // the cold refinements double the cost of the run, they are only made to measure the warm starts
+    ipfp->sequenceDistances(frames, distances, sequenceLag, coldCompare ? &report : NULL);
+    for (int i=0; i<N; i++)
+      for (int j=0; j<N; j++)
+        cout << (int)distances[sub2ind(i,j,N)] << endl;
+    if (coldCompare)
+      cerr << report << endl;
+    return distances;
+  }
+  if (ipfp){
+    std::vector<Graph<NodeAttribute, EdgeAttribute> *> graphs;
+    for (unsigned int t=0; t<reps.size(); t++)
+      graphs.push_back((*dataset)[reps[t]]);
+    double * row = new double[N];
+    std::vector<IPFPTelemetry> telemetry(reps.size());
+    for (int i=0; i<N; i++){
+      if (rep[i] == i){
+        std::vector<Graph<NodeAttribute, EdgeAttribute> *> missing;
+        std::vector<int> missingColumn;
+        for (unsigned int t=0; t<reps.size(); t++)
+          if (!cached || !cached->lookup((*dataset)[i], graphs[t], row[t])){
+            missing.push_back(graphs[t]);
+            missingColumn.push_back(t);
+          }
+        double * missingRow = new double[missing.size()];
+        std::vector<IPFPTelemetry> missingTelemetry;
+        ipfp->rowDistances((*dataset)[i], missing, missingRow, &missingTelemetry);
+        for (unsigned int k=0; k<missing.size(); k++){
+          row[missingColumn[k]] = missingRow[k];
+          telemetry[missingColumn[k]] = missingTelemetry[k];
+          if (cached) cached->store((*dataset)[i], missing[k], missingRow[k]);
+        }
+        delete [] missingRow;
+      }
+      for (int j=0; j<N; j++){
+        if (isomorphisms && rep[i] == rep[j])
+          distances[sub2ind(i,j,N)] = 0;
+        else if (rep[i] == i)
+          distances[sub2ind(i,j,N)] = row[column[j]];
+        else
+          distances[sub2ind(i,j,N)] = distances[sub2ind(rep[i],j,N)];
+        cout << (int)distances[sub2ind(i,j,N)];
+        cout << endl;
+        #ifdef PRINT_TELEMETRY
+          if (rep[i] == i && rep[j] == j) cerr << i << "," << j << " : " << telemetry[column[j]] << endl;
+        #endif
+      }
+    }
+    delete [] row;
+    return distances;
+  }
+#endif
   for (int i=0; i<N; i++){
     for (int j=0; j<N; j++){
       #ifdef PRINT_TIMES
         gettimeofday(&tv1, NULL);
       #endif
       
-      distances[sub2ind(i,j,N)] = (*ed)((*dataset)[i], (*dataset)[j]);;
+      if (isomorphisms && rep[i] == rep[j])
+        distances[sub2ind(i,j,N)] = 0;
+      else if (rep[i] != i || rep[j] != j) // already computed, as rep[i] <= i
+        distances[sub2ind(i,j,N)] = distances[sub2ind(rep[i],rep[j],N)];
+      else
+        distances[sub2ind(i,j,N)] = (*ed)((*dataset)[i], (*dataset)[j]);;
       
       #ifdef PRINT_TIMES
         gettimeofday(&tv2, NULL);
@@ -143,6 +451,12 @@ int main (int argc, char** argv)
 {
 
   struct Options * options =   parseOptions(argc,argv);
+  const string method = options->method; // before the aliases below are rewritten
+
+  if (!options->cache_file.empty() && options->sequenceLag > 0){
+    cerr << "Option -f can not be used with -t : the warm started distances depend on the sequence" << endl;
+    return EXIT_FAILURE;
+  }
 
 
   options->k = 3;
@@ -152,6 +466,8 @@ int main (int argc, char** argv)
   
   // IPFP used as a refinement method
   IPFPGraphEditDistance<int,int> * algoIPFP = new IPFPGraphEditDistance<int,int>(cf);
+  algoIPFP->lsapeSolver(options->solver);
+  algoIPFP->candidates(options->candidates, options->candidatesParam);
   //algoIPFP->recenterInit();
   
   // Sinkhorn balanced random init
@@ -160,6 +476,16 @@ int main (int argc, char** argv)
     options->method = string("ipfpe_multi_random");
   }
 
+  // Greedy approximations of lsape_bunke
+  if (options->method == string("lsape_greedy_row") ||
+      options->method == string("lsape_greedy_sort") ||
+      options->method == string("lsape_greedy_refined")){
+    if (options->method == string("lsape_greedy_row")) options->solver = LSAPE_GREEDY_ROW;
+    else if (options->method == string("lsape_greedy_sort")) options->solver = LSAPE_GREEDY_SORT;
+    else options->solver = LSAPE_GREEDY_REFINED;
+    options->method = string("lsape_bunke");
+  }
+
   GraphEditDistance<int,int>* ed;
   if(options->method == string("lsape_bunke"))
     ed = new BipartiteGraphEditDistance<int,int>(cf);
@@ -181,43 +507,111 @@ int main (int argc, char** argv)
   
   else if(options->method == string("ipfpe_bunke")){
     BipartiteGraphEditDistance<int,int> *ed_init = new BipartiteGraphEditDistance<int,int>(cf);
+    ed_init->lsapeSolver(options->solver);
+    ed_init->candidates(options->candidates, options->candidatesParam);
     ed =new IPFPGraphEditDistance<int,int>(cf,ed_init);
+  } else if(options->method == string("ipfpe_away") || options->method == string("ipfpe_pairwise")){
+    BipartiteGraphEditDistance<int,int> *ed_init = new BipartiteGraphEditDistance<int,int>(cf);
+    ed_init->lsapeSolver(options->solver);
+    ed_init->candidates(options->candidates, options->candidatesParam);
+    IPFPGraphEditDistance<int,int> * ipfp = new IPFPGraphEditDistance<int,int>(cf,ed_init);
+    if (options->method == string("ipfpe_away"))
+      ipfp->frankWolfeVariant(IPFPGraphEditDistance<int,int>::FW_AWAY);
+    else
+      ipfp->frankWolfeVariant(IPFPGraphEditDistance<int,int>::FW_PAIRWISE);
+    ed = ipfp;
   } else if(options->method == string("ipfpe_multi_bunke")){
     BipartiteGraphEditDistanceMulti<int,int> *ed_init = new BipartiteGraphEditDistanceMulti<int,int>(cf, options->nep);
-    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, ed_init, options->nep, algoIPFP);
+    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, seedGenerator(cf, ed_init, options->uniqueSeeds), options->nep, algoIPFP);
   } else if(options->method == string("ipfpe_multi_rw")){
     RandomWalksGraphEditDistanceMulti *ed_init = new RandomWalksGraphEditDistanceMulti(cf, options->k, options->nep);
-    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, ed_init, options->nep, algoIPFP);
+    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, seedGenerator(cf, ed_init, options->uniqueSeeds), options->nep, algoIPFP);
   } else if(options->method == string("ipfpe_rw")){
     RandomWalksGraphEditDistance *ed_init = new RandomWalksGraphEditDistance(cf,options->k);
     ed =new IPFPGraphEditDistance<int,int>(cf,ed_init);
   
   } else if(options->method == string("ipfpe_multi_random")){
     RandomMappingsGED<int,int> *init = new RandomMappingsGED<int,int>();
-    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, init, options->nep, algoIPFP);
+    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, seedGenerator(cf, init, options->uniqueSeeds), options->nep, algoIPFP);
 
   } else if(options->method == string("ipfpe_multi_greedy")){
     GreedyGraphEditDistance<int,int> *ed_init = new GreedyGraphEditDistance<int,int>(cf, options->nep);
-    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, ed_init, options->nep, algoIPFP);
+    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, seedGenerator(cf, ed_init, options->uniqueSeeds), options->nep, algoIPFP);
+
+  } else if(options->method == string("ipfpe_multi_greedy_refined")){
+    GreedyMappings<int,int> *init = new GreedyMappings<int,int>(cf);
+    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, seedGenerator(cf, init, options->uniqueSeeds), options->nep, algoIPFP);
+
+  } else if(options->method == string("ipfpe_multi_spectral")){
+    SpectralMappings<int,int> *init = new SpectralMappings<int,int>(cf);
+    ed = new MultistartRefinementGraphEditDistance<int,int>(cf, seedGenerator(cf, init, options->uniqueSeeds), options->nep, algoIPFP);
 
   } else if(options->method == string("gnccp")){
     //RandomWalksGraphEditDistance *ed_init = new RandomWalksGraphEditDistance(cf,3 );
     ed = new GNCCPGraphEditDistance<int,int>(cf);//,ed_init);
 
+  } else if(options->method == string("sinkhorn")){
+    ed = new SinkhornGraphEditDistance<int,int>(cf);
+
+  } else if(options->method == string("gnccp_adaptive")){
+    GNCCPGraphEditDistance<int,int> * gnccp = new GNCCPGraphEditDistance<int,int>(cf);
+    gnccp->adaptiveSchedule();
+    ed = gnccp;
+
+  } else if(options->method == string("multilevel")){
+    BipartiteGraphEditDistance<int,int> *ed_init = new BipartiteGraphEditDistance<int,int>(cf);
+    IPFPGraphEditDistance<int,int> * coarse = new IPFPGraphEditDistance<int,int>(cf,ed_init);
+    setLSAPESolver(coarse, options->solver);
+    ed = new MultilevelGraphEditDistance<int,int>(cf, coarse);
+
   } else{
     cerr << "Undefined graph edit distance algorithm "<< endl;
     usage(argv[0]);
     return EXIT_FAILURE;
   }
 
-  ChemicalDataset<double> * dataset = new ChemicalDataset<double>(options->dataset_file.c_str());
-  double * distances = computeGraphEditDistance(dataset,ed,options->shuffle, options->nep);
+  setLSAPESolver(ed, options->solver);
+  setCandidates(ed, options->candidates, options->candidatesParam);
+
+  GraphEditDistance<int,int>* uncached = ed;
+  if (!options->cache_file.empty()){
+    if (options->remapSweep)
+      cerr << "The cache is not used with -W, which changes the costs" << endl;
+    else{
+      CachedGraphEditDistance<int,int> * cached =
+        new CachedGraphEditDistance<int,int>(cf, ed, options->cache_file, methodDescription(options, method));
+      cached->storeMappings(!options->grid_file.empty());
+      ed = cached;
+    }
+  }
+
+  ChemicalDataset<double> * dataset = new ChemicalDataset<double>(options->dataset_file.c_str(), options->datasetCache);
+  double * distances = NULL;
+  if (!options->socket_path.empty()){
+    GEDServer<int,int,double> server(ed, options->socket_path);
+    std::vector<ChemicalDataset<double> *> more;
+    server.addDataset(dataset);
+    for (unsigned int k=0; k<options->more_datasets.size(); k++){
+      more.push_back(new ChemicalDataset<double>(options->more_datasets[k].c_str(), options->datasetCache));
+      server.addDataset(more.back());
+    }
+    cerr << "Serving " << 1 + more.size() << " datasets on " << options->socket_path << endl;
+    if (!server.run())
+      cerr << "Unable to listen on " << options->socket_path << endl;
+    for (unsigned int k=0; k<more.size(); k++) delete more[k];
+  }
+  else if (!options->grid_file.empty())
+    sweepCosts(dataset, ed, cf, readCostGrid(options->grid_file), options->shuffle, options->remapSweep);
+  else
+    distances = computeGraphEditDistance(dataset,ed,options->shuffle, options->nep, options->sequenceLag,
+                                         options->isomorphisms, options->coldCompare);
 
   //Output average distances
   //cout << mean(distances,dataset->size()*dataset->size())<< endl;
   
   
   delete algoIPFP;
+  if (ed != uncached) delete uncached;
   delete ed;
   delete dataset;
   delete cf;
@@ -11,7 +11,12 @@
  *
  */
 
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
 #include "graph.h"
 #include "tinyxml.h"
 #include "Dataset.h"
@@ -22,6 +27,21 @@
 #include "RandomWalksGraphEditDistance.h"
 #include "IPFPGraphEditDistance.h"
 #include "GNCCPGraphEditDistance.h"
+#include "SinkhornGraphEditDistance.h"
+#include "LSAPESolver.h"
+#include "SparseLSAPE.h"
+#include "MultilevelGraphEditDistance.h"
+#include "SpectralMappings.h"
+#include "UniqueMappings.h"
+#include "GraphIsomorphism.h"
+#include "ResultCache.h"
+#include "GEDServer.h"
+#include "GEDJobs.h"
+#include "RandomMappings.h"
+#include "PointDistanceCost.h"
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 using namespace std;
 
@@ -86,9 +106,1350 @@ void usage (char * s)
 
 
 
+/**
+ * Cost of an LSAPE solution, -1 if rho and varrho are not consistent
+ */
+double lsapeCost(double * C, int n, int m, int * rho, int * varrho){
+  double cost = 0;
+  for (int i=0; i<n; i++){
+    if (rho[i] < 0 || rho[i] > m || (rho[i] < m && varrho[rho[i]] != i)) return -1;
+    cost += C[sub2ind(i,rho[i],n+1)];
+  }
+  for (int j=0; j<m; j++){
+    if (varrho[j] < 0 || varrho[j] > n || (varrho[j] < n && rho[varrho[j]] != j)) return -1;
+    if (varrho[j] == n) cost += C[sub2ind(n,j,n+1)];
+  }
+  return cost;
+}
+
+/**
+ * Compare jvLSAPE, cold and warm started, auctionLSAPE and tinyLSAPEBatch with hungarianLSAPE on random
+ * cost matrices, and check the greedy approximations and sparseLSAPE against it.
+ * Returns the number of mismatches.
+ */
+int testLSAPE(int nbTests){
+  int nbErrors = 0;
+  srand(42);
+  for (int t=0; t<nbTests; t++){
+    // One problem out of two is small enough for tinyLSAPEBatch
+    int n = (t%4 < 2) ? rand()%30 : rand()%(TINY_LSAPE_MAX+1);
+    int m = (t%4 < 2) ? rand()%30 : rand()%(TINY_LSAPE_MAX+1);
+    double * C = new double[(n+1)*(m+1)];
+    for (int k=0; k<(n+1)*(m+1); k++)
+      C[k] = (t%2) ? rand()%5 : (double)rand()/RAND_MAX*10 - 5;
+    int * rho = new int[n+1];
+    int * varrho = new int[m+1];
+    int * rhoJV = new int[n+1];
+    int * varrhoJV = new int[m+1];
+    double * u = new double[n+1];
+    double * v = new double[m+1];
+
+    hungarianLSAPE(C, n+1, m+1, rho, varrho, u, v, false);
+    double ref = lsapeCost(C, n, m, rho, varrho);
+    jvLSAPE(C, n+1, m+1, rhoJV, varrhoJV, u, v);
+    double cost = lsapeCost(C, n, m, rhoJV, varrhoJV);
+    double dual = 0;
+    for (int i=0; i<n; i++) dual += u[i];
+    for (int j=0; j<m; j++) dual += v[j];
+    if (fabs(cost - ref) > 1e-9 || fabs(dual - ref) > 1e-9) nbErrors++;
+
+    // Duals and solution of the unperturbed problem, for the warm start below
+    double * uWarm = new double[n+1];
+    double * vWarm = new double[m+1];
+    int * rhoWarm = new int[n+1];
+    int * varrhoWarm = new int[m+1];
+    for (int i=0; i<=n; i++){ uWarm[i] = u[i]; rhoWarm[i] = rhoJV[i]; }
+    for (int j=0; j<=m; j++){ vWarm[j] = v[j]; varrhoWarm[j] = varrhoJV[j]; }
+
+    if (n <= TINY_LSAPE_MAX && m <= TINY_LSAPE_MAX){
+      tinyLSAPEBatch(C, n, m, 1, &cost);
+      if (fabs(cost - ref) > 1e-9) nbErrors++;
+    }
+
+    // The auction is exact on integer costs
+    if (t%2){
+      auctionLSAPE(C, n+1, m+1, rhoJV, varrhoJV, u, v);
+      if (fabs(lsapeCost(C, n, m, rhoJV, varrhoJV) - ref) > 1e-9) nbErrors++;
+    }
+
+    // The greedy approximations are valid, not better than the optimum, and 2-opt does not degrade them
+    greedySortLSAPE(C, n+1, m+1, rhoJV, varrhoJV);
+    double greedy = lsapeCost(C, n, m, rhoJV, varrhoJV);
+    twoOptLSAPE(C, n+1, m+1, rhoJV, varrhoJV);
+    cost = lsapeCost(C, n, m, rhoJV, varrhoJV);
+    if (greedy < ref - 1e-9 || cost < ref - 1e-9 || cost > greedy + 1e-9) nbErrors++;
+    greedyRowLSAPE(C, n+1, m+1, rhoJV, varrhoJV);
+    if (lsapeCost(C, n, m, rhoJV, varrhoJV) < ref - 1e-9) nbErrors++;
+
+    // sparseLSAPE on candidates is the LSAPE where the other substitutions cost more than a
+    // deletion and an insertion
+    SparseCostMatrix<double> S;
+    selectCandidates<double>(n, m, [&](int i, int j){ return C[sub2ind(i,j,n+1)]; },
+                             (t%3) ? CANDIDATES_TOP : CANDIDATES_COMPATIBLE, t%5, S);
+    S.gather(C);
+    double * Cs = new double[(n+1)*(m+1)];
+    for (int k=0; k<(n+1)*(m+1); k++) Cs[k] = C[k];
+    for (int i=0; i<n; i++){
+      for (int j=0; j<m; j++)
+        Cs[sub2ind(i,j,n+1)] = C[sub2ind(i,m,n+1)] + C[sub2ind(n,j,n+1)] + 1;
+      for (int p=S.ptr[i]; p<S.ptr[i+1]; p++)
+        Cs[sub2ind(i,S.col[p],n+1)] = C[sub2ind(i,S.col[p],n+1)];
+    }
+    hungarianLSAPE(Cs, n+1, m+1, rho, varrho, u, v, false);
+    cost = sparseLSAPE(S, rhoJV, varrhoJV);
+    if (fabs(cost - lsapeCost(Cs, n, m, rho, varrho)) > 1e-9 ||
+        fabs(cost - lsapeCost(C, n, m, rhoJV, varrhoJV)) > 1e-9) nbErrors++;
+    delete [] Cs;
+
+    // Warm start on a perturbed matrix, from the duals and the solution of the unperturbed one
+    for (int k=0; k<(n+1)*(m+1); k++)
+      C[k] += (double)rand()/RAND_MAX - 0.5;
+    hungarianLSAPE(C, n+1, m+1, rho, varrho, u, v, false);
+    ref = lsapeCost(C, n, m, rho, varrho);
+    jvLSAPE(C, n+1, m+1, rhoWarm, varrhoWarm, uWarm, vWarm, true, true);
+    if (fabs(lsapeCost(C, n, m, rhoWarm, varrhoWarm) - ref) > 1e-9) nbErrors++;
+    delete [] uWarm; delete [] vWarm;
+    delete [] rhoWarm; delete [] varrhoWarm;
+
+    delete [] C;
+    delete [] rho; delete [] varrho;
+    delete [] rhoJV; delete [] varrhoJV;
+    delete [] u; delete [] v;
+  }
+  return nbErrors;
+}
+
+
+
+/**
+ * tinyLSAPEBatch on batches of P > 1 interleaved problems, with more rows than columns, more columns
+ * than rows or as many, against hungarianLSAPE on each problem. Returns the number of mismatches.
+ */
+int testTinyLSAPEBatch(int nbTests){
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    int n = rand()%(TINY_LSAPE_MAX+1);
+    int m = rand()%(TINY_LSAPE_MAX+1);
+    int P = 2 + rand()%15;
+    int size = (n+1)*(m+1);
+    double * C = new double[size*P];
+    for (int k=0; k<size*P; k++)
+      C[k] = (t%2) ? rand()%5 : (double)rand()/RAND_MAX*10 - 5;
+    double * cost = new double[P];
+    double * work = (t%3) ? NULL : new double[(2 << std::min(n,m))*P];
+    tinyLSAPEBatch(C, n, m, P, cost, work);
+
+    double * Cp = new double[size];
+    int * rho = new int[n+1];
+    int * varrho = new int[m+1];
+    double * u = new double[n+1];
+    double * v = new double[m+1];
+    for (int p=0; p<P; p++){
+      for (int k=0; k<size; k++) Cp[k] = C[k*P + p];
+      hungarianLSAPE(Cp, n+1, m+1, rho, varrho, u, v, false);
+      if (fabs(cost[p] - lsapeCost(Cp, n, m, rho, varrho)) > 1e-9) nbErrors++;
+    }
+    delete [] Cp;
+    delete [] rho; delete [] varrho;
+    delete [] u; delete [] v;
+    delete [] work;
+    delete [] cost;
+    delete [] C;
+  }
+  return nbErrors;
+}
+
+/**
+ * auctionLSAPE on real costs, with the default and with larger final epsilons : the cost of the
+ * assignment is within \f$(n+m)\epsilon\f$ of the one of hungarianLSAPE, and the duals are feasible
+ * with a sum between the optimum minus the same amount and the optimum. Returns the number of failures.
+ */
+int testAuction(int nbTests){
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    int n = rand()%40;
+    int m = rand()%40;
+    double * C = new double[(n+1)*(m+1)];
+    for (int k=0; k<(n+1)*(m+1); k++) C[k] = (double)rand()/RAND_MAX*10;
+    int * rho = new int[n+1];
+    int * varrho = new int[m+1];
+    double * u = new double[n+1];
+    double * v = new double[m+1];
+    hungarianLSAPE(C, n+1, m+1, rho, varrho, u, v, false);
+    double ref = lsapeCost(C, n, m, rho, varrho);
+
+    // 0 is the default epsilon, 1e-9 max|c| / (n+m) with max|c| <= 10
+    double epsilon = (t%3 == 0) ? 0 : (t%3 == 1) ? 1e-3 : 1e-1;
+    double bound = ((epsilon > 0) ? (n+m) * epsilon : 1e-8) + 1e-9;
+    auctionLSAPE(C, n+1, m+1, rho, varrho, u, v, epsilon);
+    double cost = lsapeCost(C, n, m, rho, varrho);
+    double dual = 0;
+    bool feasible = true;
+    for (int i=0; i<n; i++){
+      dual += u[i];
+      feasible = feasible && u[i] <= C[sub2ind(i,m,n+1)] + 1e-9;
+      for (int j=0; j<m; j++)
+        feasible = feasible && u[i] + v[j] <= C[sub2ind(i,j,n+1)] + 1e-9;
+    }
+    for (int j=0; j<m; j++){
+      dual += v[j];
+      feasible = feasible && v[j] <= C[sub2ind(n,j,n+1)] + 1e-9;
+    }
+    if (cost < ref - 1e-9 || cost > ref + bound || !feasible || dual > ref + 1e-9 || dual < ref - bound)
+      nbErrors++;
+
+    delete [] C;
+    delete [] rho; delete [] varrho;
+    delete [] u; delete [] v;
+  }
+  return nbErrors;
+}
+
+/**
+ * Graph of n nodes with labels in 1..3, each edge present with probability p
+ */
+SymbolicGraph * randomGraph(int n, double p, bool directed = false){
+  int * am = new int[n*n];
+  memset(am, 0, sizeof(int)*n*n);
+  for (int i=0; i<n; i++){
+    am[sub2ind(i,i,n)] = 1 + rand()%3;
+    for (int j=0; j<i; j++){
+      if ((double)rand()/RAND_MAX < p)
+        am[sub2ind(i,j,n)] = am[sub2ind(j,i,n)] = 1 + rand()%2;
+      if (directed && (double)rand()/RAND_MAX < p)
+        am[sub2ind(j,i,n)] = 1 + rand()%2;
+      else if (directed)
+        am[sub2ind(j,i,n)] = 0;
+    }
+  }
+  SymbolicGraph * g = new SymbolicGraph(am, n, directed);
+  delete [] am;
+  return g;
+}
+
+/**
+ * True if the n+m first entries of mapping are a permutation of 0..n+m-1
+ */
+bool isPermutation(const int * mapping, int n, int m){
+  std::vector<bool> seen(n+m, false);
+  for (int i=0; i<n+m; i++){
+    if (mapping[i] < 0 || mapping[i] >= n+m || seen[mapping[i]]) return false;
+    seen[mapping[i]] = true;
+  }
+  return true;
+}
+
+/**
+ * True if G1_to_G2 and G2_to_G1 are the two sides of a same mapping, with epsilon as m (resp. n)
+ */
+bool isMapping(const int * G1_to_G2, const int * G2_to_G1, int n, int m){
+  for (int i=0; i<n; i++)
+    if (G1_to_G2[i] < 0 || G1_to_G2[i] > m || (G1_to_G2[i] < m && G2_to_G1[G1_to_G2[i]] != i)) return false;
+  for (int j=0; j<m; j++)
+    if (G2_to_G1[j] < 0 || G2_to_G1[j] > n || (G2_to_G1[j] < n && G1_to_G2[G2_to_G1[j]] != j)) return false;
+  return true;
+}
+
+/**
+ * MultilevelGraphEditDistance on graphs coarsened over several levels : the mapping is valid, and
+ * the local search does not degrade the projected mapping. Returns the number of failures.
+ */
+int testMultilevel(int nbTests){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  MultilevelGraphEditDistance<int,int> projected(&cf, &bipartite, 6);
+  MultilevelGraphEditDistance<int,int> refined(&cf, &bipartite, 6);
+  projected.refinementPasses(0);
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    int n = 20 + rand()%30;
+    int m = 20 + rand()%30;
+    SymbolicGraph * g1 = randomGraph(n, 0.15);
+    SymbolicGraph * g2 = randomGraph(m, 0.15);
+    int * G1_to_G2 = new int[n];
+    int * G2_to_G1 = new int[m];
+    refined.getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    if (!isMapping(G1_to_G2, G2_to_G1, n, m) ||
+        refined.GedFromMapping(g1, g2, G1_to_G2, n, G2_to_G1, m) > projected(g1, g2) + 1e-9)
+      nbErrors++;
+    delete [] G1_to_G2;
+    delete [] G2_to_G1;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * Ring of 6 nodes labelled 1, each with a pendant node labelled 2 (a benzene)
+ */
+SymbolicGraph * benzene(){
+  int am[144] = {0};
+  for (int i=0; i<6; i++){
+    am[sub2ind(i,i,12)] = 1;
+    am[sub2ind(6+i,6+i,12)] = 2;
+    am[sub2ind(i,(i+1)%6,12)] = am[sub2ind((i+1)%6,i,12)] = 1;
+    am[sub2ind(i,6+i,12)] = am[sub2ind(6+i,i,12)] = 1;
+  }
+  return new SymbolicGraph(am, 12, false);
+}
+
+/**
+ * The 12 rotations and reflections of a benzene onto itself, then the identity again
+ */
+class BenzeneSymmetries: public MappingGenerator<int,int>
+{
+public:
+  std::list<int*> getMappings(Graph<int,int> * g1, Graph<int,int> * g2, int k){
+    std::list<int*> mappings;
+    for (int t=0; t<=12; t++){
+      int * s = new int[24];
+      for (int i=0; i<6; i++){
+        int j = (t%12 < 6) ? (i+t)%6 : (6-i+t)%6;
+        s[i] = j;
+        s[6+i] = 6+j;
+      }
+      for (int j=0; j<12; j++) s[12+j] = 12+j;
+      mappings.push_back(s);
+    }
+    return mappings;
+  }
+  MappingGenerator<int,int> * clone() const { return new BenzeneSymmetries(); }
+};
+
+/**
+ * UniqueMappings keeps a single mapping out of the images of a mapping by the automorphisms of
+ * the graphs. Returns the number of failures.
+ */
+int testUniqueMappings(){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  SymbolicGraph * g = benzene();
+  BenzeneSymmetries symmetries;
+  UniqueMappings<int,int> unique(&cf, &symmetries);
+  std::list<int*> mappings = unique.getMappings(g, g, 13);
+  int nbErrors = (mappings.size() != 1) + (unique.getNbDiscarded() != 12);
+  for (std::list<int*>::iterator it = mappings.begin(); it != mappings.end(); it++)
+    delete [] *it;
+  delete g;
+  return nbErrors;
+}
+
+/**
+ * Copy of g with its nodes in a random order, and the label of node relabel set to label if
+ * relabel is a node
+ */
+SymbolicGraph * permutedCopy(Graph<int,int> * g, int relabel = -1, int label = 0){
+  int n = g->Size();
+  std::vector<int> perm(n);
+  for (int i=0; i<n; i++) perm[i] = i;
+  for (int i=n-1; i>0; i--) std::swap(perm[i], perm[rand()%(i+1)]);
+  int * am = new int[n*n];
+  memset(am, 0, sizeof(int)*n*n);
+  for (int i=0; i<n; i++){
+    am[sub2ind(perm[i],perm[i],n)] = (i == relabel) ? label : (*g)[i]->attr;
+    for (GEdge<int> * e = (*g)[i]->getIncidentEdges(); e; e = e->Next())
+      am[sub2ind(perm[i],perm[e->IncidentNode()],n)] = e->attr;
+  }
+  SymbolicGraph * copy = new SymbolicGraph(am, n, false);
+  delete [] am;
+  return copy;
+}
+
+/**
+ * Copy of g, in the same node order, with nbChanges edges added or removed at random
+ */
+SymbolicGraph * perturbedCopy(Graph<int,int> * g, int nbChanges){
+  int n = g->Size();
+  int * am = new int[n*n];
+  memset(am, 0, sizeof(int)*n*n);
+  for (int i=0; i<n; i++){
+    am[sub2ind(i,i,n)] = (*g)[i]->attr;
+    for (GEdge<int> * e = (*g)[i]->getIncidentEdges(); e; e = e->Next())
+      am[sub2ind(i,e->IncidentNode(),n)] = e->attr;
+  }
+  for (int c=0; c<nbChanges; c++){
+    int i = rand()%n, j = rand()%n;
+    if (i == j) continue;
+    am[sub2ind(i,j,n)] = am[sub2ind(j,i,n)] = am[sub2ind(i,j,n)] ? 0 : 1;
+  }
+  SymbolicGraph * copy = new SymbolicGraph(am, n, false);
+  delete [] am;
+  return copy;
+}
+
+/**
+ * IsomorphismShortcut answers 0 with an exact mapping for a graph and a permuted copy of it, and
+ * the wrapped method for a relabelled copy. Returns the number of failures.
+ */
+int testIsomorphismShortcut(int nbTests){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  IsomorphismShortcut<int,int> shortcut(&cf, &bipartite);
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    int n = 2 + rand()%15;
+    SymbolicGraph * g = randomGraph(n, 0.3);
+    SymbolicGraph * permuted = permutedCopy(g);
+    SymbolicGraph * relabelled = permutedCopy(g, rand()%n, 4);
+    int * G1_to_G2 = new int[n];
+    int * G2_to_G1 = new int[n];
+    shortcut.getOptimalMapping(g, permuted, G1_to_G2, G2_to_G1);
+    if (!isMapping(G1_to_G2, G2_to_G1, n, n) ||
+        shortcut.GedFromMapping(g, permuted, G1_to_G2, n, G2_to_G1, n) != 0) nbErrors++;
+    if (shortcut(g, relabelled) != bipartite(g, relabelled) || shortcut(g, relabelled) == 0) nbErrors++;
+    delete [] G1_to_G2;
+    delete [] G2_to_G1;
+    delete g;
+    delete permuted;
+    delete relabelled;
+    shortcut.clearCache(); // the next graphs may be allocated at the same addresses
+  }
+  if (shortcut.getNbShortcuts() != nbTests) nbErrors++;
+  return nbErrors;
+}
+
+/**
+ * Round trip of the distances and mappings of CachedGraphEditDistance through a file : a second
+ * instance finds all of them, unchanged, and another method none. Returns the number of failures.
+ */
+int testResultCache(int nbGraphs){
+  const char * filename = "test_graph.results";
+  unlink(filename);
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  std::vector<SymbolicGraph *> graphs;
+  for (int k=0; k<nbGraphs; k++) graphs.push_back(randomGraph(2 + rand()%10, 0.3));
+  int N = nbGraphs;
+  int nbErrors = 0;
+
+  std::vector<double> distances(N*N);
+  {
+    CachedGraphEditDistance<int,int> cached(&cf, &bipartite, filename, "bipartite");
+    cached.storeMappings();
+    for (int i=0; i<N; i++)
+      for (int j=0; j<N; j++)
+        distances[sub2ind(i,j,N)] = cached(graphs[i], graphs[j]);
+    if (cached.cache().getNbHits() != 0) nbErrors++;
+  }
+
+  CachedGraphEditDistance<int,int> reopened(&cf, &bipartite, filename, "bipartite");
+  for (int i=0; i<N; i++)
+    for (int j=0; j<N; j++){
+      int n = graphs[i]->Size(), m = graphs[j]->Size();
+      int * G1_to_G2 = new int[n];
+      int * G2_to_G1 = new int[m];
+      if (reopened(graphs[i], graphs[j]) != distances[sub2ind(i,j,N)]) nbErrors++;
+      reopened.getOptimalMapping(graphs[i], graphs[j], G1_to_G2, G2_to_G1);
+      if (!isMapping(G1_to_G2, G2_to_G1, n, m) ||
+          reopened.GedFromMapping(graphs[i], graphs[j], G1_to_G2, n, G2_to_G1, m) != distances[sub2ind(i,j,N)])
+        nbErrors++;
+      delete [] G1_to_G2;
+      delete [] G2_to_G1;
+    }
+  if (reopened.cache().getNbHits() != 2*N*N || reopened.cache().getNbMisses() != 0) nbErrors++;
+
+  CachedGraphEditDistance<int,int> other(&cf, &bipartite, filename, "another method");
+  double d;
+  if (other.lookup(graphs[0], graphs[0], d)) nbErrors++;
+
+  for (int k=0; k<N; k++) delete graphs[k];
+  unlink(filename);
+  return nbErrors;
+}
+
+/**
+ * True if a and b have the same labels and edges, in the same order
+ */
+bool sameGraph(Graph<int,int> * a, Graph<int,int> * b){
+  if (a->Size() != b->Size() || a->getNbEdges() != b->getNbEdges()) return false;
+  for (int i=0; i<a->Size(); i++){
+    if ((*a)[i]->attr != (*b)[i]->attr) return false;
+    GEdge<int> * p = (*a)[i]->getIncidentEdges();
+    GEdge<int> * q = (*b)[i]->getIncidentEdges();
+    for (; p && q; p = p->Next(), q = q->Next())
+      if (p->IncidentNode() != q->IncidentNode() || p->attr != q->attr) return false;
+    if (p || q) return false;
+  }
+  return true;
+}
+
+/**
+ * Write a dataset of nbGraphs random graphs in the current directory, with properties i*scale
+ */
+void writeTestDataset(int nbGraphs, double scale){
+  std::ofstream ds("test_graph.ds");
+  srand(7);
+  for (int i=0; i<nbGraphs; i++){
+    SymbolicGraph * g = randomGraph(2 + rand()%12, 0.3);
+    stringstream name;
+    name << "test_graph_" << i << ".ct";
+    std::ofstream ct(name.str().c_str());
+    writeCTfile(*g, ct);
+    ds << name.str() << " " << i*scale << endl;
+    delete g;
+  }
+}
+
+/**
+ * Round trip of a dataset through its sidecar cache (option -d), which is dropped when the dataset
+ * file changes. Returns the number of failures.
+ */
+int testDatasetCache(int nbGraphs){
+  int nbErrors = 0;
+  unlink("test_graph.ds.cache");
+  writeTestDataset(nbGraphs, 1.5);
+  ChemicalDataset<double> parsed("test_graph.ds");
+  ChemicalDataset<double> written("test_graph.ds", true);
+  struct stat st;
+  if (stat("test_graph.ds.cache", &st) != 0) nbErrors++;
+  ChemicalDataset<double> loaded("test_graph.ds", true);
+  if (parsed.size() != nbGraphs || written.size() != nbGraphs || loaded.size() != nbGraphs) return nbErrors+1;
+  for (int i=0; i<nbGraphs; i++)
+    if (!sameGraph(parsed[i], written[i]) || !sameGraph(parsed[i], loaded[i]) || parsed(i) != loaded(i))
+      nbErrors++;
+
+  // New properties : the stamp of the sidecar file no longer matches
+  writeTestDataset(nbGraphs, 2.5);
+  ChemicalDataset<double> changed("test_graph.ds", true);
+  for (int i=0; i<nbGraphs; i++)
+    if (changed(i) != i*2.5) nbErrors++;
+
+  for (int i=0; i<nbGraphs; i++){
+    stringstream name;
+    name << "test_graph_" << i << ".ct";
+    unlink(name.str().c_str());
+  }
+  unlink("test_graph.ds");
+  unlink("test_graph.ds.cache");
+  return nbErrors;
+}
+
+/**
+ * Distance, k-NN and range requests to a GEDServer on a dataset, while another client stays
+ * connected without sending anything. Returns the number of wrong answers.
+ */
+int testServer(int nbGraphs){
+  const char * path = "test_graph.sock";
+  int nbErrors = 0;
+  writeTestDataset(nbGraphs, 1);
+  ChemicalDataset<double> dataset("test_graph.ds");
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  GEDServer<int,int,double> server(&bipartite, path);
+  server.addDataset(&dataset);
+  std::thread serving([&server]{ server.run(2); });
+  usleep(100000);
+
+  GEDClient idle(path);
+  GEDClient client(path);
+  if (!idle.isConnected() || !client.ping()) nbErrors++;
+  std::vector<uint32_t> sizes;
+  if (!client.info(sizes) || sizes.size() != 1 || (int)sizes[0] != nbGraphs) nbErrors++;
+  for (int i=0; i<nbGraphs; i++){
+    double d;
+    if (!client.distance(0, i, (i*7)%nbGraphs, d) || d != bipartite(dataset[i], dataset[(i*7)%nbGraphs]))
+      nbErrors++;
+  }
+  double d;
+  if (client.distance(0, nbGraphs, 0, d)) nbErrors++;
+
+  std::vector<std::pair<uint32_t,double> > knn, range;
+  if (!client.knn(0, 3, 5, knn) || knn.size() != 5) nbErrors++;
+  for (unsigned int t=0; t<knn.size(); t++)
+    if (knn[t].first == 3 || knn[t].second != bipartite(dataset[3], dataset[knn[t].first]) ||
+        (t > 0 && knn[t].second < knn[t-1].second))
+      nbErrors++;
+  if (!knn.empty() && (!client.range(0, 3, knn.back().second, range) || range.size() < knn.size()))
+    nbErrors++;
+
+  if (!client.shutdownServer()) nbErrors++;
+  serving.join();
+  if (idle.ping()) nbErrors++;
+
+  for (int i=0; i<nbGraphs; i++){
+    stringstream name;
+    name << "test_graph_" << i << ".ct";
+    unlink(name.str().c_str());
+  }
+  unlink("test_graph.ds");
+  return nbErrors;
+}
+
+/**
+ * Jobs of a GEDJobQueue : the cancelled ones throw GEDJobCancelled, the other ones return the
+ * distance of the method, and an expired budget stops IPFP between the bipartite initialization
+ * and the full refinement. Returns the number of failures.
+ */
+int testJobs(int nbJobs){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  IPFPGraphEditDistance<int,int> ipfp(&cf, &bipartite);
+  int nbErrors = 0;
+  std::vector<SymbolicGraph *> graphs;
+  for (int k=0; k<nbJobs+1; k++) graphs.push_back(randomGraph(10 + rand()%20, 0.3));
+
+  {
+    GEDJobQueue<int,int> queue(&ipfp, 1);
+    std::vector<GEDJob<double> > jobs;
+    for (int k=0; k<nbJobs; k++) jobs.push_back(queue.submit(graphs[k], graphs[k+1]));
+    for (int k=0; k<nbJobs; k+=2) jobs[k].cancel();
+    for (int k=0; k<nbJobs; k++){
+      try{
+        double d = jobs[k].get();
+        if (k%2 == 0 || d != ipfp(graphs[k], graphs[k+1])) nbErrors++;
+      }
+      catch(const GEDJobCancelled &){
+        if (k%2 == 1) nbErrors++;
+      }
+    }
+    if (queue.getNbQueued() != 0) nbErrors++;
+  }
+
+  {
+    GEDJobQueue<int,int> queue(&ipfp, 2);
+    std::vector<std::pair<Graph<int,int>*,Graph<int,int>*> > pairs;
+    for (int k=0; k<nbJobs; k++) pairs.push_back(std::make_pair(graphs[k], graphs[k+1]));
+    GEDJob<std::vector<double> > expired = queue.submit(pairs, 0, 1e-9);
+    GEDJob<std::vector<double> > unlimited = queue.submit(pairs);
+    std::vector<double> d = expired.get();
+    std::vector<double> full = unlimited.get();
+    for (int k=0; k<nbJobs; k++)
+      if (d[k] < full[k] || d[k] > bipartite(graphs[k], graphs[k+1]) || full[k] != ipfp(graphs[k], graphs[k+1]))
+        nbErrors++;
+  }
+
+  for (unsigned int k=0; k<graphs.size(); k++) delete graphs[k];
+  return nbErrors;
+}
+
+/**
+ * Quadratic term of X by its definition : entry (j,l) sums the costs of the edges (i,j) and (k,l)
+ * weighted by x_ik, halved for undirected graphs
+ */
+std::vector<double> quadraticTermByDefinition(Graph<int,int> * g1, Graph<int,int> * g2, const double * X,
+                                              EditDistanceCost<int,int> * cf){
+  int n = g1->Size(), m = g2->Size();
+  bool directed = g1->isDirected() && g2->isDirected();
+  std::vector<double> D((n+1)*(m+1), 0.);
+  for (int j=0; j<=n; j++)
+    for (int l=0; l<=m; l++){
+      for (int i=0; i<=n; i++)
+        for (int k=0; k<=m; k++){
+          double x = X[sub2ind(i,k,n+1)];
+          if (x == 0 || (i == j && i < n) || (k == l && k < m)) continue;
+          GEdge<int> * e1 = (i < n && j < n) ? g1->getEdge(i,j) : NULL;
+          GEdge<int> * e2 = (k < m && l < m) ? g2->getEdge(k,l) : NULL;
+          if (e1 && e2) D[sub2ind(j,l,n+1)] += cf->EdgeSubstitutionCost(e1,e2,g1,g2) * x;
+          else if (e1) D[sub2ind(j,l,n+1)] += cf->EdgeDeletionCost(e1,g1) * x;
+          else if (e2) D[sub2ind(j,l,n+1)] += cf->EdgeInsertionCost(e2,g2) * x;
+        }
+      if (!directed) D[sub2ind(j,l,n+1)] *= 0.5;
+    }
+  return D;
+}
+
+/**
+ * Access to the quadratic terms of IPFP
+ */
+class IPFPKernels: public IPFPGraphEditDistance<int,int>
+{
+public:
+  IPFPKernels(EditDistanceCost<int,int> * cf): IPFPGraphEditDistance<int,int>(cf){}
+  double * dense(Graph<int,int> * g1, Graph<int,int> * g2, double * X, double * D){
+    this->_directed = g1->isDirected() && g2->isDirected();
+    return this->QuadraticTerm(g1, g2, X, D);
+  }
+  double * coordinate(Graph<int,int> * g1, Graph<int,int> * g2, double * X, double * D){
+    this->_directed = g1->isDirected() && g2->isDirected();
+    std::vector<std::pair<std::pair<int,int>,double> > entries;
+    for (int k=0; k<=g2->Size(); k++)
+      for (int i=0; i<=g1->Size(); i++)
+        if (X[sub2ind(i,k,g1->Size()+1)] != 0)
+          entries.push_back(std::make_pair(std::make_pair(i,k), X[sub2ind(i,k,g1->Size()+1)]));
+    return this->QuadraticTerm(g1, g2, entries, D);
+  }
+  double * mapping(Graph<int,int> * g1, Graph<int,int> * g2, int * G1_to_G2, int * G2_to_G1, double * D){
+    this->_directed = g1->isDirected() && g2->isDirected();
+    return this->QuadraticTerm(g1, g2, G1_to_G2, G2_to_G1, D);
+  }
+};
+
+/**
+ * The dense, coordinate and mapping quadratic terms of IPFP against their definition, on directed
+ * and undirected pairs, and IPFP with and without the coordinate form of its iterate, which give
+ * the same mappings. Returns the number of failures.
+ */
+int testQuadraticTerms(int nbTests){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    bool directed = t%2;
+    int n = 1 + rand()%8;
+    int m = 1 + rand()%8;
+    SymbolicGraph * g1 = randomGraph(n, 0.4, directed);
+    SymbolicGraph * g2 = randomGraph(m, 0.4, directed);
+    int * G1_to_G2 = new int[n];
+    int * G2_to_G1 = new int[m];
+    bipartite.getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    std::vector<double> X((n+1)*(m+1), 0.), B((n+1)*(m+1), 0.), D((n+1)*(m+1));
+    for (int k=0; k<(n+1)*(m+1); k++)
+      if (rand()%3) X[k] = (double)rand()/RAND_MAX;
+    for (int i=0; i<n; i++) B[sub2ind(i,G1_to_G2[i],n+1)] = 1;
+    for (int j=0; j<m; j++) if (G2_to_G1[j] == n) B[sub2ind(n,j,n+1)] = 1;
+
+    IPFPKernels kernels(&cf);
+    std::vector<double> ref = quadraticTermByDefinition(g1, g2, X.data(), &cf);
+    std::vector<double> refB = quadraticTermByDefinition(g1, g2, B.data(), &cf);
+    double err = 0;
+    kernels.dense(g1, g2, X.data(), D.data());
+    for (int k=0; k<(n+1)*(m+1); k++) err = std::max(err, fabs(D[k] - ref[k]));
+    kernels.coordinate(g1, g2, X.data(), D.data());
+    for (int k=0; k<(n+1)*(m+1); k++) err = std::max(err, fabs(D[k] - ref[k]));
+    kernels.mapping(g1, g2, G1_to_G2, G2_to_G1, D.data());
+    for (int k=0; k<(n+1)*(m+1); k++) err = std::max(err, fabs(D[k] - refB[k]));
+    if (err > 1e-9) nbErrors++;
+    delete [] G1_to_G2;
+    delete [] G2_to_G1;
+    delete g1;
+    delete g2;
+  }
+
+  // The iterates of both forms are the same on directed graphs. On undirected graphs, the quadratic
+  // terms are computed in coordinate form while Xk is sparse, which may break the ties of the LSAPE
+  // otherwise, so the pairs are a graph and a copy with a few edits, whose mapping has no ties.
+  IPFPGraphEditDistance<int,int> sparse(&cf, &bipartite);
+  IPFPGraphEditDistance<int,int> dense(&cf, &bipartite);
+  dense.setSparseDensity(0);
+  for (int t=0; t<nbTests; t++){
+    bool directed = t%2;
+    SymbolicGraph * g1 = randomGraph(10 + rand()%30, 0.2, directed);
+    SymbolicGraph * g2 = directed ? randomGraph(10 + rand()%30, 0.2, true) : perturbedCopy(g1, 4);
+    int n = g1->Size();
+    int m = g2->Size();
+    int * G1_to_G2 = new int[n];
+    int * G2_to_G1 = new int[m];
+    int * H1_to_H2 = new int[n];
+    int * H2_to_G1 = new int[m];
+    sparse.getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    dense.getOptimalMapping(g1, g2, H1_to_H2, H2_to_G1);
+    if (memcmp(G1_to_G2, H1_to_H2, n*sizeof(int)) || memcmp(G2_to_G1, H2_to_G1, m*sizeof(int)) ||
+        sparse.GedFromMapping(g1, g2, G1_to_G2, n, G2_to_G1, m) != dense.GedFromMapping(g1, g2, H1_to_H2, n, H2_to_G1, m))
+      nbErrors++;
+    delete [] G1_to_G2; delete [] G2_to_G1;
+    delete [] H1_to_H2; delete [] H2_to_G1;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * rowDistances of IPFP with the bipartite initialization and without initialization : the batch
+ * gives the distances of the method pair by pair. Returns the number of differences.
+ */
+int testRowDistances(int nbGraphs){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  IPFPGraphEditDistance<int,int> initialized(&cf, &bipartite);
+  IPFPGraphEditDistance<int,int> uninitialized(&cf);
+  std::vector<Graph<int,int> *> graphs;
+  for (int k=0; k<nbGraphs; k++) graphs.push_back(randomGraph(2 + rand()%15, 0.3));
+  int nbErrors = 0;
+  std::vector<double> row(nbGraphs);
+  for (int i=0; i<nbGraphs; i++){
+    initialized.rowDistances(graphs[i], graphs, row.data());
+    for (int j=0; j<nbGraphs; j++)
+      if (fabs(row[j] - initialized(graphs[i], graphs[j])) > 1e-9) nbErrors++;
+    uninitialized.rowDistances(graphs[i], graphs, row.data());
+    for (int j=0; j<nbGraphs; j++)
+      if (fabs(row[j] - uninitialized(graphs[i], graphs[j])) > 1e-9) nbErrors++;
+  }
+  for (int k=0; k<nbGraphs; k++) delete graphs[k];
+  return nbErrors;
+}
+
+/**
+ * Away-step and pairwise iterations of IPFPZetaGraphEditDistance along a GNCCP path, Xk being
+ * carried from one zeta to the next : the objective of each zeta never increases. Returns the
+ * number of runs where it does.
+ */
+int testZetaActiveSet(int nbTests){
+  typedef IPFPGraphEditDistance<int,int> IPFP;
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    int n = 5 + rand()%15;
+    int m = 5 + rand()%15;
+    SymbolicGraph * g1 = randomGraph(n, 0.3);
+    SymbolicGraph * g2 = randomGraph(m, 0.3);
+    int * G1_to_G2 = new int[n];
+    int * G2_to_G1 = new int[m];
+    bipartite.getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    IPFPZetaGraphEditDistance<int,int> zeta(&cf, 1);
+    zeta.frankWolfeVariant((t%2) ? IPFP::FW_AWAY : IPFP::FW_PAIRWISE);
+    zeta.setCurrentMatrix(G1_to_G2, G2_to_G1, n, m);
+    zeta.IPFPsetup(g1, g2);
+    for (double z=1; z>-1; z-=0.25){
+      zeta.setZeta(z);
+      zeta.IPFPiterations(g1, g2);
+      const std::vector<double> & S = zeta.getObjectives();
+      for (unsigned int k=1; k<S.size(); k++)
+        if (S[k] > S[k-1] + 1e-9*(1+fabs(S[k-1]))){
+          nbErrors++;
+          break;
+        }
+    }
+    delete [] G1_to_G2;
+    delete [] G2_to_G1;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * sequenceDistances on frames which change slowly : the pairs started from the composed mappings
+ * need fewer iterations than the same pairs refined from the bipartite initialization, and the pairs
+ * beyond the maximal lag are the distances of the method. Returns the number of failures.
+ */
+int testSequence(int nbFrames){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  IPFPGraphEditDistance<int,int> ipfp(&cf, &bipartite);
+  std::vector<Graph<int,int> *> frames(1, randomGraph(40, 0.1));
+  for (int s=1; s<nbFrames; s++) frames.push_back(perturbedCopy(frames.back(), 2));
+  int nbErrors = 0;
+  double * distances = new double[nbFrames*nbFrames];
+  IPFPWarmStartReport report;
+  ipfp.sequenceDistances(frames, distances, 3, &report);
+  if (report.nbPairs == 0 || report.iterationsWarm >= report.iterationsCold) nbErrors++;
+  // Pairs further apart than maxLag are the ones of the method
+  for (int s=0; s<nbFrames; s++)
+    for (int t=0; t<nbFrames; t++)
+      if (abs(s-t) > 3 && distances[sub2ind(s,t,nbFrames)] != ipfp(frames[s], frames[t])) nbErrors++;
+  delete [] distances;
+  for (unsigned int s=0; s<frames.size(); s++) delete frames[s];
+  return nbErrors;
+}
+
+/**
+ * A GNCCPGraphEditDistance, its sub solver and its workspace reused along pairs whose sizes grow
+ * and shrink gives the distances and the mappings of a new instance on each pair, with the
+ * Hungarian algorithm and with the warm started LSAPE_JV. Returns the number of differences.
+ */
+int testGNCCPReuse(int nbPairs){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  GNCCPGraphEditDistance<int,int> reusedHungarian(&cf, &bipartite);
+  GNCCPGraphEditDistance<int,int> reusedJV(&cf, &bipartite);
+  reusedJV.lsapeSolver(LSAPE_JV);
+  int nbErrors = 0;
+  for (int t=0; t<nbPairs; t++){
+    int n = 1 + rand()%20;
+    int m = 1 + rand()%20;
+    SymbolicGraph * g1 = randomGraph(n, 0.3);
+    SymbolicGraph * g2 = randomGraph(m, 0.3);
+    for (int s=0; s<2; s++){
+      GNCCPGraphEditDistance<int,int> * reused = s ? &reusedJV : &reusedHungarian;
+      GNCCPGraphEditDistance<int,int> fresh(&cf, &bipartite);
+      if (s) fresh.lsapeSolver(LSAPE_JV);
+      int * reusedMapping = new int[n+m];
+      int * freshMapping = new int[n+m];
+      reused->getOptimalMapping(g1, g2, reusedMapping, reusedMapping+n);
+      fresh.getOptimalMapping(g1, g2, freshMapping, freshMapping+n);
+      if (!std::equal(reusedMapping, reusedMapping+n+m, freshMapping) ||
+          reused->getNbSteps() != fresh.getNbSteps() ||
+          reused->getNbInnerIterations() != fresh.getNbInnerIterations()) nbErrors++;
+      delete [] reusedMapping;
+      delete [] freshMapping;
+    }
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * Adaptive zeta schedule of GNCCPGraphEditDistance : the path starts at zeta = 1 and ends at
+ * zeta = -1 unless Xk becomes binary before, each decrease of zeta is at most _dMax, hence at
+ * least 1 + 2/_dMax steps to reach -1, and at least _dMin but the last one, hence at most
+ * 1 + 2/_dMin decreases. Returns the number of paths out of these bounds.
+ */
+int testGNCCPSchedule(int nbTests){
+  const double dMin = 0.01, dMax = 0.5; // defaults of GNCCPGraphEditDistance
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  GNCCPGraphEditDistance<int,int> gnccp(&cf, &bipartite);
+  gnccp.adaptiveSchedule();
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    SymbolicGraph * g1 = randomGraph(5 + rand()%15, 0.3);
+    SymbolicGraph * g2 = randomGraph(5 + rand()%15, 0.3);
+    gnccp(g1, g2);
+    const std::vector<double> & zetas = gnccp.getZetas();
+    bool valid = ((int)zetas.size() == gnccp.getNbSteps()) && zetas.front() == 1;
+    int nbDecreases = 0;
+    for (unsigned int k=1; k<zetas.size(); k++){
+      // Backtracks go up, back to the last accepted zeta minus a smaller step
+      if (zetas[k] >= zetas[k-1]) continue;
+      nbDecreases++;
+      double d = zetas[k-1] - zetas[k];
+      if (d > dMax + 1e-12 || (d < dMin - 1e-12 && zetas[k] != -1)) valid = false;
+    }
+    if (zetas.back() == -1)
+      valid = valid && nbDecreases >= ceil(2/dMax) && nbDecreases <= ceil(2/dMin);
+    else
+      valid = valid && gnccp.getTelemetry().converged;
+    if (!valid) nbErrors++;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * Access to the Sinkhorn projection of SinkhornGraphEditDistance
+ */
+class SinkhornProjector: public SinkhornGraphEditDistance<int,int>
+{
+public:
+  SinkhornProjector(EditDistanceCost<int,int> * cf): SinkhornGraphEditDistance<int,int>(cf){}
+  double * project(const double * X, int n, int m){
+    this->_n = n;
+    this->_m = m;
+    this->reserveWorkspace(n, m);
+    memcpy(this->Xk, X, sizeof(double)*(n+1)*(m+1));
+    this->SinkhornProjection();
+    return this->Xk;
+  }
+};
+
+/**
+ * The Sinkhorn projection of positive matrices has the marginals of the error-correcting doubly
+ * stochastic matrices, \f$(1,\ldots,1,m)\f$ on rows and \f$(1,\ldots,1,n)\f$ on columns, and
+ * SinkhornGraphEditDistance does not give larger distances than its bipartite initialization.
+ * Returns the number of failures.
+ */
+int testSinkhorn(int nbTests){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  SinkhornGraphEditDistance<int,int> sinkhorn(&cf, &bipartite);
+  SinkhornProjector projector(&cf);
+  projector.setSinkhornIterations(1000);
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    int n = 1 + rand()%15;
+    int m = 1 + rand()%15;
+    double * X = new double[(n+1)*(m+1)];
+    for (int k=0; k<(n+1)*(m+1); k++) X[k] = 0.01 + (double)rand()/RAND_MAX;
+    double * P = projector.project(X, n, m);
+    double error = 0;
+    for (int i=0; i<=n; i++){
+      double sum = 0;
+      for (int j=0; j<=m; j++) sum += P[sub2ind(i,j,n+1)];
+      error = std::max(error, fabs(sum - ((i<n) ? 1 : m)) / ((i<n) ? 1 : m));
+    }
+    for (int j=0; j<=m; j++){
+      double sum = 0;
+      for (int i=0; i<=n; i++) sum += P[sub2ind(i,j,n+1)];
+      error = std::max(error, fabs(sum - ((j<m) ? 1 : n)) / ((j<m) ? 1 : n));
+    }
+    if (error > 1e-5) nbErrors++;
+    delete [] X;
+
+    SymbolicGraph * g1 = randomGraph(n, 0.3);
+    SymbolicGraph * g2 = randomGraph(m, 0.3);
+    if (sinkhorn(g1, g2) > bipartite(g1, g2) + 1e-9) nbErrors++;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * Mappings of the pairs of graphs, in the order of the pairs, from gen with nbThreads threads
+ */
+std::vector<std::vector<int> > mappingsOfPairs(MappingGenerator<int,int> & gen, int nbThreads,
+                                               std::vector<std::pair<Graph<int,int>*,Graph<int,int>*> > & pairs,
+                                               bool reversed, bool ged){
+#ifdef _OPENMP
+  omp_set_num_threads(nbThreads);
+#endif
+  std::vector<std::vector<int> > result(pairs.size());
+  for (unsigned int q=0; q<pairs.size(); q++){
+    unsigned int p = reversed ? pairs.size()-1-q : q;
+    int size = pairs[p].first->Size() + (ged ? pairs[p].second->Size() : 0);
+    std::list<int*> mappings = gen.getMappings(pairs[p].first, pairs[p].second, 20);
+    for (std::list<int*>::iterator it = mappings.begin(); it != mappings.end(); it++){
+      result[p].insert(result[p].end(), *it, *it + size);
+      delete [] *it;
+    }
+  }
+  return result;
+}
+
+/**
+ * RandomMappings and RandomMappingsGED with the same seed give the same mappings of each pair with
+ * 1 and 4 threads, with the pairs given in both orders, and from a clone. Returns the number of
+ * differences.
+ */
+int testRandomMappings(int nbPairs){
+  std::vector<std::pair<Graph<int,int>*,Graph<int,int>*> > pairs;
+  for (int p=0; p<nbPairs; p++)
+    pairs.push_back(std::make_pair(randomGraph(1 + rand()%15, 0.3), randomGraph(1 + rand()%15, 0.3)));
+#ifdef _OPENMP
+  int nbThreads = omp_get_max_threads();
+#endif
+  int nbErrors = 0;
+  for (int ged=0; ged<2; ged++){
+    MappingGenerator<int,int> * gen = ged ? new RandomMappingsGED<int,int>(7) : new RandomMappings<int,int>(7);
+    MappingGenerator<int,int> * other = ged ? new RandomMappingsGED<int,int>(7) : new RandomMappings<int,int>(7);
+    MappingGenerator<int,int> * clone = other->clone();
+    std::vector<std::vector<int> > ref = mappingsOfPairs(*gen, 1, pairs, false, ged);
+    if (mappingsOfPairs(*other, 4, pairs, true, ged) != ref) nbErrors++;
+    if (mappingsOfPairs(*clone, 4, pairs, false, ged) != ref) nbErrors++;
+    if (mappingsOfPairs(*gen, 2, pairs, true, ged) != ref) nbErrors++;
+    delete gen;
+    delete other;
+    delete clone;
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(nbThreads);
+#endif
+  for (int p=0; p<nbPairs; p++){
+    delete pairs[p].first;
+    delete pairs[p].second;
+  }
+  return nbErrors;
+}
+
+/**
+ * The distances of a cost sweep, i.e. the edit operations of a mapping counted once by
+ * countEditOperations and weighted by each cost vector, against GedFromMapping under each
+ * ConstantEditDistanceCost, on directed and undirected pairs. Returns the number of differences.
+ */
+int testCostSweep(int nbPairs){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  BipartiteGraphEditDistance<int,int> bipartite(&cf);
+  std::vector<std::vector<double> > grid;
+  for (int k=0; k<10; k++){
+    std::vector<double> c(6);
+    for (int i=0; i<6; i++) c[i] = (k%2) ? rand()%6 : (double)rand()/RAND_MAX*5;
+    grid.push_back(c);
+  }
+  int nbErrors = 0;
+  for (int p=0; p<nbPairs; p++){
+    bool directed = p%2;
+    int n = 1 + rand()%15;
+    int m = 1 + rand()%15;
+    SymbolicGraph * g1 = randomGraph(n, 0.3, directed);
+    SymbolicGraph * g2 = randomGraph(m, 0.3, directed);
+    int * G1_to_G2 = new int[n];
+    int * G2_to_G1 = new int[m];
+    bipartite.getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    EditOperationCounts counts = countEditOperations(g1, g2, G1_to_G2, n, G2_to_G1, m);
+    for (unsigned int k=0; k<grid.size(); k++){
+      ConstantEditDistanceCost costs(grid[k][0], grid[k][1], grid[k][2], grid[k][3], grid[k][4], grid[k][5]);
+      BipartiteGraphEditDistance<int,int> ed(&costs);
+      double ged = ed.GedFromMapping(g1, g2, G1_to_G2, n, G2_to_G1, m);
+      if (fabs(counts.cost(&grid[k][0]) - ged) > 1e-9*(1+ged) || fabs(counts.cost(&costs) - ged) > 1e-9*(1+ged))
+        nbErrors++;
+    }
+    delete [] G1_to_G2;
+    delete [] G2_to_G1;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * IPFPGraphEditDistance which checks that each iterate, seen when the line search starts, lies in
+ * \f$[0,1]\f$
+ */
+class IPFPIterates: public IPFPGraphEditDistance<int,int>
+{
+protected:
+  virtual double getBeta(){
+    for (int k=0; k<(this->_n+1)*(this->_m+1); k++)
+      feasible = feasible && this->Xk[k] >= 0 && this->Xk[k] <= 1;
+    return IPFPGraphEditDistance<int,int>::getBeta();
+  }
+public:
+  bool feasible = true;
+  IPFPIterates(EditDistanceCost<int,int> * cf, GraphEditDistance<int,int> * init):
+    IPFPGraphEditDistance<int,int>(cf, init){}
+};
+
+/**
+ * Telemetry of one IPFP run, with integer and real costs : the iterations and the objectives of
+ * the run are recorded, the objective never increases, each iteration makes at most one full or
+ * line search step and solves at least one LSAPE. The iterates stay in the feasible set with the
+ * greedy LSAPE solvers, whose directions may not be descent ones. Returns the number of runs with
+ * a wrong record.
+ */
+int testTelemetry(int nbTests){
+  ConstantEditDistanceCost integerCosts(1,3,3,1,3,3);
+  ConstantEditDistanceCost realCosts(0.7,2.3,1.9,1.3,2.9,3.1);
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    ConstantEditDistanceCost * cf = (t%2) ? &realCosts : &integerCosts;
+    BipartiteGraphEditDistance<int,int> bipartite(cf);
+    IPFPIterates ipfp(cf, &bipartite);
+    ipfp.setMaxIter(30);
+    if (t%4 >= 2) ipfp.lsapeSolver((t%4 == 2) ? LSAPE_GREEDY_ROW : LSAPE_GREEDY_SORT);
+    SymbolicGraph * g1 = randomGraph(5 + rand()%20, 0.3);
+    SymbolicGraph * g2 = randomGraph(5 + rand()%20, 0.3);
+    ipfp(g1, g2);
+    const IPFPTelemetry & telemetry = ipfp.getTelemetry();
+    const std::vector<double> & S = telemetry.objectives;
+    bool valid = ipfp.feasible && telemetry.iterations == ipfp.getNbIterations() && S == ipfp.getObjectives() &&
+      (int)S.size() == telemetry.iterations + 1 &&
+      telemetry.nbFullSteps + telemetry.nbLineSearchSteps <= telemetry.iterations &&
+      telemetry.nbLSAPE >= telemetry.iterations &&
+      (telemetry.converged || telemetry.iterations == 30);
+    for (unsigned int k=1; k<S.size(); k++)
+      valid = valid && S[k] <= S[k-1] + 1e-9*(1+fabs(S[k-1]));
+    if (!valid) nbErrors++;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * Node substitutions cost the distance between the points (label%20, label/20) of the labels
+ */
+class LabelDistanceCost: public EditDistanceCost<int,int>
+{
+public:
+  static void point(int label, double & x, double & y){ x = label%20; y = label/20; }
+  virtual double NodeSubstitutionCost(GNode<int,int> * n1, GNode<int,int> * n2, Graph<int,int> * g1, Graph<int,int> * g2){
+    double x1, y1, x2, y2;
+    point(n1->attr, x1, y1);
+    point(n2->attr, x2, y2);
+    return sqrt((x1-x2)*(x1-x2) + (y1-y2)*(y1-y2));
+  }
+  virtual double NodeDeletionCost(GNode<int,int> * n1, Graph<int,int> * g1){ return 3; }
+  virtual double NodeInsertionCost(GNode<int,int> * n2, Graph<int,int> * g2){ return 3; }
+  virtual double EdgeSubstitutionCost(GEdge<int> * e1, GEdge<int> * e2, Graph<int,int> * g1, Graph<int,int> * g2){
+    return (e1->attr != e2->attr) ? 1 : 0;
+  }
+  virtual double EdgeDeletionCost(GEdge<int> * e1, Graph<int,int> * g1){ return 1; }
+  virtual double EdgeInsertionCost(GEdge<int> * e2, Graph<int,int> * g2){ return 1; }
+  virtual LabelDistanceCost * clone() const { return new LabelDistanceCost(*this); }
+};
+
+/**
+ * LabelDistanceCost whose candidates are searched in a KD-tree
+ */
+class LabelPointCost: public LabelDistanceCost, public PointDistanceCost<int,int>
+{
+public:
+  virtual void nodePoint(GNode<int,int> * v, double & x, double & y) const { point(v->attr, x, y); }
+  virtual double substitutionRadius(double cost) const { return cost; }
+  virtual LabelPointCost * clone() const { return new LabelPointCost(*this); }
+};
+
+/**
+ * Cost of the assignment of the mapping in the dense LSAPE of BipartiteGraphEditDistance
+ */
+class BipartiteAssignmentCost: public BipartiteGraphEditDistance<int,int>
+{
+public:
+  BipartiteAssignmentCost(EditDistanceCost<int,int> * cf): BipartiteGraphEditDistance<int,int>(cf){}
+  double assignmentCost(Graph<int,int> * g1, Graph<int,int> * g2, int * G1_to_G2, int * G2_to_G1){
+    this->computeCostMatrix(g1, g2);
+    return lsapeCost(this->C, g1->Size(), g2->Size(), G1_to_G2, G2_to_G1);
+  }
+};
+
+/**
+ * KDTree2D radius queries against a scan of the points, on grid points with duplicates and points
+ * on the radius. The candidates of usefulCandidates found in the KD-tree against the ones of a
+ * scan of all the pairs, and the assignments of the bipartite LSAPE restricted to the k >= m
+ * cheapest candidates or to the useful ones, which are optimal in the dense LSAPE : the distances
+ * only differ between optimal assignments. Returns the number of differences.
+ */
+int testPointCandidates(int nbTests){
+  LabelDistanceCost scanned;
+  LabelPointCost searched;
+  BipartiteAssignmentCost dense(&searched);
+  BipartiteGraphEditDistance<int,int> top(&searched);
+  BipartiteGraphEditDistance<int,int> useful(&searched);
+  useful.candidates(CANDIDATES_USEFUL);
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    int nbPoints = rand()%60;
+    std::vector<double> x(nbPoints), y(nbPoints);
+    for (int p=0; p<nbPoints; p++){ x[p] = rand()%10; y[p] = rand()%10; }
+    KDTree2D tree(x.data(), y.data(), nbPoints);
+    std::vector<int> near, brute;
+    for (int q=0; q<20; q++){
+      double qx = rand()%12 - 1, qy = rand()%12 - 1;
+      double r = (q%2) ? rand()%4 : (double)rand()/RAND_MAX*4;
+      tree.radiusQuery(qx, qy, r, near);
+      brute.clear();
+      for (int p=0; p<nbPoints; p++)
+        if ((qx-x[p])*(qx-x[p]) + (qy-y[p])*(qy-y[p]) <= r*r) brute.push_back(p);
+      if (near != brute) nbErrors++;
+    }
+
+    int n = 1 + rand()%20;
+    int m = 1 + rand()%20;
+    SymbolicGraph * g1 = randomGraph(n, 0.3);
+    SymbolicGraph * g2 = randomGraph(m, 0.3);
+    for (int i=0; i<n; i++) (*g1)[i]->attr = rand()%400;
+    for (int j=0; j<m; j++) (*g2)[j]->attr = rand()%400;
+    SparseCostMatrix<double> S, Sbrute;
+    S.del.resize(n);
+    S.ins.resize(m);
+    for (int i=0; i<n; i++) S.del[i] = (double)rand()/RAND_MAX*10;
+    for (int j=0; j<m; j++) S.ins[j] = (double)rand()/RAND_MAX*10;
+    Sbrute.del = S.del;
+    Sbrute.ins = S.ins;
+    usefulCandidates(g1, g2, (EditDistanceCost<int,int> *)&searched, S);
+    usefulCandidates(g1, g2, (EditDistanceCost<int,int> *)&scanned, Sbrute);
+    if (S.ptr != Sbrute.ptr || S.col != Sbrute.col || S.cost != Sbrute.cost) nbErrors++;
+
+    top.candidates(CANDIDATES_TOP, m + rand()%3);
+    int * G1_to_G2 = new int[n];
+    int * G2_to_G1 = new int[m];
+    dense.getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    double optimum = dense.assignmentCost(g1, g2, G1_to_G2, G2_to_G1);
+    top.getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    if (fabs(dense.assignmentCost(g1, g2, G1_to_G2, G2_to_G1) - optimum) > 1e-9) nbErrors++;
+    useful.getOptimalMapping(g1, g2, G1_to_G2, G2_to_G1);
+    if (fabs(dense.assignmentCost(g1, g2, G1_to_G2, G2_to_G1) - optimum) > 1e-9) nbErrors++;
+    delete [] G1_to_G2;
+    delete [] G2_to_G1;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+/**
+ * SpectralMappings on pairs of graphs of different sizes, whose embeddings have different
+ * dimensions, down to a single node. Returns the number of pairs without valid mappings.
+ */
+int testSpectral(int nbTests){
+  ConstantEditDistanceCost cf(1,3,3,1,3,3);
+  int nbErrors = 0;
+  for (int t=0; t<nbTests; t++){
+    int n = 1 + rand()%8;
+    int m = 1 + rand()%8;
+    SymbolicGraph * g1 = randomGraph(n, 0.4);
+    SymbolicGraph * g2 = randomGraph(m, 0.4);
+    SpectralMappings<int,int> spectral(&cf, (t%2) ? SPECTRAL_LAPLACIAN : SPECTRAL_ADJACENCY, 1 + t%5);
+    std::list<int*> mappings = spectral.getMappings(g1, g2, 10);
+    bool valid = !mappings.empty();
+    for (std::list<int*>::iterator it = mappings.begin(); it != mappings.end(); it++){
+      valid = valid && isPermutation(*it, n, m);
+      delete [] *it;
+    }
+    if (!valid) nbErrors++;
+    delete g1;
+    delete g2;
+  }
+  return nbErrors;
+}
+
+
+
 int main (int argc, char** argv)
 {
 
+  int nbLSAPEErrors = testLSAPE(1000);
+  cout << "In-tree LSAPE solvers vs hungarianLSAPE : " << nbLSAPEErrors << " mismatches over 1000 random problems" << endl;
+  if (nbLSAPEErrors) return EXIT_FAILURE;
+
+  int nbBatchErrors = testTinyLSAPEBatch(500);
+  cout << "tinyLSAPEBatch on interleaved problems vs hungarianLSAPE : " << nbBatchErrors << " mismatches over 500 batches" << endl;
+  if (nbBatchErrors) return EXIT_FAILURE;
+
+  int nbAuctionErrors = testAuction(300);
+  cout << "auctionLSAPE on real costs : " << nbAuctionErrors << " failures over 300 problems" << endl;
+  if (nbAuctionErrors) return EXIT_FAILURE;
+
+  int nbMultilevelErrors = testMultilevel(50);
+  cout << "MultilevelGraphEditDistance : " << nbMultilevelErrors << " failures over 50 pairs" << endl;
+  if (nbMultilevelErrors) return EXIT_FAILURE;
+
+  int nbSpectralErrors = testSpectral(200);
+  cout << "SpectralMappings on graphs of different sizes : " << nbSpectralErrors << " failures over 200 pairs" << endl;
+  if (nbSpectralErrors) return EXIT_FAILURE;
+
+  int nbUniqueErrors = testUniqueMappings();
+  cout << "UniqueMappings on the symmetries of a benzene : " << nbUniqueErrors << " failures" << endl;
+  if (nbUniqueErrors) return EXIT_FAILURE;
+
+  int nbIsomorphismErrors = testIsomorphismShortcut(200);
+  cout << "IsomorphismShortcut on permuted and relabelled copies : " << nbIsomorphismErrors << " failures over 200 graphs" << endl;
+  if (nbIsomorphismErrors) return EXIT_FAILURE;
+
+  int nbCacheErrors = testResultCache(10);
+  cout << "CachedGraphEditDistance round trip : " << nbCacheErrors << " failures" << endl;
+  if (nbCacheErrors) return EXIT_FAILURE;
+
+  int nbDatasetCacheErrors = testDatasetCache(20);
+  cout << "ChemicalDataset sidecar cache round trip : " << nbDatasetCacheErrors << " failures" << endl;
+  if (nbDatasetCacheErrors) return EXIT_FAILURE;
+
+  int nbServerErrors = testServer(20);
+  cout << "GEDServer requests beside an idle connection : " << nbServerErrors << " failures" << endl;
+  if (nbServerErrors) return EXIT_FAILURE;
+
+  int nbJobErrors = testJobs(20);
+  cout << "GEDJobQueue cancellations and budgets : " << nbJobErrors << " failures over 20 jobs" << endl;
+  if (nbJobErrors) return EXIT_FAILURE;
+
+  int nbQuadraticErrors = testQuadraticTerms(100);
+  cout << "IPFP quadratic terms and sparse iterates : " << nbQuadraticErrors << " failures over 100 pairs" << endl;
+  if (nbQuadraticErrors) return EXIT_FAILURE;
+
+  int nbRowErrors = testRowDistances(20);
+  cout << "IPFP rowDistances vs pair by pair : " << nbRowErrors << " differences over 800 pairs" << endl;
+  if (nbRowErrors) return EXIT_FAILURE;
+
+  int nbZetaErrors = testZetaActiveSet(100);
+  cout << "Away-step and pairwise iterations of GNCCP : " << nbZetaErrors << " increases over 100 paths" << endl;
+  if (nbZetaErrors) return EXIT_FAILURE;
+
+  int nbSequenceErrors = testSequence(8);
+  cout << "IPFP warm starts along a sequence : " << nbSequenceErrors << " failures" << endl;
+  if (nbSequenceErrors) return EXIT_FAILURE;
+
+  int nbReuseErrors = testGNCCPReuse(100);
+  cout << "GNCCP reused across pairs of different sizes : " << nbReuseErrors << " differences over 100 pairs" << endl;
+  if (nbReuseErrors) return EXIT_FAILURE;
+
+  int nbScheduleErrors = testGNCCPSchedule(100);
+  cout << "Adaptive zeta schedule of GNCCP : " << nbScheduleErrors << " paths out of bounds over 100 pairs" << endl;
+  if (nbScheduleErrors) return EXIT_FAILURE;
+
+  int nbSinkhornErrors = testSinkhorn(100);
+  cout << "SinkhornGraphEditDistance projections and distances : " << nbSinkhornErrors << " failures over 100 pairs" << endl;
+  if (nbSinkhornErrors) return EXIT_FAILURE;
+
+  int nbRandomErrors = testRandomMappings(50);
+  cout << "RandomMappings with 1 and 4 threads, pairs in both orders : " << nbRandomErrors << " differences" << endl;
+  if (nbRandomErrors) return EXIT_FAILURE;
+
+  int nbSweepErrors = testCostSweep(100);
+  cout << "Cost sweep vs GedFromMapping : " << nbSweepErrors << " differences over 100 pairs and 10 costs" << endl;
+  if (nbSweepErrors) return EXIT_FAILURE;
+
+  int nbTelemetryErrors = testTelemetry(100);
+  cout << "IPFP telemetry of a run : " << nbTelemetryErrors << " wrong records over 100 pairs" << endl;
+  if (nbTelemetryErrors) return EXIT_FAILURE;
+
+  int nbPointErrors = testPointCandidates(200);
+  cout << "KD-tree and candidates of point costs vs brute force : " << nbPointErrors << " differences over 200 tests" << endl;
+  if (nbPointErrors) return EXIT_FAILURE;
+
   
   ConstantEditDistanceCost * cf = new ConstantEditDistanceCost(1,3,3,1,3,3);
   